@@ -1425,6 +1425,15 @@ static const size_t re_error_msgid_idx[] =
 #  define INIT_FAILURE_ALLOC 5
 # endif
 
+# ifndef DEFINED_ONCE
+/* The most times a match may fall back to a failure point before
+   the matching functions give up and return -2, or 0 for no limit.
+   re_backtracks counts them and is never reset by regex itself, so
+   a caller can set a budget for any number of calls.  */
+long int re_max_backtracks = 0;
+long int re_backtracks = 0;
+# endif
+
 /* Roughly the maximum number of failure points on the stack.  Would be
    exactly that if always used MAX_FAILURE_ITEMS items each time we failed.
    This is a variable only so users of regex can assign to it; we never
@@ -2061,7 +2070,7 @@ static reg_errcode_t byte_compile_range (unsigned int range_start,
     /* If the buffer moved, move all the pointers into it.  */		\
     if (old_buffer != COMPILED_BUFFER_VAR)				\
       {									\
-	int incr = COMPILED_BUFFER_VAR - old_buffer;			\
+	ptrdiff_t incr = COMPILED_BUFFER_VAR - old_buffer;		\
 	MOVE_BUFFER_POINTER (b);					\
 	MOVE_BUFFER_POINTER (begalt);					\
 	if (fixup_alt_jump)						\
@@ -2089,7 +2098,7 @@ static reg_errcode_t byte_compile_range (unsigned int range_start,
     /* If the buffer moved, move all the pointers into it.  */		\
     if (old_buffer != COMPILED_BUFFER_VAR)				\
       {									\
-	int incr = COMPILED_BUFFER_VAR - old_buffer;			\
+	ptrdiff_t incr = COMPILED_BUFFER_VAR - old_buffer;		\
 	MOVE_BUFFER_POINTER (b);					\
 	MOVE_BUFFER_POINTER (begalt);					\
 	if (fixup_alt_jump)						\
@@ -7525,6 +7534,11 @@ byte_re_match_2_internal (struct re_pattern_buffer *bufp,
     fail:
       if (!FAIL_STACK_EMPTY ())
 	{ /* A restart point is known.  Restore to that state.  */
+          if (re_max_backtracks > 0 && ++re_backtracks > re_max_backtracks)
+            {
+              FREE_VARIABLES ();
+              return -2;
+            }
           DEBUG_PRINT1 ("\nFAIL:\n");
           POP_FAILURE_POINT (d, p,
                              lowest_active_reg, highest_active_reg,
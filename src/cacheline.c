@@ -22,11 +22,20 @@
 #include <stdbool.h>		/* Gnulib/C99/POSIX */
 #include <stdlib.h>		/* C89 */
 #include <stdio.h>		/* C89 */
+#include <errno.h>		/* C89 */
+#include <unistd.h>		/* POSIX */
+#include <fcntl.h>		/* POSIX */
+#include <sys/stat.h>		/* POSIX */
+#ifdef HAVE_SPLICE
+#include <sys/ioctl.h>		/* POSIX */
+#endif
 #include "gettext.h"		/* Gnulib */
 #define _(String) gettext(String)
-#include "getline.h"		/* Gnulib/GNU Libc */
 #include "version-etc.h"	/* Gnulib */
 
+/* Size of blocks read from standard in. */
+#define BLOCK_SIZE 65536
+
 enum {
     HELP_OPT = 256,
     VERSION_OPT
@@ -40,12 +49,143 @@ static struct option long_opts[] = {
 
 const char version_etc_copyright[] = "Copyright (C) 2001-2005 Oskar Liljeblad";
 
+static const char *program_name;
+/* True if the last byte read was a newline that has not been written. */
+static bool keep = false;
+
+static void
+write_all(const char *buf, size_t len)
+{
+    while (len > 0) {
+	ssize_t written = write(STDOUT_FILENO, buf, len);
+	if (written < 0) {
+	    if (errno == EINTR)
+		continue;
+	    perror(program_name);
+	    exit(1);
+	}
+	buf += written;
+	len -= written;
+    }
+}
+
+/* Copy standard in to standard out a block at a time. The block is
+ * read after room for a kept newline, so that the kept newline and the
+ * block can be written together.
+ */
+static void
+copy_blocks(void)
+{
+    static char buf[BLOCK_SIZE+1];
+
+    for (;;) {
+	char *start = buf+1;
+	ssize_t len;
+
+	len = read(STDIN_FILENO, start, BLOCK_SIZE);
+	if (len < 0) {
+	    if (errno == EINTR)
+		continue;
+	    perror(program_name);
+	    exit(1);
+	}
+	if (len == 0)
+	    break;
+
+	if (keep) {
+	    *--start = '\n';
+	    len++;
+	    keep = false;
+	}
+	if (start[len-1] == '\n') {
+	    keep = true;
+	    len--;
+	}
+	write_all(start, len);
+    }
+}
+
+#ifdef HAVE_SPLICE
+/* Move data from one pipe to another without copying it through user
+ * space. Everything but the last byte waiting in standard in is
+ * spliced, and the last byte is read to see if it is a newline to
+ * keep. Returns false without moving anything if splicing cannot be
+ * done.
+ */
+static bool
+splice_blocks(void)
+{
+    bool moved = false;
+
+    for (;;) {
+	int avail;
+	char buf[2];
+	ssize_t len;
+
+	if (ioctl(STDIN_FILENO, FIONREAD, &avail) < 0) {
+	    if (!moved)
+		return false;
+	    perror(program_name);
+	    exit(1);
+	}
+
+	if (avail > 1) {
+	    if (keep) {
+		write_all("\n", 1);
+		keep = false;
+	    }
+	    len = splice(STDIN_FILENO, NULL, STDOUT_FILENO, NULL, avail-1, SPLICE_F_MOVE);
+	    if (len < 0) {
+		if (errno == EINTR)
+		    continue;
+		if (!moved && errno == EINVAL)
+		    return false;
+		perror(program_name);
+		exit(1);
+	    }
+	    moved = true;
+	    continue;
+	}
+
+	/* Wait for more input, or read the last byte waiting. */
+	len = read(STDIN_FILENO, buf+1, 1);
+	if (len < 0) {
+	    if (errno == EINTR)
+		continue;
+	    perror(program_name);
+	    exit(1);
+	}
+	if (len == 0)
+	    return true;
+	moved = true;
+
+	len = 0;
+	if (keep) {
+	    buf[len++] = '\n';
+	    keep = false;
+	}
+	if (buf[1] == '\n')
+	    keep = true;
+	else
+	    buf[len++] = buf[1];
+	write_all(buf, len);
+    }
+}
+
+static bool
+is_pipe(int fd)
+{
+    struct stat sb;
+
+    return fstat(fd, &sb) == 0 && S_ISFIFO(sb.st_mode)
+	&& (fcntl(fd, F_GETFL) & O_APPEND) == 0;
+}
+#endif
+
 int
 main(int argc, char **argv)
 {
-    char *buf = NULL;
-    size_t buflen = 0;
-    bool keep = false;
+    program_name = argv[0];
 
     setlocale(LC_ALL, "");
     bindtextdomain(PACKAGE, LOCALEDIR);
@@ -73,31 +213,12 @@ main(int argc, char **argv)
         }
     }
 
-    for (;;) {
-        ssize_t linelen;
-
-        linelen = getline(&buf, &buflen, stdin);
-        if (linelen < 0) {
-	    if (ferror(stdin)) {
-	    	perror(argv[0]);
-	    	exit(1);
-	    }
-	    break;
-	}
+#ifdef HAVE_SPLICE
+    if (!is_pipe(STDIN_FILENO) || !is_pipe(STDOUT_FILENO) || !splice_blocks())
+	copy_blocks();
+#else
+    copy_blocks();
+#endif
 
-	if (linelen > 0) {
-	    if (keep) {
-	    	fputc('\n', stdout);
-		keep = false;
-	    }
-	    if (buf[linelen-1] == '\n') {
-	    	keep = true;
-	    	linelen--;
-	    }
-	    fwrite(buf, linelen, 1, stdout);
-	    fflush(stdout);
-	}
-    }
-    
     exit(0);
 }
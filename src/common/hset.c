@@ -0,0 +1,260 @@
+/* hset.c - A bounded hash set of strings
+ *
+ * Copyright (C) 2004-2005 Oskar Liljeblad
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/* Unlike HMap, a HSet never grows. It uses open addressing with
+ * linear probing in a slot table of at least twice the capacity, and
+ * when full, the least recently added or looked up key is evicted.
+ * Keys are counted strings, so lookups need no allocation.
+ */
+
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hset.h"
+#include "xalloc.h"
+
+#define NO_ENTRY    UINT32_MAX
+
+typedef struct _HSetEntry HSetEntry;
+
+struct _HSetEntry {
+    char *key;
+    uint32_t len;
+    uint32_t hash;
+    uint32_t slot;
+    uint32_t prev;          /* more recently used */
+    uint32_t next;          /* less recently used, or next free */
+};
+
+struct _HSet {
+    uint32_t *slots;
+    uint32_t slots_mask;
+    HSetEntry *entries;
+    uint32_t capacity;
+    uint32_t size;
+    uint32_t first;         /* most recently used */
+    uint32_t last;          /* least recently used */
+    uint32_t free;
+};
+
+static uint32_t
+memhash(const char *key, size_t len)
+{
+    uint32_t hash = 2166136261U;
+
+    for (; len > 0; key++, len--)
+	hash = (hash ^ (unsigned char) *key) * 16777619U;
+
+    return hash;
+}
+
+static void
+unlink_entry(HSet *set, uint32_t e)
+{
+    HSetEntry *entry = &set->entries[e];
+
+    if (entry->prev == NO_ENTRY)
+	set->first = entry->next;
+    else
+	set->entries[entry->prev].next = entry->next;
+    if (entry->next == NO_ENTRY)
+	set->last = entry->prev;
+    else
+	set->entries[entry->next].prev = entry->prev;
+}
+
+static void
+link_first(HSet *set, uint32_t e)
+{
+    HSetEntry *entry = &set->entries[e];
+
+    entry->prev = NO_ENTRY;
+    entry->next = set->first;
+    if (set->first == NO_ENTRY)
+	set->last = e;
+    else
+	set->entries[set->first].prev = e;
+    set->first = e;
+}
+
+/* Return the slot holding key, or the empty slot where it belongs. */
+static uint32_t
+find_slot(HSet *set, const char *key, size_t len, uint32_t hash)
+{
+    uint32_t slot = hash & set->slots_mask;
+
+    for (;;) {
+	uint32_t e = set->slots[slot];
+	if (e == NO_ENTRY)
+	    return slot;
+	if (set->entries[e].hash == hash && set->entries[e].len == len
+		&& memcmp(set->entries[e].key, key, len) == 0)
+	    return slot;
+	slot = (slot + 1) & set->slots_mask;
+    }
+}
+
+/* Empty a slot, moving later entries of the same probe sequence back
+ * so that no tombstones are needed.
+ */
+static void
+delete_slot(HSet *set, uint32_t slot)
+{
+    uint32_t next = slot;
+
+    for (;;) {
+	uint32_t home;
+	uint32_t e;
+
+	next = (next + 1) & set->slots_mask;
+	e = set->slots[next];
+	if (e == NO_ENTRY)
+	    break;
+	home = set->entries[e].hash & set->slots_mask;
+	if (((next - home) & set->slots_mask) >= ((next - slot) & set->slots_mask)) {
+	    set->slots[slot] = e;
+	    set->entries[e].slot = slot;
+	    slot = next;
+	}
+    }
+    set->slots[slot] = NO_ENTRY;
+}
+
+static void
+delete_entry(HSet *set, uint32_t e)
+{
+    HSetEntry *entry = &set->entries[e];
+
+    delete_slot(set, entry->slot);
+    unlink_entry(set, e);
+    free(entry->key);
+    entry->key = NULL;
+    entry->next = set->free;
+    set->free = e;
+    set->size--;
+}
+
+HSet *
+hset_new(uint32_t capacity)
+{
+    HSet *set;
+    uint32_t slots = 2;
+    uint32_t c;
+
+    while (slots < capacity * 2)
+	slots *= 2;
+
+    set = xmalloc(sizeof(HSet));
+    set->slots = xmalloc(slots * sizeof(uint32_t));
+    set->slots_mask = slots - 1;
+    set->entries = xmalloc(capacity * sizeof(HSetEntry));
+    set->capacity = capacity;
+    for (c = 0; c < slots; c++)
+	set->slots[c] = NO_ENTRY;
+    for (c = 0; c < capacity; c++) {
+	set->entries[c].key = NULL;
+	set->entries[c].next = (c+1 < capacity ? c+1 : NO_ENTRY);
+    }
+    set->free = (capacity > 0 ? 0 : NO_ENTRY);
+    set->first = NO_ENTRY;
+    set->last = NO_ENTRY;
+    set->size = 0;
+
+    return set;
+}
+
+void
+hset_free(HSet *set)
+{
+    if (set != NULL) {
+	hset_clear(set);
+	free(set->slots);
+	free(set->entries);
+	free(set);
+    }
+}
+
+bool
+hset_contains(HSet *set, const char *key, size_t len)
+{
+    uint32_t e = set->slots[find_slot(set, key, len, memhash(key, len))];
+
+    if (e == NO_ENTRY)
+	return false;
+    unlink_entry(set, e);
+    link_first(set, e);
+    return true;
+}
+
+void
+hset_add(HSet *set, const char *key, size_t len)
+{
+    uint32_t hash = memhash(key, len);
+    uint32_t slot = find_slot(set, key, len, hash);
+    HSetEntry *entry;
+    uint32_t e = set->slots[slot];
+
+    if (e != NO_ENTRY) {
+	unlink_entry(set, e);
+	link_first(set, e);
+	return;
+    }
+    if (set->capacity == 0)
+	return;
+
+    if (set->free == NO_ENTRY) {
+	delete_entry(set, set->last);
+	slot = find_slot(set, key, len, hash);
+    }
+    e = set->free;
+    entry = &set->entries[e];
+    set->free = entry->next;
+
+    entry->key = xmemdup(key, len);
+    entry->len = len;
+    entry->hash = hash;
+    entry->slot = slot;
+    set->slots[slot] = e;
+    link_first(set, e);
+    set->size++;
+}
+
+bool
+hset_remove(HSet *set, const char *key, size_t len)
+{
+    uint32_t e = set->slots[find_slot(set, key, len, memhash(key, len))];
+
+    if (e == NO_ENTRY)
+	return false;
+    delete_entry(set, e);
+    return true;
+}
+
+void
+hset_clear(HSet *set)
+{
+    while (set->first != NO_ENTRY)
+	delete_entry(set, set->first);
+}
+
+uint32_t
+hset_size(HSet *set)
+{
+    return set->size;
+}
@@ -0,0 +1,37 @@
+/* hset.h - A bounded hash set of strings
+ *
+ * Copyright (C) 2004-2005 Oskar Liljeblad
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef COMMON_HSET_H
+#define COMMON_HSET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct _HSet HSet;
+
+HSet *hset_new(uint32_t capacity);
+void hset_free(HSet *set);
+bool hset_contains(HSet *set, const char *key, size_t len);
+void hset_add(HSet *set, const char *key, size_t len);
+bool hset_remove(HSet *set, const char *key, size_t len);
+void hset_clear(HSet *set);
+uint32_t hset_size(HSet *set);
+
+#endif
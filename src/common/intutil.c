@@ -274,3 +274,38 @@ parse_uint64(const char *instr, uint64_t *outint)
 
 	return true;
 }
+
+/* Parse a decimal number with optional sign and fraction from the
+ * first len characters of instr. Unlike strtod, the decimal point is
+ * always `.' regardless of locale.
+ */
+bool
+parse_decimal(const char *instr, size_t len, double *outval)
+{
+	const char *end = instr + len;
+	bool negative = false;
+	double value = 0;
+	double scale = 1;
+
+	if (instr < end && (*instr == '-' || *instr == '+')) {
+		negative = (*instr == '-');
+		instr++;
+	}
+	if (instr == end || *instr < '0' || *instr > '9')
+		return false;
+	for (; instr < end && *instr >= '0' && *instr <= '9'; instr++)
+		value = value*10 + (*instr - '0');
+	if (instr < end && *instr == '.') {
+		if (++instr == end)
+			return false;
+		for (; instr < end && *instr >= '0' && *instr <= '9'; instr++) {
+			scale /= 10;
+			value += scale * (*instr - '0');
+		}
+	}
+	if (instr != end)
+		return false;
+	*outval = (negative ? -value : value);
+
+	return true;
+}
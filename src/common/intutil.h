@@ -23,6 +23,7 @@
 
 #include <stdbool.h>	/* Gnulib, C99, POSIX */
 #include <stdint.h>	/* Gnulib, C99, POSIX */
+#include <stddef.h>	/* C89 */
 
 char *uint64_str(uint64_t value);
 char *uint32_str(uint32_t value);
@@ -41,5 +42,6 @@ bool parse_uint8(const char *instr, uint8_t *outint);
 bool parse_uint16(const char *instr, uint16_t *outint);
 bool parse_uint32(const char *instr, uint32_t *outint);
 bool parse_uint64(const char *instr, uint64_t *outint);
+bool parse_decimal(const char *instr, size_t len, double *outval);
 
 #endif
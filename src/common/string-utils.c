@@ -25,6 +25,7 @@
 #include <stdio.h>		/* C89 */
 #include <string.h>		/* C89 */
 #include <stdlib.h>		/* C89 */
+#include <stdint.h>		/* POSIX/gnulib */
 #include "xalloc.h"		/* Gnulib */
 #include "strndup.h"		/* Gnulib */
 #include "xvasprintf.h"		/* Gnulib */
@@ -462,3 +463,189 @@ xdirname(const char *path)
 
 	return substring(path, 0, pos-path);
 }
+
+#define WORD_ONES	((uint64_t) 0x0101010101010101ULL)
+#define WORD_HIGHS	(WORD_ONES * 0x80)
+#define ASCII_TOLOWER(c) ((c) >= 'A' && (c) <= 'Z' ? (c) + ('a'-'A') : (c))
+
+/* Convert all ASCII upper case letters in a 64-bit word (eight
+ * bytes) to lower case, leaving every other byte untouched.
+ */
+static inline uint64_t
+ascii_fold_word(uint64_t x)
+{
+	uint64_t heptets = x & ~WORD_HIGHS;
+	uint64_t above_z = heptets + WORD_ONES * (0x80 - 'Z' - 1);
+	uint64_t from_a = heptets + WORD_ONES * (0x80 - 'A');
+	uint64_t upper = (from_a ^ above_z) & ~x & WORD_HIGHS;
+
+	return x | (upper >> 2);
+}
+
+/* Convert ASCII letters in a memory area to lower case.
+ */
+void
+memcasefold(void *mem, size_t len)
+{
+	unsigned char *p = mem;
+
+	for (; len > 0; p++, len--)
+		*p = ASCII_TOLOWER(*p);
+}
+
+static bool
+memcaseeq(const unsigned char *s, const unsigned char *folded, size_t len)
+{
+	for (; len >= 8; s += 8, folded += 8, len -= 8) {
+		uint64_t a;
+		uint64_t b;
+		memcpy(&a, s, 8);
+		memcpy(&b, folded, 8);
+		if (ascii_fold_word(a) != b)
+			return false;
+	}
+	for (; len > 0; s++, folded++, len--) {
+		if (ASCII_TOLOWER(*s) != *folded)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Find the first occurrence of a byte string in a memory area,
+ * ignoring case of ASCII letters. The haystack is scanned eight
+ * bytes at a time for the first needle character.
+ *
+ * @param needle
+ *   The string to look for. This must already have been
+ *   folded to lower case with memcasefold.
+ * @return
+ *   A pointer to the first match in haystack, or NULL.
+ */
+void *
+memcasemem(const void *haystack, size_t hlen, const void *needle, size_t nlen)
+{
+	const unsigned char *h = haystack;
+	const unsigned char *n = needle;
+	uint64_t first;
+	size_t last;
+	size_t c;
+
+	if (nlen == 0)
+		return (void *) h;
+	if (nlen > hlen)
+		return NULL;
+
+	last = hlen - nlen;
+	first = WORD_ONES * n[0];
+	for (c = 0; c + 7 <= last; c += 8) {
+		uint64_t x;
+		int d;
+
+		memcpy(&x, h+c, 8);
+		x = ascii_fold_word(x) ^ first;
+		if (((x - WORD_ONES) & ~x & WORD_HIGHS) == 0)
+			continue;
+		for (d = 0; d < 8; d++) {
+			if (ASCII_TOLOWER(h[c+d]) == n[0] && memcaseeq(h+c+d+1, n+1, nlen-1))
+				return (void *) (h+c+d);
+		}
+	}
+	for (; c <= last; c++) {
+		if (ASCII_TOLOWER(h[c]) == n[0] && memcaseeq(h+c+1, n+1, nlen-1))
+			return (void *) (h+c);
+	}
+
+	return NULL;
+}
+
+/**
+ * Find the first byte in a memory area that lies in the range
+ * [lo, hi]. Eight bytes are classified at a time. Both lo and hi
+ * must be in the range 1 to 127.
+ *
+ * @return
+ *   A pointer to the first byte in range, or NULL.
+ */
+void *
+memrange(const void *mem, size_t len, unsigned char lo, unsigned char hi)
+{
+	const unsigned char *p = mem;
+	uint64_t below = WORD_ONES * (127 + hi + 1);
+	uint64_t above = WORD_ONES * (127 - (lo - 1));
+
+	for (; len >= 8; p += 8, len -= 8) {
+		uint64_t x;
+		uint64_t v;
+
+		memcpy(&x, p, 8);
+		v = x & ~WORD_HIGHS;
+		if (((below - v) & ~x & (v + above) & WORD_HIGHS) != 0)
+			break;
+	}
+	for (; len > 0; p++, len--) {
+		if (*p >= lo && *p <= hi)
+			return (void *) p;
+	}
+
+	return NULL;
+}
+
+/**
+ * Check whether a memory area holds only ASCII characters. The
+ * high bits of 32 bytes are collected before each test.
+ *
+ * @return
+ *   true if no byte has the high bit set.
+ */
+bool
+memascii(const void *mem, size_t len)
+{
+	const unsigned char *p = mem;
+
+	for (; len >= 32; p += 32, len -= 32) {
+		uint64_t x[4];
+
+		memcpy(x, p, 32);
+		if (((x[0] | x[1] | x[2] | x[3]) & WORD_HIGHS) != 0)
+			return false;
+	}
+	for (; len > 0; p++, len--) {
+		if (*p & 0x80)
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Count the occurrences of a byte in a memory area. Matching bytes
+ * are found in eight bytes at a time and counted with a multiply.
+ *
+ * @return
+ *   the number of bytes equal to ch.
+ */
+size_t
+memcount(const void *mem, size_t len, unsigned char ch)
+{
+	const unsigned char *p = mem;
+	uint64_t pattern = WORD_ONES * ch;
+	uint64_t lows = ~WORD_HIGHS;
+	size_t count = 0;
+
+	for (; len >= 8; p += 8, len -= 8) {
+		uint64_t x;
+
+		memcpy(&x, p, 8);
+		x ^= pattern;
+		/* The high bit of each byte is now clear for matches only. */
+		x = ((x & lows) + lows) | x;
+		count += (((~x & WORD_HIGHS) >> 7) * WORD_ONES) >> 56;
+	}
+	for (; len > 0; p++, len--) {
+		if (*p == ch)
+			count++;
+	}
+
+	return count;
+}
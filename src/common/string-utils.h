@@ -60,6 +60,12 @@ char *word_get(const char *str, int idx);
 int uintlen(uint64_t value);
 char *xdirname(const char *path);
 
+void memcasefold(void *mem, size_t len);
+void *memcasemem(const void *haystack, size_t hlen, const void *needle, size_t nlen);
+void *memrange(const void *mem, size_t len, unsigned char lo, unsigned char hi);
+bool memascii(const void *mem, size_t len);
+size_t memcount(const void *mem, size_t len, unsigned char ch);
+
 bool ends_with_nocase(const char *str, const char *end);
 bool starts_with_nocase(const char *str, const char *start);
 
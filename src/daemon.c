@@ -0,0 +1,493 @@
+/* daemon.c - Serving highlighting to clients over a Unix socket.
+ *
+ * Copyright (C) 2001-2005 Oskar Liljeblad
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/* A client sends a header and then its input, and reads the highlighted
+ * output back over the same connection. The header is its length in
+ * decimal and a newline, followed by NUL-terminated strings: the working
+ * directory of the client, the rule file (empty for none) and all
+ * arguments the client was started with. The daemon answers `ok' and a
+ * newline if it could load the rule file, or `error' and a newline if
+ * not, in which case the client highlights the input itself.
+ */
+
+#include <config.h>
+#include <stdlib.h>		/* C89 */
+#include <string.h>		/* C89 */
+#include <errno.h>		/* C89 */
+#include <signal.h>		/* C89 */
+#include <stdio.h>		/* C89 */
+#include <sys/types.h>		/* POSIX */
+#include <sys/stat.h>		/* POSIX */
+#include <sys/socket.h>		/* POSIX */
+#include <sys/un.h>		/* POSIX */
+#include <fcntl.h>		/* POSIX */
+#include <poll.h>		/* POSIX */
+#include <unistd.h>		/* POSIX */
+#include "xalloc.h"		/* Gnulib */
+#include "xvasprintf.h"		/* Gnulib */
+#include "gettext.h"		/* Gnulib */
+#define _(String) gettext(String)
+#include "common/error.h"
+#include "common/hmap.h"
+#include "common/intutil.h"
+#include "common/strbuf.h"
+#include "common/string-utils.h"
+#include "remark.h"
+
+/* Size of blocks passed between client and daemon. */
+#define DAEMON_BLOCK_SIZE	65536
+/* Largest header accepted from a client. */
+#define DAEMON_MAX_HEADER	65536
+/* Longest time in milliseconds a client may take to send its header. */
+#define DAEMON_HEADER_TIMEOUT	2000
+
+typedef struct _WarmScript WarmScript;
+
+struct _WarmScript {
+	RemarkScript *script;
+	dev_t dev;
+	ino_t ino;
+	time_t mtime;
+};
+
+static int listen_fd = -1;
+
+static bool
+write_fully(int fd, const char *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t written = write(fd, buf, len);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		buf += written;
+		len -= written;
+	}
+	return true;
+}
+
+static bool
+read_fully(int fd, char *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t got = read(fd, buf, len);
+		if (got < 0 && errno == EINTR)
+			continue;
+		if (got <= 0)
+			return false;
+		buf += got;
+		len -= got;
+	}
+	return true;
+}
+
+/* Like read_fully, but give up at deadline (in current_millis time). */
+static bool
+read_until(int fd, char *buf, size_t len, int64_t deadline)
+{
+	struct pollfd pfd;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	while (len > 0) {
+		int64_t left = deadline - current_millis();
+		ssize_t got;
+
+		if (left <= 0)
+			return false;
+		if (poll(&pfd, 1, left) < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		if ((pfd.revents & (POLLIN|POLLHUP|POLLERR)) == 0)
+			continue;
+		got = read(fd, buf, len);
+		if (got < 0 && errno == EINTR)
+			continue;
+		if (got <= 0)
+			return false;
+		buf += got;
+		len -= got;
+	}
+	return true;
+}
+
+static char *
+current_directory(void)
+{
+	size_t size = 256;
+
+	for (;;) {
+		char *dir = xmalloc(size);
+		if (getcwd(dir, size) != NULL)
+			return dir;
+		free(dir);
+		if (errno != ERANGE)
+			die_errno(_("cannot get current directory"));
+		size *= 2;
+	}
+}
+
+static int
+socket_address(const char *socket_file, struct sockaddr_un *addr)
+{
+	if (strlen(socket_file) >= sizeof(addr->sun_path))
+		die(_("socket name too long: %s"), socket_file);
+	memset(addr, 0, sizeof(struct sockaddr_un));
+	addr->sun_family = AF_UNIX;
+	strcpy(addr->sun_path, socket_file);
+	return socket(AF_UNIX, SOCK_STREAM, 0);
+}
+
+/* Read a header from a client. The length is read a byte at a time so
+ * that no input following the header is consumed. Headers are read
+ * before the daemon forks, so that it keeps the scripts it loads, and
+ * a client that does not send all of its header in time is dropped
+ * rather than keeping the others waiting.
+ */
+static char *
+read_header(int fd, uint32_t *len)
+{
+	int64_t deadline = current_millis() + DAEMON_HEADER_TIMEOUT;
+	char digits[16];
+	char *header;
+	uint32_t c;
+
+	for (c = 0; c < sizeof(digits)-1; c++) {
+		if (!read_until(fd, &digits[c], 1, deadline))
+			return NULL;
+		if (digits[c] == '\n')
+			break;
+	}
+	digits[c] = '\0';
+	if (c == sizeof(digits)-1 || !parse_uint32(digits, len) || *len == 0 || *len > DAEMON_MAX_HEADER)
+		return NULL;
+
+	header = xmalloc(*len);
+	if (!read_until(fd, header, *len, deadline) || header[*len-1] != '\0') {
+		free(header);
+		return NULL;
+	}
+	return header;
+}
+
+/* All regexes are compiled right away, so that errors in them are
+ * found too and clients never have to compile them. A rule file with
+ * errors is reported and not used.
+ */
+static RemarkScript *
+load_script(const char *rules)
+{
+	RemarkScript *script;
+	char *error;
+
+	script = read_script(rules, false, &error);
+	if (script == NULL) {
+		warn("%s", error);
+		free(error);
+	}
+	return script;
+}
+
+/* Find a rule file where the parser would: relative to the directory
+ * of the client, in ~/.remark or in the system-wide rule directory.
+ */
+static char *
+find_rules(const char *dir, const char *rules)
+{
+	const char *home = getenv("HOME");
+	struct stat sb;
+	char *path;
+
+	if (*rules == '/')
+		return xstrdup(rules);
+	path = cat_files(dir, rules);
+	if (stat(path, &sb) == 0)
+		return path;
+	free(path);
+	if (home != NULL) {
+		char *userdir = cat_files(home, PKGUSERDIR);
+		path = cat_files(userdir, rules);
+		free(userdir);
+		if (stat(path, &sb) == 0)
+			return path;
+		free(path);
+	}
+	return cat_files(PKGDATADIR, rules);
+}
+
+/* Find the compiled script for a rule file, loading it again if the
+ * file has changed since it was last loaded. Changes to included files
+ * are not noticed.
+ */
+static RemarkScript *
+warm_script(HMap *scripts, const char *rules)
+{
+	WarmScript *warm = hmap_get(scripts, rules);
+	struct stat sb;
+
+	if (stat(rules, &sb) < 0)
+		return NULL;
+	if (warm != NULL) {
+		if (warm->dev == sb.st_dev && warm->ino == sb.st_ino && warm->mtime == sb.st_mtime)
+			return warm->script;
+		if (warm->script != NULL)
+			free_script(warm->script);
+	} else {
+		warm = xmalloc(sizeof(WarmScript));
+		warm->script = NULL;
+		hmap_put(scripts, xstrdup(rules), warm);
+	}
+
+	warm->script = load_script(rules);
+	warm->dev = sb.st_dev;
+	warm->ino = sb.st_ino;
+	warm->mtime = sb.st_mtime;
+	if (warm->script == NULL)
+		warm->mtime = (time_t) -1;
+	return warm->script;
+}
+
+/* Handle a new connection. The highlighting itself is done in a child
+ * process, which shares the compiled scripts with the daemon.
+ */
+static void
+accept_client(int fd, HMap *scripts, RemarkScript *empty_script, DaemonHandler handler)
+{
+	RemarkScript *script;
+	char *header;
+	char *rules;
+	char **args;
+	uint32_t len;
+	uint32_t count;
+	uint32_t c;
+	char *p;
+	pid_t pid;
+
+	header = read_header(fd, &len);
+	if (header == NULL)
+		return;
+
+	/* The header is the directory, the rule file, and the arguments. */
+	for (count = 0, p = header; p < header+len; p += strlen(p)+1)
+		count++;
+	if (count < 2) {
+		free(header);
+		return;
+	}
+	rules = header + strlen(header) + 1;
+	if (*rules == '\0') {
+		script = empty_script;
+	} else {
+		char *path = find_rules(header, rules);
+		script = warm_script(scripts, path);
+		free(path);
+	}
+	if (script == NULL) {
+		write_fully(fd, "error\n", 6);
+		free(header);
+		return;
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		warn_errno(_("cannot create process"));
+		write_fully(fd, "error\n", 6);
+	} else if (pid == 0) {
+		close(listen_fd);
+		signal(SIGPIPE, SIG_DFL);
+		args = xmalloc((count-1) * sizeof(char *));
+		p = rules + strlen(rules) + 1;
+		for (c = 0; c < count-2; c++, p += strlen(p)+1)
+			args[c] = p;
+		args[c] = NULL;
+		if (chdir(header) < 0 || !write_fully(fd, "ok\n", 3))
+			_exit(1);
+		if (dup2(fd, STDOUT_FILENO) < 0)
+			_exit(1);
+		handler(fd, script, count-2, args);
+		_exit(0);
+	}
+	free(header);
+}
+
+/**
+ * Serve highlighting to clients connecting to a Unix socket, until
+ * terminated. For each client, handler is called in a child process
+ * with the connection (which is also standard out), the compiled
+ * script for the rule file of the client, and the client's arguments.
+ * Compiled scripts are kept between clients, keyed by the name of the
+ * rule file and reloaded when it is modified.
+ */
+void
+run_daemon(const char *socket_file, DaemonHandler handler)
+{
+	struct sockaddr_un addr;
+	struct sigaction action;
+	RemarkScript *empty_script;
+	HMap *scripts = hmap_new();
+
+	listen_fd = socket_address(socket_file, &addr);
+	if (listen_fd < 0)
+		die_errno(_("cannot create socket"));
+	unlink(socket_file);
+	if (bind(listen_fd, (struct sockaddr *) &addr, sizeof(struct sockaddr_un)) < 0)
+		die_errno(_("cannot bind to `%s'"), socket_file);
+	if (listen(listen_fd, SOMAXCONN) < 0)
+		die_errno(_("cannot listen on `%s'"), socket_file);
+
+	/* Children are reaped automatically. */
+	memset(&action, 0, sizeof(struct sigaction));
+	action.sa_handler = SIG_IGN;
+	action.sa_flags = SA_NOCLDWAIT;
+	sigaction(SIGCHLD, &action, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	empty_script = read_script(NULL, false, NULL);
+
+	for (;;) {
+		int fd = accept(listen_fd, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			die_errno(_("cannot accept connection"));
+		}
+		accept_client(fd, scripts, empty_script, handler);
+		close(fd);
+	}
+}
+
+/* Pass standard in to the daemon and its output to standard out. The
+ * connection is written to only when poll says it can take more, so
+ * that neither side blocks writing while the other is blocked too.
+ */
+static void
+relay(int fd)
+{
+	char *in_buf = xmalloc(DAEMON_BLOCK_SIZE);
+	char *out_buf = xmalloc(DAEMON_BLOCK_SIZE);
+	size_t in_len = 0;
+	size_t in_pos = 0;
+	bool in_open = true;
+
+	for (;;) {
+		struct pollfd pfds[2];
+		int n = 0;
+
+		pfds[n].fd = fd;
+		pfds[n].events = POLLIN | (in_pos < in_len ? POLLOUT : 0);
+		n++;
+		if (in_open && in_pos == in_len) {
+			pfds[n].fd = STDIN_FILENO;
+			pfds[n].events = POLLIN;
+			n++;
+		}
+		if (poll(pfds, n, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			die_errno(_("cannot wait for input"));
+		}
+
+		if (n > 1 && pfds[1].revents != 0) {
+			ssize_t len = read(STDIN_FILENO, in_buf, DAEMON_BLOCK_SIZE);
+			if (len < 0 && errno != EINTR)
+				die_errno(_("cannot read from standard in"));
+			if (len == 0) {
+				in_open = false;
+				shutdown(fd, SHUT_WR);
+			} else if (len > 0) {
+				in_len = len;
+				in_pos = 0;
+			}
+		}
+		if ((pfds[0].revents & POLLOUT) != 0) {
+			ssize_t len = write(fd, in_buf+in_pos, in_len-in_pos);
+			if (len < 0 && errno != EINTR && errno != EAGAIN)
+				die_errno(_("cannot write to daemon"));
+			if (len > 0)
+				in_pos += len;
+		}
+		if ((pfds[0].revents & (POLLIN|POLLHUP|POLLERR)) != 0) {
+			ssize_t len = read(fd, out_buf, DAEMON_BLOCK_SIZE);
+			if (len < 0 && errno != EINTR)
+				die_errno(_("cannot read from daemon"));
+			if (len == 0)
+				break;
+			if (len > 0 && !write_fully(STDOUT_FILENO, out_buf, len))
+				die_errno(_("cannot write to standard out"));
+		}
+	}
+
+	free(in_buf);
+	free(out_buf);
+}
+
+/**
+ * Have a daemon highlight standard in to standard out, using the
+ * given rule file (NULL for none) and arguments.
+ *
+ * @return
+ *   false if there is no daemon listening on socket_file or it could
+ *   not load the rule file, so that the caller should do the work.
+ */
+bool
+run_client(const char *socket_file, const char *rules, int argc, char **argv)
+{
+	struct sockaddr_un addr;
+	StrBuf *header;
+	char reply[6];
+	char *cwd;
+	int fd;
+	int c;
+
+	fd = socket_address(socket_file, &addr);
+	if (fd < 0)
+		return false;
+	if (connect(fd, (struct sockaddr *) &addr, sizeof(struct sockaddr_un)) < 0) {
+		close(fd);
+		return false;
+	}
+
+	cwd = current_directory();
+	header = strbuf_new();
+	strbuf_append_data(header, cwd, strlen(cwd)+1);
+	strbuf_append_data(header, rules == NULL ? "" : rules, rules == NULL ? 1 : strlen(rules)+1);
+	for (c = 0; c < argc; c++)
+		strbuf_append_data(header, argv[c], strlen(argv[c])+1);
+	strbuf_prependf(header, "%u\n", strbuf_length(header));
+	free(cwd);
+
+	signal(SIGPIPE, SIG_IGN);
+	if (!write_fully(fd, strbuf_buffer(header), strbuf_length(header))
+	    || !read_fully(fd, reply, 3) || memcmp(reply, "ok\n", 3) != 0) {
+		strbuf_free(header);
+		close(fd);
+		signal(SIGPIPE, SIG_DFL);
+		return false;
+	}
+	strbuf_free(header);
+	signal(SIGPIPE, SIG_DFL);
+
+	relay(fd);
+	close(fd);
+	return true;
+}
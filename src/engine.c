@@ -0,0 +1,724 @@
+/* engine.c - Regular expression engines.
+ *
+ * Copyright (C) 2001-2005 Oskar Liljeblad
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <config.h>
+#include <stdint.h>		/* Gnulib/C99/POSIX */
+#include <stdlib.h>		/* C89 */
+#include <string.h>		/* C89 */
+#ifdef HAVE_USELOCALE
+#include <locale.h>		/* POSIX */
+#endif
+#include "regex.h"		/* Gnulib */
+#include "xalloc.h"		/* Gnulib */
+#include "xvasprintf.h"		/* Gnulib */
+#include "gettext.h"		/* Gnulib */
+#define _(String) gettext(String)
+#include "common/error.h"
+#include "common/hmap.h"
+#include "common/strbuf.h"
+#include "common/string-utils.h"
+#include "remark.h"
+#ifdef HAVE_PCRE2
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
+#endif
+
+typedef int (*RegcompFunc)(regex_t *preg, const char *pattern, int cflags);
+typedef size_t (*RegerrorFunc)(int errcode, const regex_t *preg, char *errbuf, size_t errbuf_size);
+typedef void (*RegfreeFunc)(regex_t *preg);
+
+/* exec returns 1 on a match, 0 if there is none, and -1 if matching
+ * took more than regex_max_steps steps.
+ */
+struct _RegexEngine {
+	char *name;
+	RegexFlags flag;
+	void *(*compile)(const char *pattern, bool icase, char **error);
+	int (*exec)(void *compiled, char *string, uint32_t so, uint32_t eo, uint32_t subc, SubmatchSpec *subv);
+	uint32_t (*nsub)(void *compiled);
+	void (*free)(void *compiled);
+};
+
+struct _Regex {
+	const RegexEngine *engine;
+	void *compiled;
+	bool ascii;		/* whether to use ascii_compiled on ASCII lines */
+	void *ascii_compiled;	/* by the gnulib engine, or NULL */
+	uint32_t nsub;
+	char *pattern;
+	bool icase;
+	char *key;
+	HMap *regexes;
+	uint32_t refs;
+	bool exceeded;
+};
+
+/* gnulib-regex.c */
+int gl_regcomp(regex_t *preg, const char *pattern, int cflags);
+extern long int gl_re_max_backtracks;
+extern long int gl_re_backtracks;
+int gl_re_search(struct re_pattern_buffer *buffer, const char *string, int length, int start, int range, struct re_registers *regs);
+size_t gl_regerror(int errcode, const regex_t *preg, char *errbuf, size_t errbuf_size);
+void gl_regfree(regex_t *preg);
+
+static void *libc_compile(const char *pattern, bool icase, char **error);
+static int libc_exec(void *compiled, char *string, uint32_t so, uint32_t eo, uint32_t subc, SubmatchSpec *subv);
+static void libc_free(void *compiled);
+static void *gnulib_compile(const char *pattern, bool icase, char **error);
+static int gnulib_exec(void *compiled, char *string, uint32_t so, uint32_t eo, uint32_t subc, SubmatchSpec *subv);
+static void gnulib_free(void *compiled);
+static uint32_t posix_nsub(void *compiled);
+#ifdef HAVE_PCRE2
+static void *pcre2_engine_compile(const char *pattern, bool icase, char **error);
+static int pcre2_engine_exec(void *compiled, char *string, uint32_t so, uint32_t eo, uint32_t subc, SubmatchSpec *subv);
+static uint32_t pcre2_engine_nsub(void *compiled);
+static void pcre2_engine_free(void *compiled);
+#endif
+
+static bool compile_regex(Regex *regex, char **error);
+
+static RegexEngine engines[] = {
+	{ "libc", REGEX_ENGINE_LIBC, libc_compile, libc_exec, posix_nsub, libc_free },
+	{ "gnulib", REGEX_ENGINE_GNULIB, gnulib_compile, gnulib_exec, posix_nsub, gnulib_free },
+#ifdef HAVE_PCRE2
+	{ "pcre2", REGEX_ENGINE_PCRE2, pcre2_engine_compile, pcre2_engine_exec, pcre2_engine_nsub, pcre2_engine_free },
+#endif
+};
+
+/* The engine used for regexes without an engine flag, or NULL to
+ * pick one for each regex.
+ */
+const RegexEngine *regex_engine = NULL;
+
+/* The most backtracking steps one match may take, or 0 for no
+ * limit. Only the gnulib and pcre2 engines can be limited, so with
+ * a limit gnulib takes the place of libc unless libc is asked for.
+ */
+uint32_t regex_max_steps = 1000000;
+
+/* If true, regexes match bytes rather than the characters of the
+ * locale.
+ */
+bool regex_bytes = false;
+
+bool
+identify_regex_engine(const char *name)
+{
+	int c;
+
+	if (strcmp(name, "auto") == 0) {
+		regex_engine = NULL;
+		return true;
+	}
+	for (c = 0; c < sizeof(engines)/sizeof(RegexEngine); c++) {
+		if (strcmp(name, engines[c].name) == 0) {
+			regex_engine = &engines[c];
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* The gnulib matcher is built without multibyte support, so it
+ * matches bytes even in a UTF-8 locale. It finds the same matches as
+ * the C library if each character of the pattern can only match a
+ * whole character of the line: the pattern is ASCII, without `.',
+ * bracket expressions, word operators or case folding, which could
+ * match or skip part of a multibyte character.
+ */
+static bool
+matches_like_bytes(const char *pattern, bool icase)
+{
+	int c;
+
+	if (regex_bytes || MB_CUR_MAX == 1)
+		return true;
+	if (icase || !memascii(pattern, strlen(pattern)))
+		return false;
+	for (c = 0; pattern[c] != '\0'; c++) {
+		if (pattern[c] == '.' || pattern[c] == '[')
+			return false;
+		if (pattern[c] == '\\' && pattern[c+1] != '\0') {
+			c++;
+			if (strchr("wWsSbB<>", pattern[c]) != NULL)
+				return false;
+		}
+	}
+	return true;
+}
+
+/* PCRE2 finds the leftmost-first match, not the leftmost-longest as
+ * POSIX requires, and its syntax differs in the details. Only when a
+ * pattern offers the matcher no choices at all are the results the
+ * same, so only then is PCRE2 picked on its own. Return NULL if the
+ * engine requested by flags is not available. ascii is set if the
+ * gnulib engine should also be used for lines of only ASCII.
+ */
+static const RegexEngine *
+choose_engine(const char *pattern, RegexFlags flags, bool *ascii)
+{
+	bool icase = (flags & REGEX_IGNORE_CASE) != 0;
+	int c;
+
+	*ascii = false;
+
+	for (c = 0; c < sizeof(engines)/sizeof(RegexEngine); c++) {
+		if (flags & engines[c].flag)
+			return &engines[c];
+	}
+	if (flags & (REGEX_ENGINE_LIBC|REGEX_ENGINE_GNULIB|REGEX_ENGINE_PCRE2))
+		return NULL;
+	if (regex_engine != NULL)
+		return regex_engine;
+
+#ifdef HAVE_PCRE2
+	for (c = 0; pattern[c] != '\0'; c++) {
+		if ((unsigned char) pattern[c] >= 0x80 || strchr("|?*+{\\.[", pattern[c]) != NULL)
+			break;
+	}
+	if (pattern[c] == '\0' && !icase)
+		return &engines[2];
+#endif
+
+	/* The C library matcher cannot be stopped, so it is only used
+	 * when matches have no step limit, or when gnulib would match
+	 * differently. Even then, gnulib is used for lines of only ASCII
+	 * if the pattern is ASCII, since it then matches like libc.
+	 */
+	if (regex_max_steps == 0)
+		return &engines[0];
+	if (matches_like_bytes(pattern, icase))
+		return &engines[1];
+	*ascii = memascii(pattern, strlen(pattern));
+	return &engines[0];
+}
+
+/* Regexes are never modified once compiled, so all rules of a script
+ * with the same pattern share one. They are kept by engine, case flag
+ * and pattern in the regexes map of the script. If the script is lazy,
+ * compilation is put off until the regex is first used, since most
+ * rules of a large rule file never get to match anything.
+ */
+Regex *
+new_regex(RemarkScript *script, const char *pattern, RegexFlags flags, char **error)
+{
+	bool ascii;
+	const RegexEngine *engine = choose_engine(pattern, flags, &ascii);
+	bool icase = (flags & REGEX_IGNORE_CASE) != 0;
+	Regex *regex;
+	char *key;
+
+	if (engine == NULL) {
+		*error = xstrdup(_("regex engine not available"));
+		return NULL;
+	}
+
+	key = xasprintf("%s/%d/%s", engine->name, icase, pattern);
+	regex = hmap_get(script->regexes, key);
+	if (regex != NULL) {
+		free(key);
+		regex->refs++;
+		return regex;
+	}
+
+	regex = xmalloc(sizeof(Regex));
+	regex->engine = engine;
+	regex->compiled = NULL;
+	regex->ascii = ascii;
+	regex->ascii_compiled = NULL;
+	regex->nsub = 0;
+	regex->pattern = xstrdup(pattern);
+	regex->icase = icase;
+	regex->key = key;
+	regex->regexes = script->regexes;
+	regex->refs = 1;
+	regex->exceeded = false;
+	if (!script->lazy && !compile_regex(regex, error)) {
+		free(regex->pattern);
+		free(regex->key);
+		free(regex);
+		return NULL;
+	}
+	hmap_put(script->regexes, key, regex);
+	return regex;
+}
+
+void
+free_regex(Regex *regex)
+{
+	if (regex != NULL && --regex->refs == 0) {
+		hmap_remove(regex->regexes, regex->key);
+		if (regex->compiled != NULL)
+			regex->engine->free(regex->compiled);
+		if (regex->ascii_compiled != NULL)
+			engines[1].free(regex->ascii_compiled);
+		free(regex->pattern);
+		free(regex->key);
+		free(regex);
+	}
+}
+
+static bool
+compile_regex(Regex *regex, char **error)
+{
+	regex->compiled = regex->engine->compile(regex->pattern, regex->icase, error);
+	if (regex->compiled == NULL)
+		return false;
+	regex->nsub = regex->engine->nsub(regex->compiled);
+	if (regex->ascii) {
+		char *msg;
+		regex->ascii_compiled = engines[1].compile(regex->pattern, regex->icase, &msg);
+		if (regex->ascii_compiled == NULL)
+			free(msg);
+	}
+	return true;
+}
+
+/* Compile a regex that has not been used before. Errors in the
+ * pattern can only be reported without the location in the rules.
+ */
+static void
+compile_regex_lazily(Regex *regex)
+{
+	char *msg;
+
+	if (!compile_regex(regex, &msg))
+		die(_("cannot compile regex `%s': %s"), regex->pattern, msg);
+}
+
+/* Whether a regex has been compiled, so that its subexpressions can
+ * be counted without compiling it.
+ */
+bool
+regex_compiled(Regex *regex)
+{
+	return regex->compiled != NULL;
+}
+
+uint32_t
+regex_nsub(Regex *regex)
+{
+	if (regex->compiled == NULL)
+		compile_regex_lazily(regex);
+	return regex->nsub;
+}
+
+/* Match regex against the buffer of mb between so and eo, as if that
+ * part was the whole string. subv receives subc submatches, with
+ * offsets into the buffer. Unmatched submatches are set to -1. A match
+ * that takes more than regex_max_steps steps is given up and treated
+ * as no match, so that one pathological regex cannot stall all input.
+ */
+bool
+regex_exec(Regex *regex, MatchBuffer *mb, uint32_t so, uint32_t eo, uint32_t subc, SubmatchSpec *subv)
+{
+	char *string = strbuf_buffer(mb->buffer);
+	int rc;
+
+	if (regex->compiled == NULL)
+		compile_regex_lazily(regex);
+	if (regex->ascii_compiled != NULL && memascii(string+so, eo-so))
+		rc = engines[1].exec(regex->ascii_compiled, string, so, eo, subc, subv);
+	else
+		rc = regex->engine->exec(regex->compiled, string, so, eo, subc, subv);
+	if (rc < 0) {
+		if (!regex->exceeded) {
+			warn(_("regex `%s' exceeds the step limit and is skipped on such lines"), regex->pattern);
+			regex->exceeded = true;
+		}
+		mb->scratch->exceeded++;
+	}
+	return rc > 0;
+}
+
+/* In a multibyte locale, both POSIX matchers convert the string to
+ * wide characters before matching, which is several times slower.
+ * So patterns of only ASCII characters are also compiled in the C
+ * locale, and that version is used for lines of only ASCII, where
+ * the two always agree. With regex_bytes, only the C locale version
+ * is made and used for all lines.
+ */
+typedef struct _PosixRegex PosixRegex;
+
+struct _PosixRegex {
+	regex_t *preg;		/* in the current locale, or NULL */
+	regex_t *bytes;		/* in the C locale, or NULL */
+};
+
+/* Each compiled regex carries the arrays that its matches are
+ * returned in, so that matching needs no memory of its own.
+ */
+typedef struct _LibcRegex LibcRegex;
+typedef struct _GnulibRegex GnulibRegex;
+
+struct _LibcRegex {
+	PosixRegex p;
+	regmatch_t *pmatch;
+};
+
+struct _GnulibRegex {
+	PosixRegex p;
+	struct re_registers regs;
+};
+
+#ifdef HAVE_USELOCALE
+static locale_t c_locale = (locale_t) 0;
+
+static locale_t
+enter_c_locale(void)
+{
+	if (c_locale == (locale_t) 0) {
+		c_locale = newlocale(LC_ALL_MASK, "C", (locale_t) 0);
+		if (c_locale == (locale_t) 0)
+			die_memory();
+	}
+	return uselocale(c_locale);
+}
+#endif
+
+static regex_t *
+posix_compile_one(RegcompFunc regcomp_func, RegerrorFunc regerror_func, RegfreeFunc regfree_func,
+		const char *pattern, bool icase, bool bytes, char **error)
+{
+	regex_t *preg = xmalloc(sizeof(regex_t));
+#ifdef HAVE_USELOCALE
+	locale_t old = (bytes ? enter_c_locale() : (locale_t) 0);
+#endif
+	int rc;
+
+	memset(preg, 0, sizeof(regex_t));
+	rc = regcomp_func(preg, pattern, REG_EXTENDED | (icase ? REG_ICASE : 0));
+#ifdef HAVE_USELOCALE
+	if (bytes)
+		uselocale(old);
+#endif
+	if (rc != 0) {
+		size_t length = regerror_func(rc, preg, NULL, 0);
+		*error = xmalloc(length);
+		regerror_func(rc, preg, *error, length);
+		regfree_func(preg);
+		free(preg);
+		return NULL;
+	}
+
+	return preg;
+}
+
+static bool
+posix_compile(RegcompFunc regcomp_func, RegerrorFunc regerror_func, RegfreeFunc regfree_func,
+		PosixRegex *compiled, const char *pattern, bool icase, char **error)
+{
+#ifdef HAVE_USELOCALE
+	bool multibyte = (MB_CUR_MAX > 1);
+#endif
+
+	compiled->preg = NULL;
+	compiled->bytes = NULL;
+#ifdef HAVE_USELOCALE
+	if (multibyte && regex_bytes) {
+		compiled->bytes = posix_compile_one(regcomp_func, regerror_func, regfree_func, pattern, icase, true, error);
+		return compiled->bytes != NULL;
+	}
+#endif
+	compiled->preg = posix_compile_one(regcomp_func, regerror_func, regfree_func, pattern, icase, false, error);
+	if (compiled->preg == NULL)
+		return false;
+#ifdef HAVE_USELOCALE
+	if (multibyte && memascii(pattern, strlen(pattern))) {
+		char *msg;
+		compiled->bytes = posix_compile_one(regcomp_func, regerror_func, regfree_func, pattern, icase, true, &msg);
+		if (compiled->bytes == NULL)
+			free(msg);
+	}
+#endif
+
+	return true;
+}
+
+static void
+posix_free(RegfreeFunc regfree_func, PosixRegex *compiled)
+{
+	if (compiled->preg != NULL) {
+		regfree_func(compiled->preg);
+		free(compiled->preg);
+	}
+	if (compiled->bytes != NULL) {
+		regfree_func(compiled->bytes);
+		free(compiled->bytes);
+	}
+}
+
+static uint32_t
+posix_nsub(void *compiled)
+{
+	PosixRegex *regex = compiled;
+	return (regex->preg != NULL ? regex->preg : regex->bytes)->re_nsub;
+}
+
+/* Return the version of regex to match against the string between
+ * so and eo. If it is the C locale version, the C locale is entered
+ * and the locale to return to is stored in old.
+ */
+static regex_t *
+posix_select(PosixRegex *regex, const char *string, uint32_t so, uint32_t eo, void **old)
+{
+	*old = NULL;
+#ifdef HAVE_USELOCALE
+	if (regex->bytes != NULL && (regex->preg == NULL || memascii(string+so, eo-so))) {
+		*old = enter_c_locale();
+		return regex->bytes;
+	}
+#endif
+	return regex->preg;
+}
+
+static void
+posix_unselect(void *old)
+{
+#ifdef HAVE_USELOCALE
+	if (old != NULL)
+		uselocale(old);
+#endif
+}
+
+static void *
+libc_compile(const char *pattern, bool icase, char **error)
+{
+	LibcRegex *compiled = xmalloc(sizeof(LibcRegex));
+
+	if (!posix_compile(regcomp, regerror, regfree, &compiled->p, pattern, icase, error)) {
+		free(compiled);
+		return NULL;
+	}
+	compiled->pmatch = xmalloc(sizeof(regmatch_t) * (posix_nsub(compiled) + 1));
+	return compiled;
+}
+
+/* The C library regexec needs a terminated string, so the character
+ * at eo is temporarily replaced.
+ */
+static int
+libc_exec(void *compiled, char *string, uint32_t so, uint32_t eo, uint32_t subc, SubmatchSpec *subv)
+{
+	LibcRegex *regex = compiled;
+	regex_t *preg;
+	uint32_t c;
+	void *old;
+	char tmp;
+	int rc;
+
+	preg = posix_select(&regex->p, string, so, eo, &old);
+	tmp = string[eo];
+	string[eo] = '\0';
+	rc = regexec(preg, string+so, subc, regex->pmatch, 0);
+	string[eo] = tmp;
+	posix_unselect(old);
+
+	if (rc == REG_ESPACE)
+		die_memory();
+	if (rc != 0)
+		return 0;
+
+	for (c = 0; c < subc; c++) {
+		if (regex->pmatch[c].rm_so == -1) {
+			subv[c].so = -1;
+			subv[c].eo = -1;
+		} else {
+			subv[c].so = regex->pmatch[c].rm_so + so;
+			subv[c].eo = regex->pmatch[c].rm_eo + so;
+		}
+	}
+
+	return 1;
+}
+
+static void
+libc_free(void *compiled)
+{
+	LibcRegex *regex = compiled;
+	posix_free(regfree, &regex->p);
+	free(regex->pmatch);
+	free(regex);
+}
+
+/* The registers are handed to re_search as fixed, so that it neither
+ * allocates nor resizes them. Unlike regexec, re_search takes the
+ * length of the string, so the string is left as it is.
+ */
+static void *
+gnulib_compile(const char *pattern, bool icase, char **error)
+{
+	GnulibRegex *compiled = xmalloc(sizeof(GnulibRegex));
+
+	if (!posix_compile(gl_regcomp, gl_regerror, gl_regfree, &compiled->p, pattern, icase, error)) {
+		free(compiled);
+		return NULL;
+	}
+	compiled->regs.num_regs = posix_nsub(compiled) + 1;
+	compiled->regs.start = xmalloc(sizeof(regoff_t) * compiled->regs.num_regs);
+	compiled->regs.end = xmalloc(sizeof(regoff_t) * compiled->regs.num_regs);
+	if (compiled->p.preg != NULL)
+		compiled->p.preg->regs_allocated = REGS_FIXED;
+	if (compiled->p.bytes != NULL)
+		compiled->p.bytes->regs_allocated = REGS_FIXED;
+	return compiled;
+}
+
+static int
+gnulib_exec(void *compiled, char *string, uint32_t so, uint32_t eo, uint32_t subc, SubmatchSpec *subv)
+{
+	GnulibRegex *regex = compiled;
+	regex_t *preg;
+	uint32_t c;
+	void *old;
+	int rc;
+
+	gl_re_max_backtracks = regex_max_steps;
+	gl_re_backtracks = 0;
+	preg = posix_select(&regex->p, string, so, eo, &old);
+	rc = gl_re_search(preg, string+so, eo-so, 0, eo-so, &regex->regs);
+	posix_unselect(old);
+	if (rc == -2) {
+		if (regex_max_steps > 0 && gl_re_backtracks > regex_max_steps)
+			return -1;
+		die_memory();
+	}
+	if (rc < 0)
+		return 0;
+
+	for (c = 0; c < subc; c++) {
+		if (regex->regs.start[c] == -1) {
+			subv[c].so = -1;
+			subv[c].eo = -1;
+		} else {
+			subv[c].so = regex->regs.start[c] + so;
+			subv[c].eo = regex->regs.end[c] + so;
+		}
+	}
+
+	return 1;
+}
+
+static void
+gnulib_free(void *compiled)
+{
+	GnulibRegex *regex = compiled;
+	posix_free(gl_regfree, &regex->p);
+	free(regex->regs.start);
+	free(regex->regs.end);
+	free(regex);
+}
+
+#ifdef HAVE_PCRE2
+
+typedef struct _Pcre2Regex Pcre2Regex;
+
+struct _Pcre2Regex {
+	pcre2_code *code;
+	pcre2_match_data *match_data;
+};
+
+static pcre2_match_context *match_context = NULL;
+
+static void *
+pcre2_engine_compile(const char *pattern, bool icase, char **error)
+{
+	Pcre2Regex *compiled;
+	PCRE2_SIZE erroffset;
+	pcre2_code *code;
+	int errcode;
+
+	code = pcre2_compile((PCRE2_SPTR) pattern, PCRE2_ZERO_TERMINATED,
+			icase ? PCRE2_CASELESS : 0, &errcode, &erroffset, NULL);
+	if (code == NULL) {
+		*error = xmalloc(256);
+		pcre2_get_error_message(errcode, (PCRE2_UCHAR *) *error, 256);
+		return NULL;
+	}
+	pcre2_jit_compile(code, PCRE2_JIT_COMPLETE);	/* falls back to the interpreter */
+
+	compiled = xmalloc(sizeof(Pcre2Regex));
+	compiled->code = code;
+	compiled->match_data = pcre2_match_data_create_from_pattern(code, NULL);
+	if (compiled->match_data == NULL)
+		die_memory();
+	return compiled;
+}
+
+/* The subject starts at so, so that `^' matches there like with
+ * the POSIX engines.
+ */
+static int
+pcre2_engine_exec(void *compiled, char *string, uint32_t so, uint32_t eo, uint32_t subc, SubmatchSpec *subv)
+{
+	Pcre2Regex *regex = compiled;
+	PCRE2_SIZE *ovector;
+	uint32_t count;
+	uint32_t c;
+	int rc;
+
+	if (match_context == NULL) {
+		match_context = pcre2_match_context_create(NULL);
+		if (match_context == NULL)
+			die_memory();
+	}
+	pcre2_set_match_limit(match_context, regex_max_steps > 0 ? regex_max_steps : UINT32_MAX);
+
+	rc = pcre2_match(regex->code, (PCRE2_SPTR) string+so, eo-so, 0, 0, regex->match_data, match_context);
+	if (rc == PCRE2_ERROR_MATCHLIMIT)
+		return -1;
+	if (rc == PCRE2_ERROR_NOMEMORY)
+		die_memory();
+	if (rc <= 0)
+		return 0;
+
+	ovector = pcre2_get_ovector_pointer(regex->match_data);
+	count = pcre2_get_ovector_count(regex->match_data);
+	for (c = 0; c < subc; c++) {
+		if (c >= count || ovector[2*c] == PCRE2_UNSET) {
+			subv[c].so = -1;
+			subv[c].eo = -1;
+		} else {
+			subv[c].so = ovector[2*c] + so;
+			subv[c].eo = ovector[2*c+1] + so;
+		}
+	}
+
+	return 1;
+}
+
+static uint32_t
+pcre2_engine_nsub(void *compiled)
+{
+	uint32_t count = 0;
+	pcre2_pattern_info(((Pcre2Regex *) compiled)->code, PCRE2_INFO_CAPTURECOUNT, &count);
+	return count;
+}
+
+static void
+pcre2_engine_free(void *compiled)
+{
+	Pcre2Regex *regex = compiled;
+	pcre2_match_data_free(regex->match_data);
+	pcre2_code_free(regex->code);
+	free(regex);
+}
+
+#endif
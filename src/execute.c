@@ -24,60 +24,171 @@
 #include <stdint.h>		/* Gnulib/C99/POSIX */
 #include "xalloc.h"		/* Gnulib */
 #include "minmax.h"		/* Gnulib */
+#include "gettext.h"		/* Gnulib */
+#define _(String) gettext(String)
+#include "common/error.h"
+#include "common/intutil.h"
 #include "common/string-utils.h"
-#include "common/regex-utils.h"
 #include "common/strbuf.h"
 #include "remark.h"
 
+#define MAX_ESCAPES 256
+
 static bool execute_rule(Rule *rule, MatchBuffer *mb);
+static uint32_t execute_extra_rule(Rule *rule, MatchBuffer *mb);
 static ActionType execute_substitution_rule(SubstitutionRule *rule, MatchState *ms);
 static ActionType execute_match_rule(MatchRule *rule, MatchState *ms);
 static ActionType execute_multi_rule(MultiRule *rule, MatchState *state);
 static ActionType execute_set_rule(SetRule *rule, MatchState *ms);
 static ActionType execute_any_rule(Rule *rule, MatchState *ms);
+static ActionType execute_condition_rule(ConditionRule *rule, MatchState *ms);
+static bool test_condition(Condition *condition, MatchState *ms);
+static ActionType execute_list_rule(ListRule *rule, MatchState *ms);
 
 static void update_positions(MatchState *ms, int32_t so, int32_t diff);
 static StyleRange *new_style_range(Style *style, uint32_t so, uint32_t eo);
-static void insert_style(MatchState *ms, StyleRange *s1);
+static void insert_style(LList *list, StyleRange *s1);
 static LNode *insort_style1(LList *list, LNode *node, StyleRange *orig, StyleRange *a);
 static LNode *insort_style2(LList *list, LNode *node, StyleRange *orig, StyleRange *a, StyleRange *b);
 static LNode *insort_style3(LList *list, LNode *node, StyleRange *orig, StyleRange *b);
 
+static void clear_styles(LList *styles);
 static void init_match_buffer(MatchBuffer *mb);
 static void free_match_buffer(MatchBuffer *mb);
 
+bool
+identify_escape_mode(const char *name, EscapeMode *mode)
+{
+	if (strcmp(name, "keep") == 0)
+		*mode = ESCAPES_KEEP;
+	else if (strcmp(name, "strip") == 0)
+		*mode = ESCAPES_STRIP;
+	else if (strcmp(name, "restore") == 0)
+		*mode = ESCAPES_RESTORE;
+	else
+		return false;
+	return true;
+}
+
+/* Remove escape sequences from the input line before it is matched.
+ * Text between escape sequences is moved in whole runs, found with
+ * memchr. When restoring, every escape sequence is remembered as an
+ * empty style range at its position, which follows substitutions and
+ * is printed like any other style. Such styles are shared by lines,
+ * but are forgotten once MAX_ESCAPES different sequences have been
+ * seen, so that input with ever new sequences does not fill memory.
+ * No line refers to them when the next line is stripped.
+ */
+void
+strip_escapes(RemarkInput *input)
+{
+	char *buf = strbuf_buffer(input->mb.buffer);
+	uint32_t len = input->mb.bufferlen;
+	uint32_t sp;
+	uint32_t dp;
+	char *esc;
+
+	llist_iterate(input->mb.escapes, (IteratorFunc) free);
+	llist_clear(input->mb.escapes);
+	if (input->escapes != NULL && hmap_size(input->escapes) >= MAX_ESCAPES) {
+		hmap_foreach_value(input->escapes, free_style);
+		hmap_clear(input->escapes);
+	}
+
+	esc = memchr(buf, '\033', len);
+	if (esc == NULL)
+		return;
+
+	for (sp = dp = esc - buf; sp < len; ) {
+		uint32_t elen = escape_length(buf+sp, len-sp);
+		uint32_t run;
+
+		if (input->escape_mode == ESCAPES_RESTORE) {
+			char *key = strbuf_substring(input->mb.buffer, sp, sp+elen);
+			Style *style;
+
+			if (input->escapes == NULL)
+				input->escapes = hmap_new();
+			style = hmap_get(input->escapes, key);
+			if (style == NULL) {
+				style = xmalloc(sizeof(Style));
+				style->name = key;
+				style->pre_string = xstrdup(key);
+				style->post_string = xstrdup("");
+				style->refs = 1;
+				hmap_put(input->escapes, key, style);
+			} else {
+				free(key);
+			}
+			llist_add_last(input->mb.escapes, new_style_range(style, dp, dp));
+		}
+
+		sp += elen;
+		esc = memchr(buf+sp, '\033', len-sp);
+		run = (esc == NULL ? len : esc - buf) - sp;
+		memmove(buf+dp, buf+sp, run);
+		sp += run;
+		dp += run;
+	}
+
+	strbuf_set_length(input->mb.buffer, dp);
+	input->mb.bufferlen = dp;
+}
+
 bool
 execute_script(RemarkScript *script, RemarkInput *input)
 {
 	if (script->rule != NULL) {
-		if (!execute_rule(script->rule, &input->mb))
+		if (!execute_rule(script->rule, &input->mb)) {
+			clear_styles(input->mb.styles);
 			return false;
+		}
 	}
 
-	if (script->append_rule != NULL) {
-		execute_rule(script->append_rule, &input->append_mb);
-		apply_styles(&input->append_mb, INT32_MAX);
-		llist_clear(input->append_mb.styles);
+	/* Restored escape sequences are inserted last, so that they only
+	 * split the styles around them.
+	 */
+	if (llist_size(input->mb.escapes) != 0) {
+		LNode *node;
+		for (node = llist_get_first_node(input->mb.escapes); node != NULL; node = lnode_next(node))
+			insert_style(input->mb.styles, lnode_data(node));
+		llist_clear(input->mb.escapes);
 	}
 
-	if (script->prepend_rule != NULL) {
-		execute_rule(script->prepend_rule, &input->prepend_mb);
-		apply_styles(&input->prepend_mb, INT32_MAX);
-		llist_clear(input->prepend_mb.styles);
-	}
+	input->append_cols = execute_extra_rule(script->append_rule, &input->append_mb);
+	input->prepend_cols = execute_extra_rule(script->prepend_rule, &input->prepend_mb);
 
 	wrap_line(script, input);
-	llist_clear(input->mb.styles);
+	clear_styles(input->mb.styles);
 
 	return true;
 }
 
+/* Highlight the append or prepend string. Its width is measured
+ * before styles are inserted, since those may be printable text.
+ */
+static uint32_t
+execute_extra_rule(Rule *rule, MatchBuffer *mb)
+{
+	uint32_t cols;
+
+	if (rule != NULL)
+		execute_rule(rule, mb);
+	cols = display_width(strbuf_buffer(mb->buffer), mb->bufferlen);
+	if (rule != NULL) {
+		apply_styles(mb, INT32_MAX);
+		clear_styles(mb->styles);
+	}
+	return cols;
+}
+
 static bool
 execute_rule(Rule *rule, MatchBuffer *mb)
 {
 	MatchState *ms;
 
 	assert(strbuf_length(mb->buffer) == mb->bufferlen);
+	mb->serial++;
 	ms = new_match_state(mb, 0, mb->bufferlen, 1);
 	if (execute_any_rule(rule, ms) != ACTION_SKIP) {
 		assert(strbuf_length(mb->buffer) == ms->subv[0].eo);
@@ -100,29 +211,24 @@ execute_substitution_rule(SubstitutionRule *subst, MatchState *ms)
 
 	do {
 		uint32_t replen;
-		uint32_t subc = subst->regex.re_nsub + 1;
-		regmatch_t subv_re[subc];
+		uint32_t subc = regex_nsub(subst->regex) + 1;
 		SubmatchSpec subv[subc];
 		char *repl;
-		uint32_t c;
 
 		last = (strbuf_char_at(ms->top->buffer, so) == '\0');
-		if (!xregexec_substring(&subst->regex, strbuf_buffer(ms->top->buffer), so, eo, subc, subv_re, 0))
+		if (!regex_exec(subst->regex, ms->top, so, eo, subc, subv))
 			break;
 
-    	    	for (c = 0; c < subc; c++) {
-		    subv[c].so = subv_re[c].rm_so;
-		    subv[c].eo = subv_re[c].rm_eo;
-		}
-
 		repl = expand_substitution(subst->replacement, ms, subc, subv); /* XXX: memory management */
 		strbuf_replace(ms->top->buffer, subv[0].so, subv[0].eo, repl);
+		ms->top->serial++;
 		replen = strlen(repl);
 
 		update_positions(ms, subv[0].so, replen - (subv[0].eo-subv[0].so));
-		so += replen + (subv[0].so == subv[0].eo ? 1 : 0);
+		eo += replen - (subv[0].eo-subv[0].so);
+		so = subv[0].so + replen + (subv[0].so == subv[0].eo ? 1 : 0);
 		free(repl);
-	} while (!last && (subst->flags & REGEX_GLOBAL) != 0);
+	} while (!last && so <= eo && (subst->flags & REGEX_GLOBAL) != 0);
 
 	return ACTION_CONTINUE;
 }
@@ -136,6 +242,7 @@ execute_set_rule(SetRule *rule, MatchState *ms)
 
     repl = expand_substitution(rule->replacement, ms, ms->subc, ms->subv); /* XXX: memory management */
     strbuf_replace(ms->top->buffer, so, eo, repl);
+    ms->top->serial++;
     update_positions(ms, 0, strlen(repl) - (eo-so));
     free(repl);
 
@@ -185,7 +292,7 @@ execute_any_rule(Rule *anyrule, MatchState *ms)
 	}
 	else if (anyrule->type == RULE_STYLE) {
 		StyleRule *rule = (StyleRule *) anyrule;
-		insert_style(ms, new_style_range(rule->style, ms->subv[0].so, ms->subv[0].eo));
+		insert_style(ms->top->styles, new_style_range(rule->style, ms->subv[0].so, ms->subv[0].eo));
 		return ACTION_CONTINUE;
 	}
 	else if (anyrule->type == RULE_ACTION) {
@@ -204,7 +311,149 @@ execute_any_rule(Rule *anyrule, MatchState *ms)
 		SetRule *rule = (SetRule *) anyrule;
 		return execute_set_rule(rule, ms);
 	}
+	else if (anyrule->type == RULE_CONDITION) {
+		ConditionRule *rule = (ConditionRule *) anyrule;
+		return execute_condition_rule(rule, ms);
+	}
+	else if (anyrule->type == RULE_STATE) {
+		StateRule *rule = (StateRule *) anyrule;
+		if ((*ms->top->states & rule->mask) == 0)
+			return ACTION_CONTINUE;
+		return execute_any_rule(rule->rule, ms);
+	}
+	else if (anyrule->type == RULE_LIST) {
+		ListRule *rule = (ListRule *) anyrule;
+		return execute_list_rule(rule, ms);
+	}
+	else if (anyrule->type == RULE_STATE_CHANGE) {
+		StateChangeRule *rule = (StateChangeRule *) anyrule;
+		if (rule->enter)
+			*ms->top->states |= rule->mask;
+		else
+			*ms->top->states &= ~rule->mask;
+		return ACTION_CONTINUE;
+	}
+
+	return ACTION_CONTINUE;
+}
+
+static ActionType
+execute_condition_rule(ConditionRule *rule, MatchState *ms)
+{
+	if (!test_condition(rule->condition, ms))
+		return ACTION_CONTINUE;
+	return execute_any_rule(rule->rule, ms);
+}
+
+/* Comparisons on subexpressions that did not match, or that do not
+ * hold a number, are false.
+ */
+static bool
+test_condition(Condition *condition, MatchState *ms)
+{
+	SubmatchSpec *spec;
+	double value;
+
+	if (condition->type == CONDITION_AND)
+		return test_condition(condition->left, ms) && test_condition(condition->right, ms);
+	if (condition->type == CONDITION_OR)
+		return test_condition(condition->left, ms) || test_condition(condition->right, ms);
+	if (condition->type == CONDITION_NOT)
+		return !test_condition(condition->left, ms);
+
+	if (condition->index >= ms->subc) {
+		if (ms->fields)
+			return false;
+		die(_("subexpression index is out of range"));
+	}
+	spec = &ms->subv[condition->index];
+	if (spec->so == -1 || spec->eo == -1)
+		return false;
+	if (!parse_decimal(strbuf_buffer(ms->top->buffer) + spec->so, spec->eo - spec->so, &value))
+		return false;
+
+	switch (condition->op) {
+	case COMPARE_EQ: return value == condition->value;
+	case COMPARE_NE: return value != condition->value;
+	case COMPARE_LT: return value < condition->value;
+	case COMPARE_LE: return value <= condition->value;
+	case COMPARE_GT: return value > condition->value;
+	case COMPARE_GE: return value >= condition->value;
+	}
+
+	return false;
+}
+
+/* Return the set of values of a list, making it if create is true,
+ * or NULL if no value has been added to the list yet.
+ */
+static HSet *
+list_set(ListSets *lists, uint32_t list, bool create)
+{
+	if (list >= lists->count) {
+		if (!create)
+			return NULL;
+		lists->sets = xrealloc(lists->sets, sizeof(HSet *) * (list + 1));
+		memset(lists->sets + lists->count, 0, sizeof(HSet *) * (list + 1 - lists->count));
+		lists->count = list + 1;
+	}
+	if (lists->sets[list] == NULL && create)
+		lists->sets[list] = hset_new(LIST_CAPACITY);
+	return lists->sets[list];
+}
+
+void
+free_list_sets(ListSets *lists)
+{
+	uint32_t c;
+
+	for (c = 0; c < lists->count; c++) {
+		if (lists->sets[c] != NULL)
+			hset_free(lists->sets[c]);
+	}
+	free(lists->sets);
+	lists->sets = NULL;
+	lists->count = 0;
+}
+
+static ActionType
+execute_list_rule(ListRule *rule, MatchState *ms)
+{
+	HSet *set = list_set(ms->top->lists, rule->list, rule->op == LIST_ADD);
+	const char *key;
+	char *expanded = NULL;
+	uint32_t len;
+	bool found = false;
+
+	if (rule->key_index >= 0) {
+		SubmatchSpec *spec;
+
+		if (rule->key_index >= ms->subc) {
+			if (ms->fields)
+				return ACTION_CONTINUE;
+			die(_("subexpression index is out of range"));
+		}
+		spec = &ms->subv[rule->key_index];
+		if (spec->so == -1 || spec->eo == -1)
+			return ACTION_CONTINUE;
+		key = strbuf_buffer(ms->top->buffer) + spec->so;
+		len = spec->eo - spec->so;
+	} else {
+		expanded = expand_substitution(rule->key, ms, ms->subc, ms->subv); /* XXX: memory management */
+		key = expanded;
+		len = strlen(expanded);
+	}
 
+	if (rule->op == LIST_ADD)
+		hset_add(set, key, len);
+	else if (set != NULL && rule->op == LIST_REMOVE)
+		hset_remove(set, key, len);
+	else if (set != NULL)
+		found = hset_contains(set, key, len);
+	free(expanded);
+
+	if (found)
+		return execute_any_rule(rule->rule, ms);
 	return ACTION_CONTINUE;
 }
 
@@ -229,6 +478,15 @@ update_positions(MatchState *ms, int32_t so, int32_t diff)
 
 	if (ms->parent == NULL) {
 		Iterator *it = ms->top->styles_it;
+		LNode *node;
+
+		/* Escape sequences stay in front of replaced text. */
+		for (node = llist_get_first_node(ms->top->escapes); node != NULL; node = lnode_next(node)) {
+			StyleRange *rng = lnode_data(node);
+			if (rng->so > so)
+				rng->so = rng->eo = MAX((int32_t) rng->so + diff, so);
+		}
+
 		for (iterator_restart(it); iterator_has_next(it); ) {
 			StyleRange *rng = iterator_next(it);
 
@@ -259,9 +517,8 @@ update_positions(MatchState *ms, int32_t so, int32_t diff)
 }
 
 static void
-insert_style(MatchState *ms, StyleRange *s1)
+insert_style(LList *list, StyleRange *s1)
 {
-	LList *list = ms->top->styles;
 	LNode *node = llist_get_first_node(list);
 	uint32_t old_so = s1->so;
 
@@ -436,29 +693,60 @@ new_style_range(Style *style, uint32_t so, uint32_t eo)
 	return rng;
 }
 
+/* Free the style ranges of a line once it has been highlighted. */
+static void
+clear_styles(LList *styles)
+{
+	llist_iterate(styles, (IteratorFunc) free);
+	llist_clear(styles);
+}
+
 static void
 init_match_buffer(MatchBuffer *mb)
 {
 	mb->buffer = strbuf_new();
 	mb->bufferlen = 0;	/* XXX: necessary? */
+	mb->serial = 0;
 	mb->styles = llist_new();
 	mb->styles_it = llist_iterator(mb->styles);
+	mb->escapes = llist_new();
 }
 
 static void
 free_match_buffer(MatchBuffer *mb)
 {
+	strbuf_free(mb->buffer);
 	iterator_free(mb->styles_it);
 	llist_iterate(mb->styles, (IteratorFunc) free);
 	llist_free(mb->styles);
+	llist_iterate(mb->escapes, (IteratorFunc) free);
+	llist_free(mb->escapes);
 }
 
 void
 init_input(RemarkInput *input)
 {
+	input->states = 0;
+	input->lists.sets = NULL;
+	input->lists.count = 0;
+	memset(&input->scratch, 0, sizeof(MatchScratch));
 	init_match_buffer(&input->mb);
 	init_match_buffer(&input->append_mb);
 	init_match_buffer(&input->prepend_mb);
+	input->escapes = NULL;
+	input->escape_mode = ESCAPES_KEEP;
+	input->wrapper = WRAPPER_CHAR;
+	input->wrap_width = UINT32_MAX;
+	input->wrap_retain = 0;
+	input->mb.states = &input->states;
+	input->append_mb.states = &input->states;
+	input->prepend_mb.states = &input->states;
+	input->mb.lists = &input->lists;
+	input->append_mb.lists = &input->lists;
+	input->prepend_mb.lists = &input->lists;
+	input->mb.scratch = &input->scratch;
+	input->append_mb.scratch = &input->scratch;
+	input->prepend_mb.scratch = &input->scratch;
 }
 
 void
@@ -467,4 +755,10 @@ free_input(RemarkInput *input)
 	free_match_buffer(&input->mb);
 	free_match_buffer(&input->append_mb);
 	free_match_buffer(&input->prepend_mb);
+	free_match_scratch(&input->scratch);
+	free_list_sets(&input->lists);
+	if (input->escapes != NULL) {
+		hmap_foreach_value(input->escapes, free_style);
+		hmap_free(input->escapes);
+	}
 }
@@ -0,0 +1,1047 @@
+/* follow.c - Reading log files: following, tails and time windows.
+ *
+ * Copyright (C) 2001-2005 Oskar Liljeblad
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <config.h>
+#include <stdlib.h>		/* C89 */
+#include <string.h>		/* C89 */
+#include <errno.h>		/* C89 */
+#include <signal.h>		/* C89 */
+#include <stdio.h>		/* C89 */
+#include <time.h>		/* C89 */
+#include <stdint.h>		/* Gnulib/C99/POSIX */
+#include <sys/types.h>		/* POSIX */
+#include <sys/stat.h>		/* POSIX */
+#include <fcntl.h>		/* POSIX */
+#include <unistd.h>		/* POSIX */
+#include <poll.h>		/* POSIX */
+#include <sys/time.h>		/* POSIX */
+#include <sys/socket.h>		/* POSIX */
+#include <sys/un.h>		/* POSIX */
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>	/* Linux */
+#endif
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>		/* Linux */
+#endif
+#include "xalloc.h"		/* Gnulib */
+#include "xvasprintf.h"		/* Gnulib */
+#include "dirname.h"		/* Gnulib */
+#include "getline.h"		/* Gnulib */
+#include "minmax.h"		/* Gnulib */
+#include "gettext.h"		/* Gnulib */
+#define _(String) gettext(String)
+#include "common/error.h"
+#include "common/llist.h"
+#include "common/strbuf.h"
+#include "common/string-utils.h"
+#include "remark.h"
+
+/* Size of blocks read from followed files. */
+#define FOLLOW_BLOCK_SIZE	65536
+/* Size of reads while searching for a time in a file. */
+#define FOLLOW_PROBE_SIZE	4096
+/* Milliseconds between checks of the files when inotify is not
+ * available or cannot watch all of them.
+ */
+#define FOLLOW_POLL_INTERVAL	1000
+/* Minimum number of milliseconds between writes of the state file. */
+#define FOLLOW_SAVE_INTERVAL	1000
+/* Maximum number of epoll events taken at a time. */
+#define FOLLOW_MAX_EVENTS	64
+
+typedef struct _FollowFile FollowFile;
+
+struct _FollowFile {
+	const char *filename;
+	int fd;
+	dev_t dev;
+	ino_t ino;
+	off_t offset;
+	int wd;
+	StrBuf *partial;
+	bool done;
+	bool stream;
+	void *userdata;
+};
+
+typedef struct _TailLines TailLines;
+typedef struct _TimeWindow TimeWindow;
+
+struct _TailLines {
+	LList *list;
+	uint32_t lines;
+};
+
+struct _TimeWindow {
+	FollowFile *ff;
+	struct tm since;
+	struct tm until;
+	bool has_since;
+	bool has_until;
+	bool started;
+	FollowHandler handler;
+	void *userdata;
+};
+
+const char *time_format = "%b %d %H:%M:%S";
+
+static int inotify_fd = -1;
+#ifdef HAVE_SYS_EPOLL_H
+static int epoll_fd = -1;
+#endif
+static bool need_poll = false;
+static volatile sig_atomic_t stop_signal = 0;
+
+static void
+watch_file(FollowFile *ff)
+{
+#ifdef HAVE_SYS_INOTIFY_H
+	if (inotify_fd < 0)
+		return;
+	if (ff->wd >= 0)
+		inotify_rm_watch(inotify_fd, ff->wd);
+	ff->wd = inotify_add_watch(inotify_fd, ff->filename, IN_MODIFY|IN_ATTRIB|IN_MOVE_SELF|IN_DELETE_SELF);
+	if (ff->wd < 0)
+		need_poll = true;
+#endif
+}
+
+/* Watch the directory of a file too, so that we learn when the file is
+ * created or renamed after rotation.
+ */
+static void
+watch_directory(FollowFile *ff)
+{
+#ifdef HAVE_SYS_INOTIFY_H
+	char *dir;
+
+	if (inotify_fd < 0)
+		return;
+	dir = dir_name(ff->filename);
+	if (inotify_add_watch(inotify_fd, dir, IN_CREATE|IN_MOVED_TO) < 0)
+		need_poll = true;
+	free(dir);
+#endif
+}
+
+/* Add a stream to the descriptors waited for. Descriptors that epoll
+ * does not support, such as a regular file on standard in, are always
+ * readable and need no waiting for.
+ */
+static void
+watch_stream(FollowFile *ff)
+{
+#ifdef HAVE_SYS_EPOLL_H
+	struct epoll_event event;
+
+	if (epoll_fd < 0)
+		return;
+	memset(&event, 0, sizeof(struct epoll_event));
+	event.events = EPOLLIN;
+	event.data.fd = ff->fd;
+	epoll_ctl(epoll_fd, EPOLL_CTL_ADD, ff->fd, &event);
+#endif
+}
+
+static void
+unwatch_stream(FollowFile *ff)
+{
+#ifdef HAVE_SYS_EPOLL_H
+	struct epoll_event event;
+
+	if (epoll_fd >= 0)
+		epoll_ctl(epoll_fd, EPOLL_CTL_DEL, ff->fd, &event);
+#endif
+}
+
+static int
+connect_socket(const char *filename)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	if (strlen(filename) >= sizeof(addr.sun_path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -1;
+	memset(&addr, 0, sizeof(struct sockaddr_un));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, filename);
+	if (connect(fd, (struct sockaddr *) &addr, sizeof(struct sockaddr_un)) < 0) {
+		int saved_errno = errno;
+		close(fd);
+		errno = saved_errno;
+		return -1;
+	}
+	return fd;
+}
+
+/* Open a file to follow. FIFOs, sockets and `-' (standard in) are
+ * streams, which are read as data arrives until they end, instead of
+ * being checked for growth and rotation. FIFOs are opened for writing
+ * too, so that they stay open when writers come and go.
+ */
+static bool
+open_file(FollowFile *ff, bool at_end)
+{
+	struct stat sb;
+	int fd;
+
+	if (strcmp(ff->filename, "-") == 0) {
+		fd = STDIN_FILENO;
+		ff->stream = true;
+	} else if (stat(ff->filename, &sb) == 0 && S_ISSOCK(sb.st_mode)) {
+		fd = connect_socket(ff->filename);
+	} else if (stat(ff->filename, &sb) == 0 && S_ISFIFO(sb.st_mode)) {
+		fd = open(ff->filename, O_RDWR);
+	} else {
+		fd = open(ff->filename, O_RDONLY);
+	}
+	if (fd < 0) {
+		if (errno != ENOENT)
+			warn_errno(_("cannot open `%s'"), ff->filename);
+		return false;
+	}
+	if (fstat(fd, &sb) < 0) {
+		warn_errno(_("cannot get file status for `%s'"), ff->filename);
+		close(fd);
+		return false;
+	}
+
+	ff->fd = fd;
+	ff->dev = sb.st_dev;
+	ff->ino = sb.st_ino;
+	if (ff->stream || !S_ISREG(sb.st_mode)) {
+		ff->stream = true;
+		ff->offset = 0;
+		watch_stream(ff);
+		return true;
+	}
+	ff->offset = (at_end ? sb.st_size : 0);
+	if (ff->offset != 0)
+		lseek(fd, ff->offset, SEEK_SET);
+	watch_file(ff);
+	return true;
+}
+
+/* Pass every complete line in data to the handler. The newline is
+ * replaced by a NUL byte so that lines can be handled in place, unless
+ * a partial line from the previous block has to be completed first.
+ * What remains after the last newline is saved for the next block.
+ */
+static void
+split_lines(FollowFile *ff, char *data, size_t len, FollowHandler handler, void *userdata)
+{
+	char *end = data + len;
+
+	while (data < end && !ff->done) {
+		char *nl = memchr(data, '\n', end - data);
+
+		if (nl == NULL) {
+			strbuf_append_data(ff->partial, data, end - data);
+			break;
+		}
+		*nl = '\0';
+		if (strbuf_length(ff->partial) != 0) {
+			strbuf_append_data(ff->partial, data, nl - data);
+			handler(strbuf_buffer(ff->partial), userdata);
+			strbuf_set_length(ff->partial, 0);
+		} else {
+			handler(data, userdata);
+		}
+		data = nl + 1;
+	}
+}
+
+static void
+flush_partial(FollowFile *ff, FollowHandler handler, void *userdata)
+{
+	if (strbuf_length(ff->partial) != 0) {
+		handler(strbuf_buffer(ff->partial), userdata);
+		strbuf_set_length(ff->partial, 0);
+	}
+}
+
+/* Check whether a stream can be read without blocking. Streams are
+ * not made non-blocking, since standard in may be shared with other
+ * processes that would see the flag too.
+ */
+static bool
+stream_ready(int fd)
+{
+	struct pollfd pfd;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	while (poll(&pfd, 1, 0) < 0) {
+		if (errno != EINTR)
+			return true;
+	}
+	return pfd.revents != 0;
+}
+
+/* Read and handle all data that is waiting in a file. Returns false
+ * if the end of the file was reached or it could not be read.
+ */
+static bool
+read_file(FollowFile *ff, char *buf, FollowHandler handler, void *userdata)
+{
+	for (;;) {
+		ssize_t len;
+
+		if (ff->stream && !stream_ready(ff->fd))
+			return true;
+		len = read(ff->fd, buf, FOLLOW_BLOCK_SIZE);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN)
+				return true;
+			warn_errno(_("cannot read from `%s'"), ff->filename);
+			return false;
+		}
+		if (len == 0)
+			return false;
+		ff->offset += len;
+		split_lines(ff, buf, len, handler, userdata);
+		if (ff->done)
+			return true;
+	}
+}
+
+/* Find where the last lines of a file start, by reading blocks
+ * backwards from the end and counting their newlines. Only the block
+ * holding the first wanted line is searched byte by byte.
+ */
+static off_t
+tail_offset(FollowFile *ff, off_t size, uint32_t lines, char *buf)
+{
+	off_t end = size;
+
+	if (lines == 0)
+		return size;
+
+	/* A newline ending the file does not start another line. */
+	if (size > 0 && pread(ff->fd, buf, 1, size-1) == 1 && buf[0] == '\n')
+		end--;
+
+	while (end > 0) {
+		off_t start = MAX(end - FOLLOW_BLOCK_SIZE, 0);
+		size_t len = end - start;
+		size_t got = 0;
+		size_t count;
+
+		while (got < len) {
+			ssize_t n = pread(ff->fd, buf+got, len-got, start+got);
+			if (n <= 0) {
+				if (n < 0 && errno == EINTR)
+					continue;
+				if (n < 0)
+					warn_errno(_("cannot read from `%s'"), ff->filename);
+				return size;
+			}
+			got += n;
+		}
+
+		count = memcount(buf, len, '\n');
+		if (count >= lines) {
+			while (len-- > 0) {
+				if (buf[len] == '\n' && --lines == 0)
+					return start + len + 1;
+			}
+		}
+		lines -= count;
+		end = start;
+	}
+
+	return 0;
+}
+
+/* Open a file for the first time, positioned at the start of its
+ * last lines.
+ */
+static bool
+start_file(FollowFile *ff, uint32_t lines, char *buf)
+{
+	if (!open_file(ff, true))
+		return false;
+	if (lines != 0 && !ff->stream) {
+		ff->offset = tail_offset(ff, ff->offset, lines, buf);
+		lseek(ff->fd, ff->offset, SEEK_SET);
+	}
+	return true;
+}
+
+/* Read what has been added to a file since it was last checked. A file
+ * that has shrunk was truncated in place (as with copytruncate), so it
+ * is read again from the start. A file that has been replaced by
+ * another with the same name (rotated) is read to the end before the
+ * new one is opened and read from its start.
+ */
+static void
+check_file(FollowFile *ff, char *buf, FollowHandler handler, void *userdata)
+{
+	struct stat sb;
+
+	if (ff->done)
+		return;
+	if (ff->fd < 0) {
+		if (!open_file(ff, false))
+			return;
+	}
+
+	if (ff->stream) {
+		if (!read_file(ff, buf, handler, userdata)) {
+			flush_partial(ff, handler, userdata);
+			unwatch_stream(ff);
+			if (ff->fd != STDIN_FILENO)
+				close(ff->fd);
+			ff->fd = -1;
+			ff->done = true;
+		}
+		return;
+	}
+
+	if (fstat(ff->fd, &sb) == 0 && sb.st_size < ff->offset) {
+		lseek(ff->fd, 0, SEEK_SET);
+		ff->offset = 0;
+		flush_partial(ff, handler, userdata);
+	}
+	read_file(ff, buf, handler, userdata);
+
+	if (stat(ff->filename, &sb) < 0 || sb.st_dev != ff->dev || sb.st_ino != ff->ino) {
+		flush_partial(ff, handler, userdata);
+		close(ff->fd);
+		ff->fd = -1;
+		if (open_file(ff, false))
+			read_file(ff, buf, handler, userdata);
+	}
+}
+
+/* Resume reading a file from the checkpoint in the state file. If the
+ * file has been replaced since then, the new file is read from its
+ * start, and if it has been truncated, from the start as well.
+ */
+static void
+resume_file(FollowFile *ff, dev_t dev, ino_t ino, off_t offset)
+{
+	if (!open_file(ff, false) || ff->stream)
+		return;
+	if (ff->dev == dev && ff->ino == ino && lseek(ff->fd, 0, SEEK_END) >= offset) {
+		lseek(ff->fd, offset, SEEK_SET);
+		ff->offset = offset;
+	} else {
+		lseek(ff->fd, 0, SEEK_SET);
+	}
+}
+
+/* The state file has one line for each open followed file, with the
+ * device and inode numbers of the file, the offset of the first byte
+ * not yet passed to the handler, and the file name. Partial lines are
+ * not saved; they are read again from the file on resume.
+ */
+static void
+load_state(const char *state_file, FollowFile *files, uint32_t count, uint32_t lines, char *buf)
+{
+	FILE *fh;
+	char *line = NULL;
+	size_t linesize = 0;
+	bool *resumed = xmalloc(count * sizeof(bool));
+	uint32_t c;
+
+	memset(resumed, 0, count * sizeof(bool));
+	fh = fopen(state_file, "r");
+	if (fh == NULL) {
+		if (errno != ENOENT)
+			warn_errno(_("cannot open `%s'"), state_file);
+	} else {
+		while (getline(&line, &linesize, fh) != -1) {
+			unsigned long long dev;
+			unsigned long long ino;
+			long long offset;
+			int pos;
+
+			chomp(line);
+			if (sscanf(line, "%llu %llu %lld %n", &dev, &ino, &offset, &pos) < 3)
+				continue;
+			for (c = 0; c < count; c++) {
+				if (!resumed[c] && strcmp(files[c].filename, line+pos) == 0) {
+					resume_file(&files[c], dev, ino, offset);
+					resumed[c] = true;
+					break;
+				}
+			}
+		}
+		free(line);
+		fclose(fh);
+	}
+
+	for (c = 0; c < count; c++) {
+		if (!resumed[c])
+			start_file(&files[c], lines, buf);
+	}
+	free(resumed);
+}
+
+/* Write the state file anew and rename it into place, so that a
+ * crash never leaves a partially written state file behind.
+ */
+static void
+save_state(const char *state_file, FollowFile *files, uint32_t count)
+{
+	char *tmp_file = xasprintf("%s.tmp", state_file);
+	FILE *fh;
+	uint32_t c;
+
+	fh = fopen(tmp_file, "w");
+	if (fh == NULL) {
+		warn_errno(_("cannot create `%s'"), tmp_file);
+		free(tmp_file);
+		return;
+	}
+	for (c = 0; c < count; c++) {
+		FollowFile *ff = &files[c];
+		if (ff->fd >= 0 && !ff->stream) {
+			fprintf(fh, "%llu %llu %lld %s\n",
+				(unsigned long long) ff->dev,
+				(unsigned long long) ff->ino,
+				(long long) (ff->offset - strbuf_length(ff->partial)),
+				ff->filename);
+		}
+	}
+	if (fclose(fh) != 0 || rename(tmp_file, state_file) < 0)
+		warn_errno(_("cannot write `%s'"), state_file);
+	free(tmp_file);
+}
+
+static void
+stop_handler(int signal)
+{
+	stop_signal = signal;
+}
+
+/**
+ * Return the time of day in milliseconds.
+ */
+int64_t
+current_millis(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (int64_t) tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+static void
+read_events(void)
+{
+	char events[4096];
+
+	if (read(inotify_fd, events, sizeof(events)) < 0 && errno != EINTR && errno != EAGAIN)
+		die_errno(_("cannot read inotify events"));
+}
+
+/* Wait until there might be something new to read, but no longer than
+ * timeout milliseconds (-1 for no limit). Streams are waited for along
+ * with inotify, in one epoll set where available. Events themselves
+ * are not looked at, since all files are checked after every wakeup.
+ */
+static void
+wait_for_change(FollowFile *files, uint32_t count, int timeout)
+{
+	struct pollfd *pfds;
+	bool polling = false;
+	uint32_t c;
+	int n = 0;
+
+	for (c = 0; c < count; c++) {
+		if (!files[c].stream && (inotify_fd < 0 || need_poll))
+			polling = true;
+	}
+	if (polling)
+		timeout = (timeout < 0 ? FOLLOW_POLL_INTERVAL : MIN(timeout, FOLLOW_POLL_INTERVAL));
+
+#ifdef HAVE_SYS_EPOLL_H
+	if (epoll_fd >= 0) {
+		struct epoll_event events[FOLLOW_MAX_EVENTS];
+		int d;
+
+		n = epoll_wait(epoll_fd, events, FOLLOW_MAX_EVENTS, timeout);
+		for (d = 0; d < n; d++) {
+			if (events[d].data.fd == inotify_fd)
+				read_events();
+		}
+		return;
+	}
+#endif
+
+	pfds = xmalloc((count+1) * sizeof(struct pollfd));
+	if (inotify_fd >= 0) {
+		pfds[n].fd = inotify_fd;
+		pfds[n].events = POLLIN;
+		n++;
+	}
+	for (c = 0; c < count; c++) {
+		if (files[c].stream && files[c].fd >= 0) {
+			pfds[n].fd = files[c].fd;
+			pfds[n].events = POLLIN;
+			n++;
+		}
+	}
+	if (poll(pfds, n, timeout) > 0 && inotify_fd >= 0 && (pfds[0].revents & POLLIN) != 0)
+		read_events();
+	free(pfds);
+}
+
+/**
+ * Follow files like `tail -F', passing every line added to them to a
+ * handler along with the userdata of their source. Files are read from
+ * the start of their last lines, or from where they were left according
+ * to state_file if that is not NULL. Files that do not exist yet are
+ * waited for. Sources that are streams (FIFOs, sockets and standard in)
+ * are read as data arrives, each keeping its own partial line. This
+ * function only returns when all sources are streams that have ended,
+ * or (by exiting) when terminated by a signal while keeping state.
+ */
+void
+follow_files(FollowSource *sources, uint32_t count, uint32_t lines, const char *state_file, FollowHandler handler)
+{
+	FollowFile *files = xmalloc(count * sizeof(FollowFile));
+	char *buf = xmalloc(FOLLOW_BLOCK_SIZE);
+	int64_t saved = 0;
+	bool dirty = false;
+	uint32_t c;
+
+#ifdef HAVE_SYS_INOTIFY_H
+	inotify_fd = inotify_init();
+#endif
+#ifdef HAVE_SYS_EPOLL_H
+	epoll_fd = epoll_create(count+1);
+	if (epoll_fd >= 0 && inotify_fd >= 0) {
+		struct epoll_event event;
+
+		memset(&event, 0, sizeof(struct epoll_event));
+		event.events = EPOLLIN;
+		event.data.fd = inotify_fd;
+		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, inotify_fd, &event);
+	}
+#endif
+
+	for (c = 0; c < count; c++) {
+		files[c].filename = sources[c].filename;
+		files[c].fd = -1;
+		files[c].wd = -1;
+		files[c].partial = strbuf_new();
+		files[c].done = false;
+		files[c].stream = false;
+		files[c].userdata = sources[c].userdata;
+		if (strcmp(files[c].filename, "-") != 0)
+			watch_directory(&files[c]);
+	}
+
+	if (state_file != NULL) {
+		struct sigaction action;
+
+		memset(&action, 0, sizeof(struct sigaction));
+		action.sa_handler = stop_handler;
+		sigaction(SIGINT, &action, NULL);
+		sigaction(SIGTERM, &action, NULL);
+		sigaction(SIGHUP, &action, NULL);
+		load_state(state_file, files, count, lines, buf);
+	} else {
+		for (c = 0; c < count; c++)
+			start_file(&files[c], lines, buf);
+	}
+
+	for (;;) {
+		int timeout = -1;
+		bool done = true;
+
+		for (c = 0; c < count; c++) {
+			off_t offset = files[c].offset;
+			ino_t ino = files[c].ino;
+			check_file(&files[c], buf, handler, files[c].userdata);
+			if (files[c].offset != offset || files[c].ino != ino)
+				dirty = true;
+			if (!files[c].done)
+				done = false;
+		}
+
+		/* Lines are written before their offsets are saved, so that
+		 * nothing is lost if remark is killed in between.
+		 */
+		flush_output();
+		if (state_file != NULL) {
+			if (stop_signal != 0) {
+				finish_output();
+				save_state(state_file, files, count);
+				exit(0);
+			}
+			if (dirty) {
+				int64_t now = current_millis();
+				if (now - saved >= FOLLOW_SAVE_INTERVAL) {
+					save_state(state_file, files, count);
+					saved = now;
+					dirty = false;
+				} else {
+					timeout = FOLLOW_SAVE_INTERVAL - (now - saved);
+				}
+			}
+		}
+
+		if (done)
+			break;
+		wait_for_change(files, count, timeout);
+	}
+
+	for (c = 0; c < count; c++)
+		strbuf_free(files[c].partial);
+#ifdef HAVE_SYS_EPOLL_H
+	if (epoll_fd >= 0)
+		close(epoll_fd);
+	epoll_fd = -1;
+#endif
+	if (inotify_fd >= 0)
+		close(inotify_fd);
+	inotify_fd = -1;
+	free(files);
+	free(buf);
+}
+
+static void
+keep_line(char *line, void *userdata)
+{
+	TailLines *tl = userdata;
+
+	llist_add_last(tl->list, xstrdup(line));
+	if (llist_size(tl->list) > tl->lines)
+		free(llist_remove_first(tl->list));
+}
+
+/* Pass the last lines of an open file to the handler. Files that
+ * cannot be seeked, such as pipes, are read through, keeping only as
+ * many lines as needed in memory.
+ */
+static void
+tail_fd(FollowFile *ff, uint32_t lines, char *buf, FollowHandler handler, void *userdata)
+{
+	struct stat sb;
+
+	if (fstat(ff->fd, &sb) == 0 && S_ISREG(sb.st_mode)) {
+		ff->offset = tail_offset(ff, sb.st_size, lines, buf);
+		lseek(ff->fd, ff->offset, SEEK_SET);
+		read_file(ff, buf, handler, userdata);
+		flush_partial(ff, handler, userdata);
+	} else if (lines != 0) {
+		TailLines tl;
+		char *line;
+
+		tl.list = llist_new();
+		tl.lines = lines;
+		read_file(ff, buf, keep_line, &tl);
+		flush_partial(ff, keep_line, &tl);
+		while ((line = llist_remove_first(tl.list)) != NULL) {
+			handler(line, userdata);
+			free(line);
+		}
+		llist_free(tl.list);
+	}
+}
+
+/**
+ * Pass the last lines of files to a handler, like `tail -n'. If
+ * no files are specified, standard in is read.
+ */
+void
+tail_files(char **filenames, uint32_t count, uint32_t lines, FollowHandler handler, void *userdata)
+{
+	char *buf = xmalloc(FOLLOW_BLOCK_SIZE);
+	FollowFile ff;
+	uint32_t c;
+
+	ff.wd = -1;
+	ff.partial = strbuf_new();
+	ff.done = false;
+	ff.stream = false;
+
+	if (count == 0) {
+		ff.filename = _("standard in");
+		ff.fd = STDIN_FILENO;
+		tail_fd(&ff, lines, buf, handler, userdata);
+	}
+
+	for (c = 0; c < count; c++) {
+		ff.filename = filenames[c];
+		ff.fd = open(ff.filename, O_RDONLY);
+		if (ff.fd < 0) {
+			warn_errno(_("cannot open `%s'"), ff.filename);
+			continue;
+		}
+		tail_fd(&ff, lines, buf, handler, userdata);
+		close(ff.fd);
+	}
+
+	strbuf_free(ff.partial);
+	free(buf);
+}
+
+/* Parse the time at the start of a line. Fields that time_format
+ * does not mention, such as the year of syslog times, are left zero.
+ */
+static bool
+parse_time(const char *str, struct tm *tm)
+{
+	memset(tm, 0, sizeof(struct tm));
+	return strptime(str, time_format, tm) != NULL;
+}
+
+static int
+compare_time(const struct tm *t1, const struct tm *t2)
+{
+	if (t1->tm_year != t2->tm_year)
+		return t1->tm_year - t2->tm_year;
+	if (t1->tm_mon != t2->tm_mon)
+		return t1->tm_mon - t2->tm_mon;
+	if (t1->tm_mday != t2->tm_mday)
+		return t1->tm_mday - t2->tm_mday;
+	if (t1->tm_hour != t2->tm_hour)
+		return t1->tm_hour - t2->tm_hour;
+	if (t1->tm_min != t2->tm_min)
+		return t1->tm_min - t2->tm_min;
+	return t1->tm_sec - t2->tm_sec;
+}
+
+/* Find the first line that starts at or after pos. Returns -1 at the
+ * end of the file.
+ */
+static off_t
+next_line(FollowFile *ff, off_t pos, char *buf)
+{
+	if (pos == 0)
+		return 0;
+
+	/* A line starts at pos if the byte before it is a newline. */
+	for (pos--; ; ) {
+		ssize_t n = pread(ff->fd, buf, FOLLOW_PROBE_SIZE, pos);
+		char *nl;
+
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return -1;
+		nl = memchr(buf, '\n', n);
+		if (nl != NULL)
+			return pos + (nl - buf) + 1;
+		pos += n;
+	}
+}
+
+/* Find the first line at or after pos with a time, and parse it.
+ * Returns size if there is no such line.
+ */
+static off_t
+next_timed_line(FollowFile *ff, off_t pos, off_t size, char *buf, struct tm *tm)
+{
+	for (pos = next_line(ff, pos, buf); pos >= 0 && pos < size; pos = next_line(ff, pos+1, buf)) {
+		ssize_t n = pread(ff->fd, buf, FOLLOW_PROBE_SIZE-1, pos);
+		char *nl;
+
+		if (n <= 0)
+			break;
+		buf[n] = '\0';
+		nl = memchr(buf, '\n', n);
+		if (nl != NULL)
+			*nl = '\0';
+		if (parse_time(buf, tm))
+			return pos;
+	}
+	return size;
+}
+
+/* Find where the lines from a time onwards start in a file sorted by
+ * time, by bisecting byte offsets. Each step reads the first timed
+ * line after an offset, so only O(log n) blocks are read. Lines
+ * without a time right before the result belong to an earlier line
+ * and are skipped.
+ */
+static off_t
+since_offset(FollowFile *ff, off_t size, const struct tm *since, char *buf)
+{
+	off_t lo = 0;
+	off_t hi = size;
+	struct tm tm;
+
+	while (lo < hi) {
+		off_t mid = lo + (hi - lo) / 2;
+		off_t pos = next_timed_line(ff, mid, size, buf, &tm);
+
+		if (pos == size || compare_time(&tm, since) >= 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return next_timed_line(ff, lo, size, buf, &tm);
+}
+
+/* Pass on the lines within the time window. Lines without a time
+ * belong to the line before them. Reading stops at the first line
+ * after the window.
+ */
+static void
+window_line(char *line, void *userdata)
+{
+	TimeWindow *tw = userdata;
+	struct tm tm;
+
+	if (parse_time(line, &tm)) {
+		if (tw->has_until && compare_time(&tm, &tw->until) > 0) {
+			tw->ff->done = true;
+			return;
+		}
+		if (!tw->started && (!tw->has_since || compare_time(&tm, &tw->since) >= 0))
+			tw->started = true;
+	}
+	if (tw->started)
+		tw->handler(line, tw->userdata);
+}
+
+static void
+window_fd(FollowFile *ff, TimeWindow *tw, char *buf)
+{
+	struct stat sb;
+
+	ff->done = false;
+	ff->stream = false;
+	tw->ff = ff;
+	tw->started = !tw->has_since;
+	if (tw->has_since && fstat(ff->fd, &sb) == 0 && S_ISREG(sb.st_mode)) {
+		ff->offset = since_offset(ff, sb.st_size, &tw->since, buf);
+		lseek(ff->fd, ff->offset, SEEK_SET);
+		tw->started = true;
+	}
+	read_file(ff, buf, window_line, tw);
+	if (!ff->done)
+		flush_partial(ff, window_line, tw);
+	strbuf_set_length(ff->partial, 0);
+}
+
+/**
+ * Pass the lines of files sorted by time that fall between two times
+ * (inclusive) to a handler. Either time may be NULL. Times are parsed
+ * with time_format. If no files are specified, standard in is read.
+ */
+void
+window_files(char **filenames, uint32_t count, const char *since, const char *until, FollowHandler handler, void *userdata)
+{
+	char *buf = xmalloc(FOLLOW_BLOCK_SIZE);
+	TimeWindow tw;
+	FollowFile ff;
+	uint32_t c;
+
+	tw.has_since = (since != NULL);
+	tw.has_until = (until != NULL);
+	if (since != NULL && !parse_time(since, &tw.since))
+		die(_("invalid time: %s"), since);
+	if (until != NULL && !parse_time(until, &tw.until))
+		die(_("invalid time: %s"), until);
+	tw.handler = handler;
+	tw.userdata = userdata;
+
+	ff.wd = -1;
+	ff.partial = strbuf_new();
+
+	if (count == 0) {
+		ff.filename = _("standard in");
+		ff.fd = STDIN_FILENO;
+		window_fd(&ff, &tw, buf);
+	}
+
+	for (c = 0; c < count; c++) {
+		ff.filename = filenames[c];
+		ff.fd = open(ff.filename, O_RDONLY);
+		if (ff.fd < 0) {
+			warn_errno(_("cannot open `%s'"), ff.filename);
+			continue;
+		}
+		window_fd(&ff, &tw, buf);
+		close(ff.fd);
+	}
+
+	strbuf_free(ff.partial);
+	free(buf);
+}
+
+/**
+ * Pass the lines read from a file descriptor such as standard in to a
+ * handler, writing the output of each block read at once. If timeout
+ * is not negative, a partial line that has not been completed within
+ * that many milliseconds is passed to partial_handler, and what
+ * follows of it later on is passed as a line of its own.
+ */
+void
+stream_fd(int fd, const char *filename, int timeout, FollowHandler handler, FollowHandler partial_handler, void *userdata)
+{
+	char *buf = xmalloc(FOLLOW_BLOCK_SIZE);
+	FollowFile ff;
+
+	ff.filename = filename;
+	ff.fd = fd;
+	ff.wd = -1;
+	ff.partial = strbuf_new();
+	ff.done = false;
+
+	for (;;) {
+		ssize_t len;
+
+		if (timeout >= 0 && strbuf_length(ff.partial) != 0) {
+			struct pollfd pfd;
+
+			pfd.fd = fd;
+			pfd.events = POLLIN;
+			if (poll(&pfd, 1, timeout) == 0) {
+				partial_handler(strbuf_buffer(ff.partial), userdata);
+				strbuf_set_length(ff.partial, 0);
+				flush_output();
+				continue;
+			}
+		}
+
+		len = read(fd, buf, FOLLOW_BLOCK_SIZE);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			/* Pseudo-terminals report EIO once the other end is closed. */
+			if (errno == EIO)
+				break;
+			die_errno(_("cannot read from %s"), filename);
+		}
+		if (len == 0)
+			break;
+		split_lines(&ff, buf, len, handler, userdata);
+		flush_output();
+	}
+	flush_partial(&ff, handler, userdata);
+
+	strbuf_free(ff.partial);
+	free(buf);
+}
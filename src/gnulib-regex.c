@@ -0,0 +1,60 @@
+/* gnulib-regex.c - The included regex matcher under private names.
+ *
+ * Copyright (C) 2001-2005 Oskar Liljeblad
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/* The gnulib regex engine of engine.c. lib/regex.c is only built
+ * into libgnu when the C library lacks a working regex, so it is
+ * compiled here once more with every public name prefixed. This
+ * lets it be linked next to the regex of the C library.
+ *
+ * MBS_SUPPORT is not defined, as its multibyte code has never been
+ * built or tested here, so this matcher works on bytes in any locale.
+ * It is not interchangeable with the C library in a multibyte locale,
+ * and choose_engine in engine.c only picks it on its own where the
+ * two agree.
+ *
+ * Like the lexer, the file is not ours to clean up, so its warnings
+ * are silenced: the unused ones in src/Makefile.am, and the one about
+ * comparing a buffer with its old address after realloc here, as
+ * older compilers do not know that warning option.
+ */
+
+#if __GNUC__ >= 12
+# pragma GCC diagnostic ignored "-Wuse-after-free"
+#endif
+
+#define regcomp gl_regcomp
+#define regexec gl_regexec
+#define regerror gl_regerror
+#define regfree gl_regfree
+#define re_compile_pattern gl_re_compile_pattern
+#define re_compile_fastmap gl_re_compile_fastmap
+#define re_search gl_re_search
+#define re_search_2 gl_re_search_2
+#define re_match gl_re_match
+#define re_match_2 gl_re_match_2
+#define re_set_registers gl_re_set_registers
+#define re_set_syntax gl_re_set_syntax
+#define re_syntax_options gl_re_syntax_options
+#define re_max_failures gl_re_max_failures
+#define re_max_backtracks gl_re_max_backtracks
+#define re_backtracks gl_re_backtracks
+#define re_comp gl_re_comp
+#define re_exec gl_re_exec
+
+#include "regex.c"
@@ -0,0 +1,248 @@
+/* json.c - Locating values in JSON objects.
+ *
+ * Copyright (C) 2001-2005 Oskar Liljeblad
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <config.h>
+#include <stdint.h>		/* Gnulib/C99/POSIX */
+#include <stdlib.h>		/* C89 */
+#include <string.h>		/* C89 */
+#include "xalloc.h"		/* Gnulib */
+#include "minmax.h"		/* Gnulib */
+#include "common/strbuf.h"
+#include "remark.h"
+
+#define JSON_CACHE_SIZE	4
+
+typedef struct _JsonMember JsonMember;
+
+struct _JsonMember {
+	SubmatchSpec key;
+	SubmatchSpec value;
+};
+
+/* The members of the object found in one span of a buffer. An index
+ * is valid as long as the serial of the buffer is unchanged. The
+ * last few indexes of an input are kept in its scratch memory.
+ */
+struct _JsonIndex {
+	MatchBuffer *mb;
+	uint32_t serial;
+	uint32_t so;
+	uint32_t eo;
+	uint32_t count;
+	uint32_t size;
+	JsonMember *members;
+};
+
+static uint32_t skip_space(const char *buf, uint32_t pos, uint32_t eo);
+static uint32_t skip_string(const char *buf, uint32_t pos, uint32_t eo);
+static uint32_t skip_value(const char *buf, uint32_t pos, uint32_t eo);
+static void index_object(JsonIndex *index, const char *buf);
+
+/* Find the value of key in the first JSON object between so and eo.
+ * The value span of strings excludes the quotes. Each span is
+ * tokenized once, so looking up many keys in the same line is cheap.
+ */
+bool
+json_lookup(MatchBuffer *mb, uint32_t so, uint32_t eo, const char *key, uint32_t keylen, SubmatchSpec *value)
+{
+	const char *buf = strbuf_buffer(mb->buffer);
+	MatchScratch *scratch = mb->scratch;
+	JsonIndex *cache = scratch->json;
+	JsonIndex *index = NULL;
+	uint32_t c;
+
+	if (cache == NULL) {
+		cache = scratch->json = xcalloc(JSON_CACHE_SIZE, sizeof(JsonIndex));
+		scratch->allocations++;
+	}
+	for (c = 0; c < JSON_CACHE_SIZE; c++) {
+		if (cache[c].mb == mb && cache[c].serial == mb->serial
+				&& cache[c].so == so && cache[c].eo == eo) {
+			index = &cache[c];
+			break;
+		}
+	}
+	if (index == NULL) {
+		index = &cache[scratch->json_next];
+		scratch->json_next = (scratch->json_next + 1) % JSON_CACHE_SIZE;
+		index->mb = mb;
+		index->serial = mb->serial;
+		index->so = so;
+		index->eo = eo;
+		index_object(index, buf);
+	}
+
+	for (c = 0; c < index->count; c++) {
+		JsonMember *member = &index->members[c];
+		if (member->key.eo - member->key.so == keylen
+				&& memcmp(buf + member->key.so, key, keylen) == 0) {
+			*value = member->value;
+			if (buf[value->so] == '"') {
+				value->so++;
+				value->eo--;
+			}
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void
+json_free_cache(MatchScratch *scratch)
+{
+	uint32_t c;
+
+	if (scratch->json != NULL) {
+		for (c = 0; c < JSON_CACHE_SIZE; c++)
+			free(scratch->json[c].members);
+		free(scratch->json);
+		scratch->json = NULL;
+	}
+}
+
+static void
+add_member(JsonIndex *index, uint32_t key_so, uint32_t key_eo, uint32_t value_so, uint32_t value_eo)
+{
+	JsonMember *member;
+
+	if (index->count >= index->size) {
+		index->size = MAX(16, index->size*2);
+		index->members = xrealloc(index->members, sizeof(JsonMember) * index->size);
+		index->mb->scratch->allocations++;
+	}
+	member = &index->members[index->count++];
+	member->key.so = key_so;
+	member->key.eo = key_eo;
+	member->value.so = value_so;
+	member->value.eo = value_eo;
+}
+
+/* Text before the first `{' is ignored, so that lines with a
+ * timestamp prefix can be indexed. An object that is not well
+ * formed gets no members.
+ */
+static void
+index_object(JsonIndex *index, const char *buf)
+{
+	uint32_t eo = index->eo;
+	const char *p;
+	uint32_t pos;
+
+	index->count = 0;
+	p = memchr(buf + index->so, '{', eo - index->so);
+	if (p == NULL)
+		return;
+
+	pos = skip_space(buf, p - buf + 1, eo);
+	if (pos < eo && buf[pos] == '}')
+		return;
+	while (pos < eo && buf[pos] == '"') {
+		uint32_t key_so = pos;
+		uint32_t key_eo = skip_string(buf, pos, eo);
+		uint32_t value_so;
+		uint32_t value_eo;
+
+		if (key_eo == 0)
+			break;
+		pos = skip_space(buf, key_eo, eo);
+		if (pos >= eo || buf[pos] != ':')
+			break;
+		value_so = skip_space(buf, pos+1, eo);
+		value_eo = skip_value(buf, value_so, eo);
+		if (value_eo == 0 || value_eo == value_so)
+			break;
+		add_member(index, key_so+1, key_eo-1, value_so, value_eo);
+
+		pos = skip_space(buf, value_eo, eo);
+		if (pos < eo && buf[pos] == '}')
+			return;
+		if (pos >= eo || buf[pos] != ',')
+			break;
+		pos = skip_space(buf, pos+1, eo);
+	}
+
+	index->count = 0;
+}
+
+static uint32_t
+skip_space(const char *buf, uint32_t pos, uint32_t eo)
+{
+	while (pos < eo && (buf[pos] == ' ' || buf[pos] == '\t' || buf[pos] == '\r' || buf[pos] == '\n'))
+		pos++;
+	return pos;
+}
+
+/* The functions below return the position after the skipped item,
+ * or 0 if it is not well formed.
+ */
+static uint32_t
+skip_string(const char *buf, uint32_t pos, uint32_t eo)
+{
+	const char *p;
+
+	for (pos++; pos < eo; pos = p - buf + 1) {
+		uint32_t c;
+
+		p = memchr(buf + pos, '"', eo - pos);
+		if (p == NULL)
+			return 0;
+		for (c = p - buf; c > pos && buf[c-1] == '\\'; c--);
+		if (((p - buf) - c) % 2 == 0)
+			return p - buf + 1;
+	}
+
+	return 0;
+}
+
+static uint32_t
+skip_value(const char *buf, uint32_t pos, uint32_t eo)
+{
+	uint32_t depth = 0;
+
+	if (pos >= eo)
+		return 0;
+	if (buf[pos] != '{' && buf[pos] != '[') {
+		if (buf[pos] == '"')
+			return skip_string(buf, pos, eo);
+		while (pos < eo && strchr(",}] \t\r\n", buf[pos]) == NULL)
+			pos++;
+		return pos;
+	}
+
+	while (pos < eo) {
+		char ch = buf[pos];
+
+		if (ch == '"') {
+			pos = skip_string(buf, pos, eo);
+			if (pos == 0)
+				return 0;
+			continue;
+		}
+		if (ch == '{' || ch == '[') {
+			depth++;
+		} else if (ch == '}' || ch == ']') {
+			if (--depth == 0)
+				return pos + 1;
+		}
+		pos++;
+	}
+
+	return 0;
+}
@@ -13,14 +13,15 @@
 
 static RemarkFile *file;
 
-static void fix_reflags(void);
+static void fix_reflags(char endchar);
+static void fix_token(void);
 static void fix_string(bool retain_backslashes, int skip_count, char endchar);
 static void set_string(char *str);
 
 
 
 
-#line 24 "lexer.c"
+#line 25 "lexer.c"
 
 #define  YY_INT_ALIGNED short int
 
@@ -388,8 +389,8 @@ static void yy_fatal_error (yyconst char msg[]  );
 	*yy_cp = '\0'; \
 	(yy_c_buf_p) = yy_cp;
 
-#define YY_NUM_RULES 17
-#define YY_END_OF_BUFFER 18
+#define YY_NUM_RULES 36
+#define YY_END_OF_BUFFER 37
 /* This struct is not used in this scanner,
    but its presence is necessary. */
 struct yy_trans_info
@@ -397,15 +398,22 @@ struct yy_trans_info
 	flex_int32_t yy_verify;
 	flex_int32_t yy_nxt;
 	};
-static yyconst flex_int16_t yy_accept[71] =
+static yyconst flex_int16_t yy_accept[127] =
     {   0,
-        0,    0,   18,   16,    1,   17,   16,    3,   17,    7,
-       16,   16,   16,   16,   16,   16,   16,    1,    0,    4,
-        0,   16,    0,    2,    0,    5,    0,    7,   16,   16,
-       16,   16,   16,   16,    0,   16,   16,   16,    5,   16,
-       16,   16,   16,   16,   12,    0,    6,    0,   15,   16,
-       16,   16,   16,   16,   16,   13,   16,   10,   16,   16,
-       11,   16,    8,   16,    9,   16,   16,   14,   12,    0
+        0,    0,   35,    1,   36,   36,   35,    3,   35,   36,
+        8,   12,   10,   14,   35,   35,   35,   35,   35,   35,
+       35,   35,   35,   35,   35,   35,   35,   35,   35,    1,
+       11,    0,    4,    0,   35,    0,    2,    9,    0,    5,
+        0,   35,    8,   13,   10,   15,    7,   35,   35,   35,
+       35,   35,   35,   34,   35,   35,   35,   35,   17,   35,
+       35,   35,    0,   35,   35,   35,    4,    0,    5,    0,
+        9,    7,   32,   16,   35,   35,   35,   35,   35,   35,
+       35,   35,   18,   35,   23,   35,    0,    6,    0,   26,
+       35,   35,    7,   35,   35,   35,   35,   35,   29,   35,
+
+       35,   24,   35,   35,    0,   21,   35,   35,   22,   30,
+       28,   35,   31,   19,   35,   35,   20,   24,   27,   35,
+       35,   33,   25,   23,   37,    0
     } ;
 
 static yyconst flex_int32_t yy_ec[256] =
@@ -413,17 +421,17 @@ static yyconst flex_int32_t yy_ec[256] =
         1,    1,    1,    1,    1,    1,    1,    1,    2,    3,
         2,    2,    2,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
-        1,    2,    1,    4,    5,    1,    1,    1,    1,    1,
-        1,    1,    1,    6,    1,    1,    7,    8,    8,    8,
-        8,    8,    8,    8,    8,    8,    8,    1,    1,    1,
+        1,    2,    4,    5,    6,    1,    1,    1,    1,    7,
+        7,    1,    1,    7,    8,    9,   10,   11,   11,   11,
+       11,   11,   11,   11,   11,   11,   11,    1,    1,   12,
+       13,   14,    1,   15,    1,    1,    1,    1,    1,    1,
+       16,    1,    1,    1,    1,   16,    1,    1,    1,   16,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
-        1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
-        1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
-        1,    9,    1,    1,    1,    1,   10,   11,   12,   13,
+        1,   17,    1,    1,    1,    1,   18,   19,   20,   21,
 
-       14,    1,   15,    1,   16,    1,   17,   18,   19,   20,
-       21,   22,    1,   23,   24,   25,   26,    1,    1,    1,
-       27,    1,    6,    1,    6,    1,    1,    1,    1,    1,
+       22,   23,   24,   25,   26,   27,   28,   29,   30,   31,
+       32,   33,   25,   34,   35,   36,   37,   38,   25,   25,
+       39,   25,    7,    1,    7,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
@@ -440,81 +448,176 @@ static yyconst flex_int32_t yy_ec[256] =
         1,    1,    1,    1,    1
     } ;
 
-static yyconst flex_int32_t yy_meta[28] =
+static yyconst flex_int32_t yy_meta[40] =
     {   0,
-        1,    2,    2,    2,    1,    2,    2,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
-        1,    1,    1,    1,    1,    1,    1
+        1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
+        1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
+        1,    1,    1,    1,    1,    1,    1,    1,    1
     } ;
 
-static yyconst flex_int16_t yy_base[77] =
+static yyconst flex_int16_t yy_base[127] =
     {   0,
-        0,    0,  113,    0,   26,   26,   34,  114,   24,  104,
-       89,   87,   89,   98,   11,   32,    0,   40,   41,  114,
-      104,   56,  103,  114,   44,   32,  102,   96,   81,   88,
-       89,   88,   75,   84,   45,   72,   80,   68,   40,   80,
-       83,   74,   68,   65,   67,   57,  114,   85,    0,   65,
-       68,   65,   67,   57,   61,    0,   67,    0,   66,   66,
-        0,   65,    0,   57,    0,   51,   48,    0,    0,  114,
-       43,   66,   68,   70,   72,   74
+        0,    1,   39,   40,   28,   78,  117,    2,   33,  156,
+       42,   36,  183,  184,  187,  206,   12,   21,  173,  169,
+      166,  180,  185,  172,  194,  197,  208,  222,    3,    4,
+        5,    6,  209,  255,    7,  294,    8,  225,    9,  227,
+      333,  229,   10,   11,   13,   14,  226,  217,  220,  212,
+      224,  211,  230,  228,  210,  231,  234,  219,   15,  261,
+      275,  268,  372,  263,  278,  262,   16,   17,   18,   19,
+       20,  282,   22,   23,  285,  318,  390,  384,  385,  386,
+      377,  382,   24,  383,  387,  389,   25,   26,  421,   27,
+      391,  432,   29,  431,  435,  430,  397,  428,   30,  444,
+
+      436,   31,  445,  433,   32,   34,  447,  449,   35,   37,
+      437,  452,   38,   41,  443,  453,   43,   44,   45,  454,
+      456,   46,   47,   48,  478,  479
     } ;
 
-static yyconst flex_int16_t yy_def[77] =
+static yyconst flex_int16_t yy_def[127] =
     {   0,
-       70,    1,   70,   71,   70,   72,   73,   70,   74,   71,
-       71,   71,   71,   71,   71,   71,   71,   70,   72,   70,
-       72,   73,   75,   70,   74,   70,   74,   71,   71,   71,
-       71,   71,   71,   71,   76,   71,   71,   71,   70,   71,
-       71,   71,   71,   71,   71,   76,   70,   76,   71,   71,
-       71,   71,   71,   71,   71,   71,   71,   71,   71,   71,
-       71,   71,   71,   71,   71,   71,   71,   71,   71,    0,
-       70,   70,   70,   70,   70,   70
+      126,    1,  126,  126,  126,  126,  126,  126,    3,  126,
+        3,  126,  126,  126,    3,    3,    3,    3,    3,    3,
+        3,    3,    3,    3,    3,    3,    3,    3,    3,    4,
+      126,    6,  126,  126,    7,    7,  126,    9,   10,  126,
+      126,    3,   11,  126,  126,  126,   15,    3,    3,    3,
+        3,    3,    3,    3,    3,    3,    3,    3,    3,    3,
+        3,    3,  126,    3,    3,    3,   33,    6,   40,   10,
+       42,  126,    3,    3,    3,    3,    3,    3,    3,    3,
+        3,    3,    3,    3,    3,    3,   63,  126,  126,    3,
+        3,    3,   72,    3,    3,    3,    3,    3,    3,    3,
+
+        3,    3,    3,    3,   63,    3,    3,    3,    3,    3,
+        3,    3,    3,    3,    3,    3,    3,    3,    3,    3,
+        3,    3,    3,    3,  126,    0
     } ;
 
-static yyconst flex_int16_t yy_nxt[142] =
+static yyconst flex_int16_t yy_nxt[519] =
     {   0,
-        4,    5,    5,    6,    7,    8,    9,   10,    4,   11,
-       12,    4,    4,    4,    4,   13,    4,    4,   14,    4,
-        4,   15,    4,   16,    4,    4,    4,   18,   18,   20,
-       26,   33,   27,   34,   21,   23,   24,   23,   35,   23,
-       23,   18,   18,   17,   20,   36,   39,   39,   37,   21,
-       26,   47,   27,   48,   39,   39,   38,   23,   24,   23,
-       69,   23,   23,   47,   68,   48,   19,   19,   22,   22,
-       25,   25,   23,   23,   46,   46,   67,   66,   56,   65,
-       64,   63,   62,   61,   60,   59,   58,   70,   57,   56,
-       55,   54,   53,   52,   51,   50,   49,   45,   44,   43,
-
-       42,   41,   40,   28,   70,   24,   70,   32,   31,   30,
-       29,   28,   70,    3,   70,   70,   70,   70,   70,   70,
+        3,    4,    4,    5,    6,    7,    8,    9,    3,   10,
+       11,   12,   13,   14,   15,    3,    3,   16,   17,    3,
+        3,   18,   19,    3,    3,   20,   21,    3,   22,   23,
+       24,   25,   26,   27,   28,    3,    3,    3,    3,   29,
+       31,   30,   30,   38,   29,   51,   29,   29,   44,   29,
+       42,   52,   43,   29,   29,   29,   29,   29,   29,   29,
+       29,   29,   29,   29,   29,   29,   29,   29,   29,   29,
+       29,   29,   29,   29,   29,   29,   29,   29,   32,   32,
+       32,   32,   33,   32,   32,   32,   32,   32,   32,   32,
+       32,   32,   32,   32,   34,   32,   32,   32,   32,   32,
+
+       32,   32,   32,   32,   32,   32,   32,   32,   32,   32,
+       32,   32,   32,   32,   32,   32,   32,   35,   36,   37,
+       36,   36,   35,   36,   35,   35,   36,   35,   36,   36,
+       36,   35,   35,   35,   35,   35,   35,   35,   35,   35,
+       35,   35,   35,   35,   35,   35,   35,   35,   35,   35,
+       35,   35,   35,   35,   35,   35,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   40,   39,   39,   39,   39,
+       39,   39,   41,   39,   39,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   45,   46,   47,   53,   54,
+
+       55,   56,   57,   58,   47,   47,   47,   47,   47,   47,
+       47,   47,   47,   47,   47,   47,   47,   47,   47,   47,
+       47,   47,   47,   47,   47,   47,   48,   59,   60,   62,
+       61,   63,   67,   42,   67,   72,   49,   73,   50,   71,
+       74,   80,   69,   64,   75,   76,   77,   79,   81,   65,
+       69,   78,   69,   82,   83,   68,   68,   66,   68,   68,
+       68,   68,   68,   68,   68,   68,   68,   68,   68,   68,
+       68,   68,   68,   68,   68,   68,   68,   68,   68,   68,
+       68,   68,   68,   68,   68,   68,   68,   68,   68,   68,
+       68,   68,   68,   68,   36,   84,   85,   86,   90,   36,
+
+       92,   36,   36,   91,   36,   93,   94,   93,   36,   36,
+       36,   36,   36,   36,   36,   36,   36,   36,   36,   36,
+       36,   36,   36,   36,   36,   36,   36,   36,   36,   36,
+       36,   36,   36,   70,   70,   95,   70,   70,   70,   70,
        70,   70,   70,   70,   70,   70,   70,   70,   70,   70,
        70,   70,   70,   70,   70,   70,   70,   70,   70,   70,
-       70
+       70,   70,   70,   70,   70,   70,   70,   70,   70,   70,
+       70,   70,   87,   87,   87,   87,   87,   87,   87,   87,
+       87,   88,   87,   87,   87,   87,   87,   87,   89,   87,
+       87,   87,   87,   87,   87,   87,   87,   87,   87,   87,
+
+       87,   87,   87,   87,   87,   87,   87,   87,   87,   87,
+       87,   96,   97,   98,  100,  101,   99,  111,  102,  103,
+      104,  105,  105,  106,  105,  105,  105,  105,  105,  105,
+      105,  105,  105,  105,  105,  105,  105,  105,  105,  105,
+      105,  105,  105,  105,  105,  105,  105,  105,  105,  105,
+      105,  105,  105,  105,  105,  105,  105,  105,  105,  105,
+      107,  108,  109,  110,  112,  113,  115,  114,  117,  118,
+      116,  119,  120,  121,  122,  123,  124,  126,  125,  126,
+      126,  126,  126,  126,  126,  126,  126,  126,  126,  126,
+      126,  126,  126,  126,  126,  126,  126,  126,  126,  126,
+
+      126,  126,  126,  126,  126,  126,  126,  126,  126,  126,
+      126,  126,  126,  126,  126,  126,  126,  126
     } ;
 
-static yyconst flex_int16_t yy_chk[142] =
+static yyconst flex_int16_t yy_chk[519] =
     {   0,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
-        1,    1,    1,    1,    1,    1,    1,    5,    5,    6,
-        9,   15,    9,   15,    6,    7,    7,    7,   16,    7,
-        7,   18,   18,   71,   19,   16,   26,   26,   16,   19,
-       25,   35,   25,   35,   39,   39,   16,   22,   22,   22,
-       67,   22,   22,   46,   66,   46,   72,   72,   73,   73,
-       74,   74,   75,   75,   76,   76,   64,   62,   60,   59,
-       57,   55,   54,   53,   52,   51,   50,   48,   45,   44,
-       43,   42,   41,   40,   38,   37,   36,   34,   33,   32,
-
-       31,   30,   29,   28,   27,   23,   21,   14,   13,   12,
-       11,   10,    3,   70,   70,   70,   70,   70,   70,   70,
-       70,   70,   70,   70,   70,   70,   70,   70,   70,   70,
-       70,   70,   70,   70,   70,   70,   70,   70,   70,   70,
-       70
+        1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
+        1,    1,    1,    1,    1,    1,    1,    1,    1,    3,
+        5,    4,    4,    9,    3,   17,    3,    3,   12,    3,
+       11,   18,   11,    3,    3,    3,    3,    3,    3,    3,
+        3,    3,    3,    3,    3,    3,    3,    3,    3,    3,
+        3,    3,    3,    3,    3,    3,    3,    3,    6,    6,
+        6,    6,    6,    6,    6,    6,    6,    6,    6,    6,
+        6,    6,    6,    6,    6,    6,    6,    6,    6,    6,
+
+        6,    6,    6,    6,    6,    6,    6,    6,    6,    6,
+        6,    6,    6,    6,    6,    6,    6,    7,    7,    7,
+        7,    7,    7,    7,    7,    7,    7,    7,    7,    7,
+        7,    7,    7,    7,    7,    7,    7,    7,    7,    7,
+        7,    7,    7,    7,    7,    7,    7,    7,    7,    7,
+        7,    7,    7,    7,    7,    7,   10,   10,   10,   10,
+       10,   10,   10,   10,   10,   10,   10,   10,   10,   10,
+       10,   10,   10,   10,   10,   10,   10,   10,   10,   10,
+       10,   10,   10,   10,   10,   10,   10,   10,   10,   10,
+       10,   10,   10,   10,   10,   13,   14,   15,   19,   20,
+
+       21,   22,   23,   24,   15,   15,   15,   15,   15,   15,
+       15,   15,   15,   15,   15,   15,   15,   15,   15,   15,
+       15,   15,   15,   15,   15,   15,   16,   25,   26,   27,
+       26,   28,   33,   38,   33,   47,   16,   48,   16,   42,
+       49,   55,   40,   28,   50,   51,   52,   54,   56,   28,
+       40,   53,   40,   57,   58,   34,   34,   28,   34,   34,
+       34,   34,   34,   34,   34,   34,   34,   34,   34,   34,
+       34,   34,   34,   34,   34,   34,   34,   34,   34,   34,
+       34,   34,   34,   34,   34,   34,   34,   34,   34,   34,
+       34,   34,   34,   34,   36,   60,   61,   62,   64,   36,
+
+       66,   36,   36,   65,   36,   72,   75,   72,   36,   36,
+       36,   36,   36,   36,   36,   36,   36,   36,   36,   36,
+       36,   36,   36,   36,   36,   36,   36,   36,   36,   36,
+       36,   36,   36,   41,   41,   76,   41,   41,   41,   41,
+       41,   41,   41,   41,   41,   41,   41,   41,   41,   41,
+       41,   41,   41,   41,   41,   41,   41,   41,   41,   41,
+       41,   41,   41,   41,   41,   41,   41,   41,   41,   41,
+       41,   41,   63,   63,   63,   63,   63,   63,   63,   63,
+       63,   63,   63,   63,   63,   63,   63,   63,   63,   63,
+       63,   63,   63,   63,   63,   63,   63,   63,   63,   63,
+
+       63,   63,   63,   63,   63,   63,   63,   63,   63,   63,
+       63,   77,   78,   79,   81,   82,   80,   97,   84,   85,
+       86,   89,   89,   91,   89,   89,   89,   89,   89,   89,
+       89,   89,   89,   89,   89,   89,   89,   89,   89,   89,
+       89,   89,   89,   89,   89,   89,   89,   89,   89,   89,
+       89,   89,   89,   89,   89,   89,   89,   89,   89,   89,
+       92,   94,   95,   96,   98,  100,  103,  101,  107,  108,
+      104,  111,  112,  115,  116,  120,  121,  125,  126,  126,
+      126,  126,  126,  126,  126,  126,  126,  126,  126,  126,
+      126,  126,  126,  126,  126,  126,  126,  126,  126,  126,
+
+      126,  126,  126,  126,  126,  126,  126,  126,  126,  126,
+      126,  126,  126,  126,  126,  126,  126,  126
     } ;
 
 /* Table of booleans, true if rule could match eol. */
-static yyconst flex_int32_t yy_rule_can_match_eol[18] =
+static yyconst flex_int32_t yy_rule_can_match_eol[37] =
     {   0,
-1, 1, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,     };
+1, 1, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,     };
 
 static yy_state_type yy_last_accepting_state;
 static char *yy_last_accepting_cpos;
@@ -550,7 +653,7 @@ char *yytext;
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
  */
 
-#line 554 "lexer.c"
+#line 657 "lexer.c"
 
 #define INITIAL 0
 
@@ -701,10 +804,10 @@ YY_DECL
 	register char *yy_cp, *yy_bp;
 	register int yy_act;
     
-#line 47 "lexer.l"
+#line 49 "lexer.l"
 
 
-#line 708 "lexer.c"
+#line 811 "lexer.c"
 
 	if ( (yy_init) )
 		{
@@ -757,13 +860,13 @@ yy_match:
 			while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 				{
 				yy_current_state = (int) yy_def[yy_current_state];
-				if ( yy_current_state >= 71 )
+				if ( yy_current_state >= 127 )
 					yy_c = yy_meta[(unsigned int) yy_c];
 				}
 			yy_current_state = yy_nxt[yy_base[yy_current_state] + (unsigned int) yy_c];
 			++yy_cp;
 			}
-		while ( yy_base[yy_current_state] != 114 );
+		while ( yy_base[yy_current_state] != 479 );
 
 yy_find_action:
 		yy_act = yy_accept[yy_current_state];
@@ -800,98 +903,193 @@ do_action:	/* This label is used only to access EOF actions. */
 case 1:
 /* rule 1 can match eol */
 YY_RULE_SETUP
-#line 49 "lexer.l"
+#line 51 "lexer.l"
 
 	YY_BREAK
 case 2:
 /* rule 2 can match eol */
 YY_RULE_SETUP
-#line 50 "lexer.l"
+#line 52 "lexer.l"
 
 	YY_BREAK
 case 3:
 YY_RULE_SETUP
-#line 51 "lexer.l"
+#line 53 "lexer.l"
 return yytext[0];
 	YY_BREAK
 case 4:
 /* rule 4 can match eol */
 YY_RULE_SETUP
-#line 52 "lexer.l"
-fix_string(false, 0, '"'); return STRING;
+#line 54 "lexer.l"
+fix_reflags('"'); fix_string(false, 0, '"'); return LITERAL;
 	YY_BREAK
 case 5:
 /* rule 5 can match eol */
 YY_RULE_SETUP
-#line 53 "lexer.l"
-fix_reflags(); fix_string(true, 0, '/'); return MATCH;
+#line 55 "lexer.l"
+fix_reflags('/'); fix_string(true, 0, '/'); return MATCH;
 	YY_BREAK
 case 6:
 /* rule 6 can match eol */
 YY_RULE_SETUP
-#line 54 "lexer.l"
+#line 56 "lexer.l"
 fix_string(true, 1, '/'); unput('/'); return SUBST;
 	YY_BREAK
 case 7:
 YY_RULE_SETUP
-#line 55 "lexer.l"
-parse_int32(yytext, &yylval.number); return NUMBER;
+#line 57 "lexer.l"
+fix_token(); return TOKEN;
 	YY_BREAK
 case 8:
 YY_RULE_SETUP
-#line 56 "lexer.l"
-return MACRO;
+#line 58 "lexer.l"
+parse_int32(yytext, &yylval.number); return NUMBER;
 	YY_BREAK
 case 9:
 YY_RULE_SETUP
-#line 57 "lexer.l"
-return STYLE;
+#line 59 "lexer.l"
+set_string(xstrdup(yytext)); return DECIMAL;
 	YY_BREAK
 case 10:
 YY_RULE_SETUP
-#line 58 "lexer.l"
-return SKIP;
+#line 60 "lexer.l"
+yylval.number = COMPARE_EQ; return COMPARE;
 	YY_BREAK
 case 11:
 YY_RULE_SETUP
-#line 59 "lexer.l"
-return BREAK;
+#line 61 "lexer.l"
+yylval.number = COMPARE_NE; return COMPARE;
 	YY_BREAK
 case 12:
 YY_RULE_SETUP
-#line 60 "lexer.l"
-return PREPEND;
+#line 62 "lexer.l"
+yylval.number = COMPARE_LT; return COMPARE;
 	YY_BREAK
 case 13:
 YY_RULE_SETUP
-#line 61 "lexer.l"
-return APPEND;
+#line 63 "lexer.l"
+yylval.number = COMPARE_LE; return COMPARE;
 	YY_BREAK
 case 14:
 YY_RULE_SETUP
-#line 62 "lexer.l"
-return INCLUDE;
+#line 64 "lexer.l"
+yylval.number = COMPARE_GT; return COMPARE;
 	YY_BREAK
 case 15:
 YY_RULE_SETUP
-#line 63 "lexer.l"
-return SET;
+#line 65 "lexer.l"
+yylval.number = COMPARE_GE; return COMPARE;
 	YY_BREAK
 case 16:
 YY_RULE_SETUP
-#line 64 "lexer.l"
+#line 66 "lexer.l"
+return AND;
+	YY_BREAK
+case 17:
+YY_RULE_SETUP
+#line 67 "lexer.l"
+return OR;
+	YY_BREAK
+case 18:
+YY_RULE_SETUP
+#line 68 "lexer.l"
+return NOT;
+	YY_BREAK
+case 19:
+YY_RULE_SETUP
+#line 69 "lexer.l"
+return MACRO;
+	YY_BREAK
+case 20:
+YY_RULE_SETUP
+#line 70 "lexer.l"
+return STYLE;
+	YY_BREAK
+case 21:
+YY_RULE_SETUP
+#line 71 "lexer.l"
+return SKIP;
+	YY_BREAK
+case 22:
+YY_RULE_SETUP
+#line 72 "lexer.l"
+return BREAK;
+	YY_BREAK
+case 23:
+YY_RULE_SETUP
+#line 73 "lexer.l"
+return PREPEND;
+	YY_BREAK
+case 24:
+YY_RULE_SETUP
+#line 74 "lexer.l"
+return APPEND;
+	YY_BREAK
+case 25:
+YY_RULE_SETUP
+#line 75 "lexer.l"
+return INCLUDE;
+	YY_BREAK
+case 26:
+YY_RULE_SETUP
+#line 76 "lexer.l"
+return SET;
+	YY_BREAK
+case 27:
+YY_RULE_SETUP
+#line 77 "lexer.l"
+return FIELDS;
+	YY_BREAK
+case 28:
+YY_RULE_SETUP
+#line 78 "lexer.l"
+return FIELD;
+	YY_BREAK
+case 29:
+YY_RULE_SETUP
+#line 79 "lexer.l"
+return JSON;
+	YY_BREAK
+case 30:
+YY_RULE_SETUP
+#line 80 "lexer.l"
+return ENTER;
+	YY_BREAK
+case 31:
+YY_RULE_SETUP
+#line 81 "lexer.l"
+return LEAVE;
+	YY_BREAK
+case 32:
+YY_RULE_SETUP
+#line 82 "lexer.l"
+return ADD;
+	YY_BREAK
+case 33:
+YY_RULE_SETUP
+#line 83 "lexer.l"
+return REMOVE;
+	YY_BREAK
+case 34:
+YY_RULE_SETUP
+#line 84 "lexer.l"
+return IN;
+	YY_BREAK
+case 35:
+YY_RULE_SETUP
+#line 85 "lexer.l"
 set_string(xstrdup(yytext)); return STRING;
 	YY_BREAK
 case YY_STATE_EOF(INITIAL):
-#line 65 "lexer.l"
+#line 86 "lexer.l"
 return EOF;
 	YY_BREAK
-case 17:
+case 36:
 YY_RULE_SETUP
-#line 67 "lexer.l"
+#line 88 "lexer.l"
 ECHO;
 	YY_BREAK
-#line 895 "lexer.c"
+#line 1093 "lexer.c"
 
 	case YY_END_OF_BUFFER:
 		{
@@ -1173,7 +1371,7 @@ static int yy_get_next_buffer (void)
 		while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 			{
 			yy_current_state = (int) yy_def[yy_current_state];
-			if ( yy_current_state >= 71 )
+			if ( yy_current_state >= 127 )
 				yy_c = yy_meta[(unsigned int) yy_c];
 			}
 		yy_current_state = yy_nxt[yy_base[yy_current_state] + (unsigned int) yy_c];
@@ -1201,11 +1399,11 @@ static int yy_get_next_buffer (void)
 	while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 		{
 		yy_current_state = (int) yy_def[yy_current_state];
-		if ( yy_current_state >= 71 )
+		if ( yy_current_state >= 127 )
 			yy_c = yy_meta[(unsigned int) yy_c];
 		}
 	yy_current_state = yy_nxt[yy_base[yy_current_state] + (unsigned int) yy_c];
-	yy_is_jam = (yy_current_state == 70);
+	yy_is_jam = (yy_current_state == 126);
 
 	return yy_is_jam ? 0 : yy_current_state;
 }
@@ -1864,26 +2062,43 @@ void yyfree (void * ptr )
 #undef YY_DECL_IS_OURS
 #undef YY_DECL
 #endif
-#line 67 "lexer.l"
-
-
+#line 88 "lexer.l"
 
 static void
-fix_reflags(void)
+fix_reflags(char endchar)
 {
 	int c;
 
 	yylval.regex.flags = 0;
-	for (c = strlen(yytext)-1; yytext[c] != '/'; c--) {
+	for (c = strlen(yytext)-1; yytext[c] != endchar; c--) {
 		if (yytext[c] == 'i') {
 			yylval.regex.flags |= REGEX_IGNORE_CASE;
 		} else if (yytext[c] == 'g') {
 			yylval.regex.flags |= REGEX_GLOBAL;
+		} else if (yytext[c] == 'L') {
+			yylval.regex.flags |= REGEX_ENGINE_LIBC;
+		} else if (yytext[c] == 'G') {
+			yylval.regex.flags |= REGEX_ENGINE_GNULIB;
+		} else if (yytext[c] == 'P') {
+			yylval.regex.flags |= REGEX_ENGINE_PCRE2;
 		}
 	}
 	yytext[c+1] = '\0';
 }
 
+static void
+fix_token(void)
+{
+	char *flags = strchr(yytext, '/');
+
+	yylval.regex.flags = 0;
+	if (flags != NULL) {
+		fix_reflags('/');
+		*flags = '\0';
+	}
+	set_string(xstrdup(yytext+1));
+}
+
 static void
 fix_string(bool retain_backslashes, int skip_count, char endchar)
 {
@@ -1932,7 +2147,7 @@ lexer_set_buffer(RemarkFile *rf)
 {
 	yyin = rf->file;
 	file = rf;
-	yy_switch_to_buffer(yy_create_buffer(rf->file,YY_BUF_SIZE));
+	yy_switch_to_buffer(yy_create_buffer(rf->file, YY_BUF_SIZE));
 	rf->lex_buffer = YY_CURRENT_BUFFER;
 }
 
@@ -1944,4 +2159,3 @@ lexer_restore_buffer(RemarkFile *rf)
 	if (rf != NULL)
 		yy_switch_to_buffer(rf->lex_buffer);
 }
-
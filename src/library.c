@@ -0,0 +1,261 @@
+/* library.c - Highlighting lines from within other programs.
+ *
+ * Copyright (C) 2001-2005 Oskar Liljeblad
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <config.h>
+#include <stdlib.h>		/* C89 */
+#include <string.h>		/* C89 */
+#include "xalloc.h"		/* Gnulib */
+#include "common/strbuf.h"
+#include "remark.h"
+
+struct _RemarkContext {
+	RemarkScript *script;
+	RemarkInput input;
+	char *prepend_string;
+	char *append_string;
+	StrBuf *output;
+};
+
+/**
+ * Check that a rule file and all its regexes can be compiled.
+ *
+ * @param error
+ *   If not NULL, set to a message describing the first error, to be
+ *   freed by the caller.
+ * @return
+ *   false if the rule file has errors.
+ */
+bool
+remark_check(const char *filename, char **error)
+{
+	RemarkScript *script = remark_compile(filename, error);
+
+	if (script == NULL)
+		return false;
+	free_script(script);
+	return true;
+}
+
+/**
+ * Compile a rule file into a script that can be shared by contexts.
+ * The file is found the same way as by remark. All regexes are
+ * compiled right away rather than on their first match. The values of
+ * lists are kept by each context, like its states.
+ *
+ * @param filename
+ *   Rule file, or NULL for a script without rules.
+ * @param error
+ *   If not NULL, set to a message describing the first error, to be
+ *   freed by the caller.
+ * @return
+ *   The compiled script, or NULL if the rule file has errors.
+ */
+RemarkScript *
+remark_compile(const char *filename, char **error)
+{
+	RemarkScript *script;
+	char *msg;
+
+	script = read_script(filename, false, &msg);
+	if (script == NULL) {
+		if (error != NULL)
+			*error = msg;
+		else
+			free(msg);
+	}
+	return script;
+}
+
+/**
+ * Free a compiled script, once no context uses it.
+ */
+void
+remark_free_script(RemarkScript *script)
+{
+	if (script != NULL)
+		free_script(script);
+}
+
+/**
+ * Create a context for highlighting one stream of lines with a
+ * script. Lines are wrapped only as wide as the text is, and escape
+ * sequences are kept, until changed with remark_set_layout and
+ * remark_set_escapes.
+ *
+ * @return
+ *   New context, to be freed with remark_free_context.
+ */
+RemarkContext *
+remark_new_context(RemarkScript *script)
+{
+	RemarkContext *context = xmalloc(sizeof(RemarkContext));
+
+	context->script = script;
+	init_input(&context->input);
+	context->prepend_string = xstrdup("");
+	context->append_string = xstrdup("");
+	context->output = strbuf_new();
+	return context;
+}
+
+void
+remark_free_context(RemarkContext *context)
+{
+	free_input(&context->input);
+	free(context->prepend_string);
+	free(context->append_string);
+	strbuf_free(context->output);
+	free(context);
+}
+
+/**
+ * Set how lines of a context are wrapped, like the options
+ * --wrapper, --width, --retain, --prepend and --append of remark.
+ *
+ * @param wrapper
+ *   Wrapping type, or NULL for `char'.
+ * @param width
+ *   Columns to wrap lines at, or 0 not to wrap.
+ * @param prepend
+ *   String to put first on each continued line, or NULL.
+ * @param append
+ *   String to put last on each line that continues, or NULL.
+ * @return
+ *   false if the wrapping type is unknown, or if retain, prepend and
+ *   append do not leave room for any text. The context is then not
+ *   changed.
+ */
+bool
+remark_set_layout(RemarkContext *context, const char *wrapper, uint32_t width, uint32_t retain, const char *prepend, const char *append)
+{
+	WrapperType type = WRAPPER_CHAR;
+
+	if (wrapper != NULL && !identify_wrapper(wrapper, &type))
+		return false;
+	if (prepend == NULL)
+		prepend = "";
+	if (append == NULL)
+		append = "";
+	if (width == 0)
+		width = UINT32_MAX;
+	if ((uint64_t) retain + display_width(prepend, strlen(prepend)) + display_width(append, strlen(append)) >= width)
+		return false;
+
+	context->input.wrapper = type;
+	context->input.wrap_width = width;
+	context->input.wrap_retain = retain;
+	free(context->prepend_string);
+	context->prepend_string = xstrdup(prepend);
+	free(context->append_string);
+	context->append_string = xstrdup(append);
+	return true;
+}
+
+/**
+ * Set what is done with escape sequences in lines of a context, like
+ * the option --escapes of remark.
+ *
+ * @param mode
+ *   One of `keep', `strip' and `restore'.
+ * @return
+ *   false if the mode is unknown.
+ */
+bool
+remark_set_escapes(RemarkContext *context, const char *mode)
+{
+	return identify_escape_mode(mode, &context->input.escape_mode);
+}
+
+/**
+ * Leave all states of a context and empty its lists, as if no lines
+ * had been highlighted.
+ */
+void
+remark_reset(RemarkContext *context)
+{
+	context->input.states = 0;
+	free_list_sets(&context->input.lists);
+}
+
+static bool
+highlight_line(RemarkContext *context, const char *line)
+{
+	RemarkInput *input = &context->input;
+
+	strbuf_set(input->mb.buffer, line);
+	input->mb.bufferlen = strbuf_length(input->mb.buffer);
+	if (input->escape_mode != ESCAPES_KEEP)
+		strip_escapes(input);
+	strbuf_set(input->append_mb.buffer, context->append_string);
+	input->append_mb.bufferlen = strbuf_length(input->append_mb.buffer);
+	strbuf_set(input->prepend_mb.buffer, context->prepend_string);
+	input->prepend_mb.bufferlen = strbuf_length(input->prepend_mb.buffer);
+
+	return execute_script(context->script, input);
+}
+
+/**
+ * Highlight a line.
+ *
+ * @param line
+ *   Text of the line, without the newline.
+ * @param length
+ *   Set to the length of the highlighted text.
+ * @return
+ *   Highlighted text, ending with a newline, or an empty string if the
+ *   line was skipped. It is valid until the context is used again.
+ */
+const char *
+remark_line(RemarkContext *context, const char *line, uint32_t *length)
+{
+	if (!highlight_line(context, line)) {
+		*length = 0;
+		return "";
+	}
+	*length = strbuf_length(context->input.mb.buffer);
+	return strbuf_buffer(context->input.mb.buffer);
+}
+
+/**
+ * Highlight many lines at once. The highlighted lines are collected
+ * in one buffer of the context, which is reused by the next call, so
+ * after the first few calls no memory is allocated for it.
+ *
+ * @param lines
+ *   Text of the lines, without newlines.
+ * @param length
+ *   Set to the length of the highlighted text.
+ * @return
+ *   Highlighted text of all lines that were not skipped, each ending
+ *   with a newline. It is valid until the context is used again.
+ */
+const char *
+remark_lines(RemarkContext *context, const char **lines, uint32_t count, uint32_t *length)
+{
+	MatchBuffer *mb = &context->input.mb;
+	uint32_t c;
+
+	strbuf_set_length(context->output, 0);
+	for (c = 0; c < count; c++) {
+		if (highlight_line(context, lines[c]))
+			strbuf_append_data(context->output, strbuf_buffer(mb->buffer), strbuf_length(mb->buffer));
+	}
+	*length = strbuf_length(context->output);
+	return strbuf_buffer(context->output);
+}
@@ -0,0 +1,134 @@
+/* libremark-test.c - Highlighting lines with libremark from the testsuite.
+ *
+ * Copyright (C) 2001-2005 Oskar Liljeblad
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/* Usage: libremark-test RULES BROKEN-RULES... <LINES
+ *
+ * The lines are highlighted by two contexts sharing one script, the
+ * first in order and the second in reverse order, so that each enters
+ * and leaves states and adds list values at its own lines. The second
+ * context is then reset and wraps all lines at once. Last, each broken
+ * rule file must give an error without ending the program, after which
+ * RULES is compiled again.
+ */
+
+#include <config.h>
+#include <stdbool.h>		/* Gnulib/C99/POSIX */
+#include <stdint.h>		/* Gnulib/C99/POSIX */
+#include <stdlib.h>		/* C89 */
+#include <stdio.h>		/* C89 */
+#include <string.h>		/* C89 */
+#include "libremark.h"
+
+/* Most lines and longest line read from standard in. */
+#define MAX_LINES 64
+#define MAX_LINE 256
+
+static void
+print(const char *prefix, const char *text, uint32_t length)
+{
+	fputs(prefix, stdout);
+	if (length == 0)
+		fputs("(skipped)\n", stdout);
+	else
+		fwrite(text, 1, length, stdout);
+}
+
+static RemarkScript *
+compile(const char *filename)
+{
+	RemarkScript *script;
+	char *error;
+
+	script = remark_compile(filename, &error);
+	if (script == NULL) {
+		printf("error: %s\n", error);
+		free(error);
+	}
+	return script;
+}
+
+int
+main(int argc, char **argv)
+{
+	char buf[MAX_LINE];
+	const char *lines[MAX_LINES];
+	RemarkScript *script;
+	RemarkContext *first;
+	RemarkContext *second;
+	const char *text;
+	uint32_t count;
+	uint32_t length;
+	uint32_t c;
+	int arg;
+
+	if (argc < 3) {
+		fprintf(stderr, "usage: %s RULES BROKEN-RULES... <LINES\n", argv[0]);
+		exit(1);
+	}
+
+	for (count = 0; count < MAX_LINES && fgets(buf, sizeof(buf), stdin) != NULL; count++) {
+		buf[strcspn(buf, "\n")] = '\0';
+		lines[count] = strdup(buf);
+	}
+
+	script = compile(argv[1]);
+	if (script == NULL)
+		exit(1);
+	first = remark_new_context(script);
+	second = remark_new_context(script);
+	for (c = 0; c < count; c++) {
+		text = remark_line(first, lines[c], &length);
+		print("first:  ", text, length);
+		text = remark_line(second, lines[count-1-c], &length);
+		print("second: ", text, length);
+	}
+
+	remark_reset(second);
+	if (remark_set_layout(second, "word", 1, 0, "+", NULL))
+		puts("layout accepted where no text fits");
+	if (!remark_set_layout(second, "word", 12, 2, "+", NULL))
+		puts("layout rejected");
+	text = remark_lines(second, lines, count, &length);
+	fwrite(text, 1, length, stdout);
+
+	remark_free_context(first);
+	remark_free_context(second);
+	remark_free_script(script);
+
+	for (arg = 2; arg < argc; arg++) {
+		if (remark_check(argv[arg], NULL))
+			puts("broken rules accepted");
+		script = compile(argv[arg]);
+		if (script != NULL)
+			remark_free_script(script);
+	}
+
+	script = compile(argv[1]);
+	if (script != NULL) {
+		first = remark_new_context(script);
+		text = remark_lines(first, lines, count, &length);
+		fwrite(text, 1, length, stdout);
+		remark_free_context(first);
+		remark_free_script(script);
+	}
+
+	for (c = 0; c < count; c++)
+		free((char *) lines[c]);
+	exit(0);
+}
@@ -0,0 +1,56 @@
+/* libremark.h - Highlighting lines from within other programs.
+ *
+ * Copyright (C) 2001-2005 Oskar Liljeblad
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/* A rule file is compiled once into a script, which any number of
+ * contexts may share. Each context highlights one stream of lines,
+ * with its own states, list values, wrapping options and matcher
+ * buffers, so lines from different streams can be highlighted in the
+ * same process.
+ * Errors in a rule file are returned rather than printed.
+ *
+ * The library is not thread-safe. The parser and lexer, the regex
+ * engine options, the gnulib backtrack counter, the PCRE2 match context
+ * and the C locale are shared by all scripts and contexts, so calls
+ * must all be made from one thread. The library is not installed, and
+ * programs must also link src/common/lib_common.a and lib/libgnu.a.
+ */
+
+#ifndef LIBREMARK_H
+#define LIBREMARK_H
+
+#include <stdbool.h>		/* Gnulib/C99/POSIX */
+#include <stdint.h>		/* Gnulib/C99/POSIX */
+
+typedef struct _RemarkScript RemarkScript;
+typedef struct _RemarkContext RemarkContext;
+
+bool remark_check(const char *filename, char **error);
+RemarkScript *remark_compile(const char *filename, char **error);
+void remark_free_script(RemarkScript *script);
+
+RemarkContext *remark_new_context(RemarkScript *script);
+void remark_free_context(RemarkContext *context);
+bool remark_set_layout(RemarkContext *context, const char *wrapper, uint32_t width, uint32_t retain, const char *prepend, const char *append);
+bool remark_set_escapes(RemarkContext *context, const char *mode);
+void remark_reset(RemarkContext *context);
+
+const char *remark_line(RemarkContext *context, const char *line, uint32_t *length);
+const char *remark_lines(RemarkContext *context, const char **lines, uint32_t count, uint32_t *length);
+
+#endif
@@ -26,11 +26,12 @@
 /* gnulib */
 #include <regex.h>
 #include <xalloc.h>
+#include <minmax.h>
+#include <xvasprintf.h>
 /* Gettext */
 #include <gettext.h>
 #define _(String) gettext(String)
 /* common */
-#include "common/regex-utils.h"
 #include "common/error.h"
 #include "common/strbuf.h"
 #include "common/string-utils.h"
@@ -39,6 +40,7 @@
 #include "remark.h"
 
 static bool expand_variable(StrBuf *buf, const char *in, uint32_t len, MatchState *ms, uint32_t subc, SubmatchSpec *subv);
+static uint32_t split_fields(MatchScratch *scratch, FieldMatch *fieldmatch, const char *buf, uint32_t so, uint32_t eo);
 
 MatchState *
 try_match(Match *match, MatchState *ms, uint32_t *start, uint32_t call)
@@ -47,25 +49,106 @@ try_match(Match *match, MatchState *ms, uint32_t *start, uint32_t call)
 
 	if (match->type == MATCH_REGEX) {
 		RegexMatch *rematch = (RegexMatch *) match;
-		uint32_t c;
-		uint32_t so = *start;
-		uint32_t subc = rematch->regex.re_nsub + 1;
-		regmatch_t subv[subc];
+		uint32_t subc = regex_nsub(rematch->regex) + 1;
 
 		if (call > 0 && (rematch->flags & REGEX_GLOBAL) == 0)
 			return NULL;
 
-		if (!xregexec_substring(&rematch->regex, strbuf_buffer(ms->top->buffer), so, ms->subv[0].eo, subc, subv, 0))
+		new_ms = new_match_state(ms->top, 0, 0, subc);
+		if (!regex_exec(rematch->regex, ms->top, *start, ms->subv[0].eo, subc, new_ms->subv)) {
+			free_match_state(new_ms);
+			return NULL;
+		}
+
+		new_ms->parent = ms;
+		*start += new_ms->subv[0].eo - new_ms->subv[0].so;
+		return new_ms;
+	}
+
+	if (match->type == MATCH_LITERAL) {
+		LiteralMatch *litmatch = (LiteralMatch *) match;
+		char *buf = strbuf_buffer(ms->top->buffer);
+		uint32_t so = *start;
+		uint32_t eo = ms->subv[0].eo;
+		char *found;
+
+		if (call > 0 && (litmatch->flags & REGEX_GLOBAL) == 0)
+			return NULL;
+		if (so > eo)
+			return NULL;
+
+		if (litmatch->flags & REGEX_IGNORE_CASE)
+			found = memcasemem(buf+so, eo-so, litmatch->string, litmatch->length);
+		else
+			found = memmem(buf+so, eo-so, litmatch->string, litmatch->length);
+		if (found == NULL)
 			return NULL;
 
-		new_ms = new_match_state(ms->top, subv[0].rm_so, subv[0].rm_eo, subc);
+		so = found - buf;
+		new_ms = new_match_state(ms->top, so, so + litmatch->length, 1);
 		new_ms->parent = ms;
-		for (c = 1; c < subc; c++) {
-			new_ms->subv[c].so = subv[c].rm_so;
-			new_ms->subv[c].eo = subv[c].rm_eo;
+		*start += litmatch->length;
+		return new_ms;
+	}
+
+	if (match->type == MATCH_TOKEN) {
+		TokenMatch *tokmatch = (TokenMatch *) match;
+		uint32_t c;
+		uint32_t subc = token_subexpressions(tokmatch->token) + 1;
+		SubmatchSpec subv[subc];
+
+		if (call > 0 && (tokmatch->flags & REGEX_GLOBAL) == 0)
+			return NULL;
+
+		if (!token_search(tokmatch->token, strbuf_buffer(ms->top->buffer), ms->subv[0].so, *start, ms->subv[0].eo, subv))
+			return NULL;
+
+		new_ms = new_match_state(ms->top, subv[0].so, subv[0].eo, subc);
+		new_ms->parent = ms;
+		for (c = 1; c < subc; c++)
+			new_ms->subv[c] = subv[c];
+
+		*start += subv[0].eo - subv[0].so;
+		return new_ms;
+	}
+
+	if (match->type == MATCH_FIELD) {
+		FieldMatch *fieldmatch = (FieldMatch *) match;
+		SubmatchSpec *fields;
+		uint32_t subc;
+
+		if (call > 0)
+			return NULL;
+
+		subc = split_fields(ms->top->scratch, fieldmatch, strbuf_buffer(ms->top->buffer), ms->subv[0].so, ms->subv[0].eo);
+		fields = ms->top->scratch->fields;
+		if (fieldmatch->index != 0) {
+			if (fieldmatch->index >= subc)
+				return NULL;
+			new_ms = new_match_state(ms->top, fields[fieldmatch->index].so, fields[fieldmatch->index].eo, 1);
+		} else {
+			new_ms = new_match_state(ms->top, ms->subv[0].so, ms->subv[0].eo, subc);
+			new_ms->fields = true;
+			memcpy(new_ms->subv+1, fields+1, sizeof(SubmatchSpec) * (subc-1));
 		}
 
-		*start += subv[0].rm_eo - subv[0].rm_so;
+		new_ms->parent = ms;
+		*start = new_ms->subv[0].so;
+		return new_ms;
+	}
+
+	if (match->type == MATCH_JSON) {
+		JsonMatch *jsonmatch = (JsonMatch *) match;
+		SubmatchSpec value;
+
+		if (call > 0)
+			return NULL;
+		if (!json_lookup(ms->top, ms->subv[0].so, ms->subv[0].eo, jsonmatch->key, jsonmatch->length, &value))
+			return NULL;
+
+		*start = value.so;
+		new_ms = new_match_state(ms->top, value.so, value.eo, 1);
+		new_ms->parent = ms;
 		return new_ms;
 	}
 
@@ -75,8 +158,12 @@ try_match(Match *match, MatchState *ms, uint32_t *start, uint32_t call)
 
 		if (call > 0)
 			return NULL;
-		if (submatch->index >= ms->subc)
+		if (submatch->index >= ms->subc) {
+			/* The number of fields varies from line to line. */
+			if (ms->fields)
+				return NULL;
 			die(_("subexpression index is out of range"));
+		}
 
 		spec = &ms->subv[submatch->index];
 		if (spec->so == -1 || spec->eo == -1)
@@ -91,12 +178,59 @@ try_match(Match *match, MatchState *ms, uint32_t *start, uint32_t call)
 	return NULL;
 }
 
+/* Return the number of subexpressions, including the whole match, that
+ * a match gives the rules under it, or 0 if that is not known before
+ * matching. A regex that has not been compiled yet is not compiled
+ * here, and a field match without an index gives as many as there
+ * are fields on the line.
+ */
+uint32_t
+match_subexpressions(Match *match)
+{
+	if (match->type == MATCH_REGEX) {
+		RegexMatch *rematch = (RegexMatch *) match;
+		if (!regex_compiled(rematch->regex))
+			return 0;
+		return regex_nsub(rematch->regex) + 1;
+	}
+	if (match->type == MATCH_TOKEN) {
+		TokenMatch *tokmatch = (TokenMatch *) match;
+		return token_subexpressions(tokmatch->token) + 1;
+	}
+	if (match->type == MATCH_FIELD) {
+		FieldMatch *fieldmatch = (FieldMatch *) match;
+		return (fieldmatch->index == 0 ? 0 : 1);
+	}
+	return 1;
+}
+
+/* Match states are freed in the reverse order they are made, so a
+ * line rarely needs more states than the lines before it. Freed
+ * states are kept for reuse by the input, which leaves the heap alone
+ * once the deepest nesting of the rules has been seen.
+ */
 MatchState *
 new_match_state(MatchBuffer *mb, uint32_t so, uint32_t eo, uint32_t subc)
 {
-	MatchState *ms = xmalloc(sizeof(MatchState) + sizeof(SubmatchSpec)*subc);	/* XXX: memory management */
+	MatchState **prev = &mb->scratch->free_states;
+	MatchState *ms;
+
+	for (ms = *prev; ms != NULL; prev = &ms->parent, ms = ms->parent) {
+		if (ms->size >= subc)
+			break;
+	}
+	if (ms != NULL) {
+		*prev = ms->parent;
+	} else {
+		uint32_t size = MAX(subc, MATCH_STATE_SUBC);
+		ms = xmalloc(sizeof(MatchState) + sizeof(SubmatchSpec)*size);
+		ms->size = size;
+		mb->scratch->allocations++;
+	}
+
 	ms->top = mb;
 	ms->parent = NULL;
+	ms->fields = false;
 	ms->subv[0].so = so;
 	ms->subv[0].eo = eo;
 	ms->subc = subc;
@@ -106,7 +240,22 @@ new_match_state(MatchBuffer *mb, uint32_t so, uint32_t eo, uint32_t subc)
 void
 free_match_state(MatchState *ms)
 {
-	free(ms);
+	MatchScratch *scratch = ms->top->scratch;
+
+	ms->parent = scratch->free_states;
+	scratch->free_states = ms;
+}
+
+void
+free_match_scratch(MatchScratch *scratch)
+{
+	while (scratch->free_states != NULL) {
+		MatchState *ms = scratch->free_states;
+		scratch->free_states = ms->parent;
+		free(ms);
+	}
+	free(scratch->fields);
+	json_free_cache(scratch);
 }
 
 static void *
@@ -123,36 +272,47 @@ free_match(Match *anymatch)
 	if (anymatch->type == MATCH_REGEX) {
 		RegexMatch *match = (RegexMatch *) anymatch;
 		free(match->regex_string);
-		regfree(&match->regex);
+		free_regex(match->regex);
 	}
 	else if (anymatch->type == MATCH_SUBEX) {
 		/* no operation */
 	}
+	else if (anymatch->type == MATCH_LITERAL) {
+		LiteralMatch *match = (LiteralMatch *) anymatch;
+		free(match->string);
+	}
+	else if (anymatch->type == MATCH_TOKEN) {
+		/* no operation */
+	}
+	else if (anymatch->type == MATCH_FIELD) {
+		FieldMatch *match = (FieldMatch *) anymatch;
+		free(match->delimiter);
+	}
+	else if (anymatch->type == MATCH_JSON) {
+		JsonMatch *match = (JsonMatch *) anymatch;
+		free(match->key);
+	}
 
 	free(anymatch);
 }
 
 Match *
-new_regex_match(const char *respec, RegexFlags flags)
+new_regex_match(RemarkScript *script, const char *respec, RegexFlags flags, char **error)
 {
-	RegexMatch *regex = new_match(MATCH_REGEX, sizeof(RegexMatch));
-	int init_flags = REG_EXTENDED;
-	int rc;
+	RegexMatch *regex;
+	Regex *compiled;
+	char *msg;
 
-	memset(&regex->regex, 0, sizeof(regex_t));
-	regex->regex_string = xstrdup(respec);
-	regex->flags = flags;
-	if (flags & REGEX_IGNORE_CASE)
-		init_flags |= REG_ICASE;
-
-	rc = regcomp(&regex->regex, respec, init_flags);
-	if (rc != 0) {
-		char *msg = xregerror(rc, &regex->regex);
-		regfree(&regex->regex);
-		warn("%s", msg);
+	compiled = new_regex(script, respec, flags, &msg);
+	if (compiled == NULL) {
+		*error = xasprintf(_("cannot compile regex `%s': %s"), respec, msg);
 		free(msg);
-		exit(1);
+		return NULL;
 	}
+	regex = new_match(MATCH_REGEX, sizeof(RegexMatch));
+	regex->regex = compiled;
+	regex->regex_string = xstrdup(respec);
+	regex->flags = flags;
 
 	return (Match *) regex;
 }
@@ -165,6 +325,118 @@ new_subex_match(uint32_t index)
 	return (Match *) subex;
 }
 
+/* Literal matches are plain substring searches that never involve
+ * the regex engine. With REGEX_IGNORE_CASE, only ASCII letters are
+ * compared case insensitively. The string is folded here so that
+ * memcasemem need only fold the subject.
+ */
+Match *
+new_literal_match(const char *string, RegexFlags flags)
+{
+	LiteralMatch *literal = new_match(MATCH_LITERAL, sizeof(LiteralMatch));
+	literal->string = xstrdup(string);
+	literal->length = strlen(string);
+	literal->flags = flags;
+	if (flags & REGEX_IGNORE_CASE)
+		memcasefold(literal->string, literal->length);
+	return (Match *) literal;
+}
+
+Match *
+new_token_match(const Token *token, RegexFlags flags)
+{
+	TokenMatch *tokmatch = new_match(MATCH_TOKEN, sizeof(TokenMatch));
+	tokmatch->token = token;
+	tokmatch->flags = flags;
+	return (Match *) tokmatch;
+}
+
+/* Field matches split the current match into fields. A single
+ * space as delimiter splits on runs of spaces and tabs, ignoring
+ * leading and trailing blanks (like awk). Any other delimiter is
+ * matched exactly. An index of 0 matches the whole span with every
+ * field as a subexpression, otherwise only that field is matched.
+ */
+Match *
+new_field_match(const char *delimiter, uint32_t index)
+{
+	FieldMatch *fieldmatch = new_match(MATCH_FIELD, sizeof(FieldMatch));
+	fieldmatch->delimiter = xstrdup(delimiter);
+	fieldmatch->length = strlen(delimiter);
+	fieldmatch->index = index;
+	return (Match *) fieldmatch;
+}
+
+/* JSON matches match the value of a key in the object of the
+ * current match. The key is compared as written in the object,
+ * without interpreting escapes.
+ */
+Match *
+new_json_match(const char *key)
+{
+	JsonMatch *jsonmatch = new_match(MATCH_JSON, sizeof(JsonMatch));
+	jsonmatch->key = xstrdup(key);
+	jsonmatch->length = strlen(key);
+	return (Match *) jsonmatch;
+}
+
+static void
+add_field(MatchScratch *scratch, uint32_t count, uint32_t so, uint32_t eo)
+{
+	if (count >= scratch->fields_size) {
+		scratch->fields_size = MAX(16, scratch->fields_size*2);
+		scratch->fields = xrealloc(scratch->fields, sizeof(SubmatchSpec) * scratch->fields_size);
+		scratch->allocations++;
+	}
+	scratch->fields[count].so = so;
+	scratch->fields[count].eo = eo;
+}
+
+/* Split buf between so and eo into the fields array of scratch, with
+ * the first field at index 1. Only as many fields as needed are split
+ * when a single field is wanted. Returns the number of fields plus one.
+ */
+static uint32_t
+split_fields(MatchScratch *scratch, FieldMatch *fieldmatch, const char *buf, uint32_t so, uint32_t eo)
+{
+	uint32_t count = 1;
+	uint32_t pos = so;
+	const char *p;
+
+	if (fieldmatch->length == 1 && fieldmatch->delimiter[0] == ' ') {
+		while (pos < eo) {
+			while (pos < eo && (buf[pos] == ' ' || buf[pos] == '\t'))
+				pos++;
+			if (pos == eo)
+				break;
+			for (p = buf+pos; (p = memrange(p, buf+eo-p, '\t', ' ')) != NULL; p++) {
+				if (*p == ' ' || *p == '\t')
+					break;
+			}
+			add_field(scratch, count++, pos, p == NULL ? eo : p - buf);
+			if (p == NULL || count-1 == fieldmatch->index)
+				break;
+			pos = p - buf;
+		}
+		return count;
+	}
+
+	if (so == eo)
+		return count;
+	for (;;) {
+		if (fieldmatch->length == 1)
+			p = memchr(buf+pos, fieldmatch->delimiter[0], eo-pos);
+		else
+			p = memmem(buf+pos, eo-pos, fieldmatch->delimiter, fieldmatch->length);
+		add_field(scratch, count++, pos, p == NULL ? eo : p - buf);
+		if (p == NULL || count-1 == fieldmatch->index)
+			break;
+		pos = p - buf + fieldmatch->length;
+	}
+
+	return count;
+}
+
 /* Note: It is kind of stupid to first call strbuf_free_to_string,
  * then later free (above this function). But with the current API
  * of strbuf_free there's no other way!
@@ -0,0 +1,124 @@
+/* output.c - Buffered output of highlighted lines.
+ *
+ * Copyright (C) 2001-2005 Oskar Liljeblad
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <config.h>
+#include <errno.h>		/* C89 */
+#include <stdbool.h>		/* Gnulib/C99/POSIX */
+#include <stdint.h>		/* Gnulib/C99/POSIX */
+#include <unistd.h>		/* POSIX */
+#include "gettext.h"		/* Gnulib */
+#define _(String) gettext(String)
+#include "common/error.h"
+#include "common/strbuf.h"
+#include "remark.h"
+
+/* Amount of buffered output that is written even if the caller has
+ * not asked for it yet.
+ */
+#define OUTPUT_BLOCK_SIZE	65536
+
+bool cache_newline = false;
+
+static StrBuf *output = NULL;
+static bool newline_held = false;
+
+/**
+ * Add a highlighted line to the output. Nothing is written until
+ * flush_output is called or enough output has been collected.
+ * If cache_newline is set, the newline that ends the line is held
+ * back until there is more output, so that a terminal does not
+ * scroll up an empty line while waiting for the next line.
+ *
+ * @param text
+ *   Highlighted text, normally ending with a newline.
+ * @param len
+ *   Length of text in bytes.
+ * @param partial
+ *   If true, text is the start of a line whose rest will be written
+ *   later, and its newline is dropped.
+ */
+void
+write_output(const char *text, uint32_t len, bool partial)
+{
+	if (output == NULL)
+		output = strbuf_new();
+	if (len == 0)
+		return;
+
+	if (newline_held) {
+		strbuf_append_char(output, '\n');
+		newline_held = false;
+	}
+	if (text[len-1] == '\n' && (partial || cache_newline)) {
+		newline_held = !partial;
+		len--;
+	}
+	strbuf_append_data(output, text, len);
+
+	if (strbuf_length(output) >= OUTPUT_BLOCK_SIZE)
+		flush_output();
+}
+
+/**
+ * Write all buffered output to standard out, in a single write unless
+ * it is interrupted.
+ */
+void
+flush_output(void)
+{
+	const char *data;
+	uint32_t len;
+
+	if (output == NULL)
+		return;
+
+	data = strbuf_buffer(output);
+	len = strbuf_length(output);
+	while (len > 0) {
+		ssize_t written = write(STDOUT_FILENO, data, len);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			die_errno(_("cannot write to standard out"));
+		}
+		data += written;
+		len -= written;
+	}
+	strbuf_set_length(output, 0);
+}
+
+/**
+ * Write a held back newline and all buffered output, once there
+ * will be no more output.
+ */
+void
+finish_output(void)
+{
+	if (newline_held) {
+		if (output == NULL)
+			output = strbuf_new();
+		strbuf_append_char(output, '\n');
+		newline_held = false;
+	}
+	flush_output();
+	if (output != NULL) {
+		strbuf_free(output);
+		output = NULL;
+	}
+}
@@ -1,12 +1,14 @@
-/* A Bison parser, made by GNU Bison 1.875d.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
-/* Skeleton parser for Yacc-like parsing with Bison,
-   Copyright (C) 1984, 1989, 1990, 2000, 2001, 2002, 2003, 2004 Free Software Foundation, Inc.
+/* Bison implementation for Yacc-like parsers in C
 
-   This program is free software; you can redistribute it and/or modify
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
+   This program is free software: you can redistribute it and/or modify
    it under the terms of the GNU General Public License as published by
-   the Free Software Foundation; either version 2, or (at your option)
-   any later version.
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
 
    This program is distributed in the hope that it will be useful,
    but WITHOUT ANY WARRANTY; without even the implied warranty of
@@ -14,17 +16,27 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program; if not, write to the Free Software
-   Foundation, Inc., 59 Temple Place - Suite 330,
-   Boston, MA 02111-1307, USA.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* As a special exception, you may create a larger work that contains
+   part or all of the Bison parser skeleton and distribute that work
+   under terms of your choice, so long as that work isn't itself a
+   parser generator using the skeleton or a modified version thereof
+   as a parser skeleton.  Alternatively, if you modify or redistribute
+   the parser skeleton itself, you may (at your option) remove this
+   special exception, which will cause the skeleton and the resulting
+   Bison output files to be licensed under the GNU General Public
+   License without this special exception.
 
-/* As a special exception, when this file is copied by Bison into a
-   Bison output file, you may use that output file without restriction.
-   This special exception was added by the Free Software Foundation
-   in version 1.24 of Bison.  */
+   This special exception was added by the Free Software Foundation in
+   version 2.2 of Bison.  */
 
-/* Written by Richard Stallman by simplifying the original so called
-   ``semantic'' parser.  */
+/* C LALR(1) parser skeleton written by Richard Stallman, by
+   simplifying the original so-called "semantic" parser.  */
+
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
 
 /* All symbols defined below should begin with yy or YY, to avoid
    infringing on user name space.  This should be done even for local
@@ -33,8 +45,11 @@
    define necessary library symbols; they are noted "INFRINGES ON
    USER NAME SPACE" below.  */
 
-/* Identify Bison output.  */
-#define YYBISON 1
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
+
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
 
 /* Skeleton name.  */
 #define YYSKELETON_NAME "yacc.c"
@@ -42,48 +57,16 @@
 /* Pure parsers.  */
 #define YYPURE 0
 
-/* Using locations.  */
-#define YYLSP_NEEDED 0
+/* Push parsers.  */
+#define YYPUSH 0
 
-
-
-/* Tokens.  */
-#ifndef YYTOKENTYPE
-# define YYTOKENTYPE
-   /* Put the tokens into the symbol table, so that GDB and other debuggers
-      know about them.  */
-   enum yytokentype {
-     STYLE = 258,
-     PREPEND = 259,
-     APPEND = 260,
-     SKIP = 261,
-     BREAK = 262,
-     MACRO = 263,
-     INCLUDE = 264,
-     SET = 265,
-     NUMBER = 266,
-     STRING = 267,
-     MATCH = 268,
-     SUBST = 269
-   };
-#endif
-#define STYLE 258
-#define PREPEND 259
-#define APPEND 260
-#define SKIP 261
-#define BREAK 262
-#define MACRO 263
-#define INCLUDE 264
-#define SET 265
-#define NUMBER 266
-#define STRING 267
-#define MATCH 268
-#define SUBST 269
+/* Pull parsers.  */
+#define YYPULL 1
 
 
 
 
-/* Copy the first part of user declarations.  */
+/* First part of user prologue.  */
 #line 19 "parser.y"
 
 
@@ -91,16 +74,18 @@
 /* C89 */
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <errno.h>
-#include <assert.h>
 #include <string.h>
+/* POSIX */
+#include <sys/stat.h>
 /* Gettext */
 #include <gettext.h>
 #define _(String) gettext(String)
 /* gnulib */
 #include <dirname.h>
 #include <xalloc.h>
-#include <progname.h>
+#include <xvasprintf.h>
 /* common */
 #include "common/string-utils.h"
 #include "common/intutil.h"
@@ -111,31 +96,128 @@
 /* regex-markup */
 #include "remark.h"
 
-static RemarkFile *file = NULL;
-static RemarkScript *script;
+static Rule *include_script(Parser *parser, const char *filename);
+static bool state_mask(Parser *parser, const char *name, uint64_t *mask);
+static uint32_t get_list(RemarkScript *script, const char *name);
+static void script_error(Parser *parser, const char *msg, ...);
+static void yyerror(Parser *parser, const char *msg);
+
+#define PARSE_ERROR(...) do { script_error(parser, __VA_ARGS__); YYABORT; } while (0)
 
-static Rule *include_script(const char *filename);
-static void script_die(const char *msg, ...);
-static void yyerror(char *msg);
 
+#line 109 "parser.c"
 
+# ifndef YY_CAST
+#  ifdef __cplusplus
+#   define YY_CAST(Type, Val) static_cast<Type> (Val)
+#   define YY_REINTERPRET_CAST(Type, Val) reinterpret_cast<Type> (Val)
+#  else
+#   define YY_CAST(Type, Val) ((Type) (Val))
+#   define YY_REINTERPRET_CAST(Type, Val) ((Type) (Val))
+#  endif
+# endif
+# ifndef YY_NULLPTR
+#  if defined __cplusplus
+#   if 201103L <= __cplusplus
+#    define YY_NULLPTR nullptr
+#   else
+#    define YY_NULLPTR 0
+#   endif
+#  else
+#   define YY_NULLPTR ((void*)0)
+#  endif
+# endif
 
-/* Enabling traces.  */
+/* Use api.header.include to #include this header
+   instead of duplicating it here.  */
+#ifndef YY_YY_PARSER_H_INCLUDED
+# define YY_YY_PARSER_H_INCLUDED
+/* Debug traces.  */
 #ifndef YYDEBUG
 # define YYDEBUG 0
 #endif
+#if YYDEBUG
+extern int yydebug;
+#endif
 
-/* Enabling verbose error messages.  */
-#ifdef YYERROR_VERBOSE
-# undef YYERROR_VERBOSE
-# define YYERROR_VERBOSE 1
-#else
-# define YYERROR_VERBOSE 0
+/* Token kinds.  */
+#ifndef YYTOKENTYPE
+# define YYTOKENTYPE
+  enum yytokentype
+  {
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    STYLE = 258,                   /* STYLE  */
+    PREPEND = 259,                 /* PREPEND  */
+    APPEND = 260,                  /* APPEND  */
+    SKIP = 261,                    /* SKIP  */
+    BREAK = 262,                   /* BREAK  */
+    MACRO = 263,                   /* MACRO  */
+    INCLUDE = 264,                 /* INCLUDE  */
+    SET = 265,                     /* SET  */
+    FIELDS = 266,                  /* FIELDS  */
+    FIELD = 267,                   /* FIELD  */
+    JSON = 268,                    /* JSON  */
+    AND = 269,                     /* AND  */
+    OR = 270,                      /* OR  */
+    NOT = 271,                     /* NOT  */
+    COMPARE = 272,                 /* COMPARE  */
+    DECIMAL = 273,                 /* DECIMAL  */
+    ENTER = 274,                   /* ENTER  */
+    LEAVE = 275,                   /* LEAVE  */
+    ADD = 276,                     /* ADD  */
+    REMOVE = 277,                  /* REMOVE  */
+    IN = 278,                      /* IN  */
+    NUMBER = 279,                  /* NUMBER  */
+    STRING = 280,                  /* STRING  */
+    MATCH = 281,                   /* MATCH  */
+    SUBST = 282,                   /* SUBST  */
+    LITERAL = 283,                 /* LITERAL  */
+    TOKEN = 284                    /* TOKEN  */
+  };
+  typedef enum yytokentype yytoken_kind_t;
 #endif
+/* Token kinds.  */
+#define YYEMPTY -2
+#define YYEOF 0
+#define YYerror 256
+#define YYUNDEF 257
+#define STYLE 258
+#define PREPEND 259
+#define APPEND 260
+#define SKIP 261
+#define BREAK 262
+#define MACRO 263
+#define INCLUDE 264
+#define SET 265
+#define FIELDS 266
+#define FIELD 267
+#define JSON 268
+#define AND 269
+#define OR 270
+#define NOT 271
+#define COMPARE 272
+#define DECIMAL 273
+#define ENTER 274
+#define LEAVE 275
+#define ADD 276
+#define REMOVE 277
+#define IN 278
+#define NUMBER 279
+#define STRING 280
+#define MATCH 281
+#define SUBST 282
+#define LITERAL 283
+#define TOKEN 284
+
+/* Value type.  */
+#if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
+union YYSTYPE
+{
+#line 59 "parser.y"
 
-#if ! defined (YYSTYPE) && ! defined (YYSTYPE_IS_DECLARED)
-#line 54 "parser.y"
-typedef union YYSTYPE {
 	const char *text;
 	int32_t number;
 	Rule *rule;
@@ -144,156 +226,445 @@ typedef union YYSTYPE {
 	LList *list;
 	Style *style;
 	StyleInfo *styleinfo;
+	Condition *condition;
+	double decimal;
 	struct {
 		const char *text;
 		RegexFlags flags;
 	} regex;
-} YYSTYPE;
-/* Line 191 of yacc.c.  */
-#line 154 "parser.c"
-# define yystype YYSTYPE /* obsolescent; will be withdrawn */
-# define YYSTYPE_IS_DECLARED 1
+
+#line 237 "parser.c"
+
+};
+typedef union YYSTYPE YYSTYPE;
 # define YYSTYPE_IS_TRIVIAL 1
+# define YYSTYPE_IS_DECLARED 1
 #endif
 
 
+extern YYSTYPE yylval;
 
-/* Copy the second part of user declarations.  */
 
+int yyparse (Parser *parser);
 
-/* Line 214 of yacc.c.  */
-#line 166 "parser.c"
 
-#if ! defined (yyoverflow) || YYERROR_VERBOSE
+#endif /* !YY_YY_PARSER_H_INCLUDED  */
+/* Symbol kind.  */
+enum yysymbol_kind_t
+{
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_STYLE = 3,                      /* STYLE  */
+  YYSYMBOL_PREPEND = 4,                    /* PREPEND  */
+  YYSYMBOL_APPEND = 5,                     /* APPEND  */
+  YYSYMBOL_SKIP = 6,                       /* SKIP  */
+  YYSYMBOL_BREAK = 7,                      /* BREAK  */
+  YYSYMBOL_MACRO = 8,                      /* MACRO  */
+  YYSYMBOL_INCLUDE = 9,                    /* INCLUDE  */
+  YYSYMBOL_SET = 10,                       /* SET  */
+  YYSYMBOL_FIELDS = 11,                    /* FIELDS  */
+  YYSYMBOL_FIELD = 12,                     /* FIELD  */
+  YYSYMBOL_JSON = 13,                      /* JSON  */
+  YYSYMBOL_AND = 14,                       /* AND  */
+  YYSYMBOL_OR = 15,                        /* OR  */
+  YYSYMBOL_NOT = 16,                       /* NOT  */
+  YYSYMBOL_COMPARE = 17,                   /* COMPARE  */
+  YYSYMBOL_DECIMAL = 18,                   /* DECIMAL  */
+  YYSYMBOL_ENTER = 19,                     /* ENTER  */
+  YYSYMBOL_LEAVE = 20,                     /* LEAVE  */
+  YYSYMBOL_ADD = 21,                       /* ADD  */
+  YYSYMBOL_REMOVE = 22,                    /* REMOVE  */
+  YYSYMBOL_IN = 23,                        /* IN  */
+  YYSYMBOL_NUMBER = 24,                    /* NUMBER  */
+  YYSYMBOL_STRING = 25,                    /* STRING  */
+  YYSYMBOL_MATCH = 26,                     /* MATCH  */
+  YYSYMBOL_SUBST = 27,                     /* SUBST  */
+  YYSYMBOL_LITERAL = 28,                   /* LITERAL  */
+  YYSYMBOL_TOKEN = 29,                     /* TOKEN  */
+  YYSYMBOL_30_ = 30,                       /* '{'  */
+  YYSYMBOL_31_ = 31,                       /* '}'  */
+  YYSYMBOL_32_ = 32,                       /* ','  */
+  YYSYMBOL_33_ = 33,                       /* '('  */
+  YYSYMBOL_34_ = 34,                       /* ')'  */
+  YYSYMBOL_YYACCEPT = 35,                  /* $accept  */
+  YYSYMBOL_input = 36,                     /* input  */
+  YYSYMBOL_input_item = 37,                /* input_item  */
+  YYSYMBOL_style_decl = 38,                /* style_decl  */
+  YYSYMBOL_style_body = 39,                /* style_body  */
+  YYSYMBOL_style_stmts = 40,               /* style_stmts  */
+  YYSYMBOL_style_stmt = 41,                /* style_stmt  */
+  YYSYMBOL_macro_decl = 42,                /* macro_decl  */
+  YYSYMBOL_match_decl = 43,                /* match_decl  */
+  YYSYMBOL_match_items = 44,               /* match_items  */
+  YYSYMBOL_match_item = 45,                /* match_item  */
+  YYSYMBOL_match_body = 46,                /* match_body  */
+  YYSYMBOL_match_stmts = 47,               /* match_stmts  */
+  YYSYMBOL_match_stmt = 48,                /* match_stmt  */
+  YYSYMBOL_condition = 49,                 /* condition  */
+  YYSYMBOL_and_condition = 50,             /* and_condition  */
+  YYSYMBOL_not_condition = 51,             /* not_condition  */
+  YYSYMBOL_decimal = 52,                   /* decimal  */
+  YYSYMBOL_string = 53                     /* string  */
+};
+typedef enum yysymbol_kind_t yysymbol_kind_t;
 
-# ifndef YYFREE
-#  define YYFREE free
+
+
+
+#ifdef short
+# undef short
+#endif
+
+/* On compilers that do not define __PTRDIFF_MAX__ etc., make sure
+   <limits.h> and (if available) <stdint.h> are included
+   so that the code can choose integer types of a good width.  */
+
+#ifndef __PTRDIFF_MAX__
+# include <limits.h> /* INFRINGES ON USER NAME SPACE */
+# if defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stdint.h> /* INFRINGES ON USER NAME SPACE */
+#  define YY_STDINT_H
 # endif
-# ifndef YYMALLOC
-#  define YYMALLOC malloc
+#endif
+
+/* Narrow types that promote to a signed type and that can represent a
+   signed or unsigned integer of at least N bits.  In tables they can
+   save space and decrease cache pressure.  Promoting to a signed type
+   helps avoid bugs in integer arithmetic.  */
+
+#ifdef __INT_LEAST8_MAX__
+typedef __INT_LEAST8_TYPE__ yytype_int8;
+#elif defined YY_STDINT_H
+typedef int_least8_t yytype_int8;
+#else
+typedef signed char yytype_int8;
+#endif
+
+#ifdef __INT_LEAST16_MAX__
+typedef __INT_LEAST16_TYPE__ yytype_int16;
+#elif defined YY_STDINT_H
+typedef int_least16_t yytype_int16;
+#else
+typedef short yytype_int16;
+#endif
+
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
+#endif
+
+#if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST8_TYPE__ yytype_uint8;
+#elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST8_MAX <= INT_MAX)
+typedef uint_least8_t yytype_uint8;
+#elif !defined __UINT_LEAST8_MAX__ && UCHAR_MAX <= INT_MAX
+typedef unsigned char yytype_uint8;
+#else
+typedef short yytype_uint8;
+#endif
+
+#if defined __UINT_LEAST16_MAX__ && __UINT_LEAST16_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST16_TYPE__ yytype_uint16;
+#elif (!defined __UINT_LEAST16_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST16_MAX <= INT_MAX)
+typedef uint_least16_t yytype_uint16;
+#elif !defined __UINT_LEAST16_MAX__ && USHRT_MAX <= INT_MAX
+typedef unsigned short yytype_uint16;
+#else
+typedef int yytype_uint16;
+#endif
+
+#ifndef YYPTRDIFF_T
+# if defined __PTRDIFF_TYPE__ && defined __PTRDIFF_MAX__
+#  define YYPTRDIFF_T __PTRDIFF_TYPE__
+#  define YYPTRDIFF_MAXIMUM __PTRDIFF_MAX__
+# elif defined PTRDIFF_MAX
+#  ifndef ptrdiff_t
+#   include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  endif
+#  define YYPTRDIFF_T ptrdiff_t
+#  define YYPTRDIFF_MAXIMUM PTRDIFF_MAX
+# else
+#  define YYPTRDIFF_T long
+#  define YYPTRDIFF_MAXIMUM LONG_MAX
+# endif
+#endif
+
+#ifndef YYSIZE_T
+# ifdef __SIZE_TYPE__
+#  define YYSIZE_T __SIZE_TYPE__
+# elif defined size_t
+#  define YYSIZE_T size_t
+# elif defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  define YYSIZE_T size_t
+# else
+#  define YYSIZE_T unsigned
+# endif
+#endif
+
+#define YYSIZE_MAXIMUM                                  \
+  YY_CAST (YYPTRDIFF_T,                                 \
+           (YYPTRDIFF_MAXIMUM < YY_CAST (YYSIZE_T, -1)  \
+            ? YYPTRDIFF_MAXIMUM                         \
+            : YY_CAST (YYSIZE_T, -1)))
+
+#define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
+
+
+/* Stored state numbers (used for stacks). */
+typedef yytype_int8 yy_state_t;
+
+/* State numbers in computations.  */
+typedef int yy_state_fast_t;
+
+#ifndef YY_
+# if defined YYENABLE_NLS && YYENABLE_NLS
+#  if ENABLE_NLS
+#   include <libintl.h> /* INFRINGES ON USER NAME SPACE */
+#   define YY_(Msgid) dgettext ("bison-runtime", Msgid)
+#  endif
+# endif
+# ifndef YY_
+#  define YY_(Msgid) Msgid
+# endif
+#endif
+
+
+#ifndef YY_ATTRIBUTE_PURE
+# if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
+# else
+#  define YY_ATTRIBUTE_PURE
+# endif
+#endif
+
+#ifndef YY_ATTRIBUTE_UNUSED
+# if defined __GNUC__ && 2 < __GNUC__ + (7 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_UNUSED __attribute__ ((__unused__))
+# else
+#  define YY_ATTRIBUTE_UNUSED
+# endif
+#endif
+
+/* Suppress unused-variable warnings by "using" E.  */
+#if ! defined lint || defined __GNUC__
+# define YY_USE(E) ((void) (E))
+#else
+# define YY_USE(E) /* empty */
+#endif
+
+/* Suppress an incorrect diagnostic about yylval being uninitialized.  */
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
+    _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
 # endif
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
+    _Pragma ("GCC diagnostic pop")
+#else
+# define YY_INITIAL_VALUE(Value) Value
+#endif
+#ifndef YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END
+#endif
+#ifndef YY_INITIAL_VALUE
+# define YY_INITIAL_VALUE(Value) /* Nothing. */
+#endif
+
+#if defined __cplusplus && defined __GNUC__ && ! defined __ICC && 6 <= __GNUC__
+# define YY_IGNORE_USELESS_CAST_BEGIN                          \
+    _Pragma ("GCC diagnostic push")                            \
+    _Pragma ("GCC diagnostic ignored \"-Wuseless-cast\"")
+# define YY_IGNORE_USELESS_CAST_END            \
+    _Pragma ("GCC diagnostic pop")
+#endif
+#ifndef YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_END
+#endif
+
+
+#define YY_ASSERT(E) ((void) (0 && (E)))
+
+#if !defined yyoverflow
 
 /* The parser invokes alloca or malloc; define the necessary symbols.  */
 
 # ifdef YYSTACK_USE_ALLOCA
 #  if YYSTACK_USE_ALLOCA
-#   define YYSTACK_ALLOC alloca
-#  endif
-# else
-#  if defined (alloca) || defined (_ALLOCA_H)
-#   define YYSTACK_ALLOC alloca
-#  else
 #   ifdef __GNUC__
 #    define YYSTACK_ALLOC __builtin_alloca
+#   elif defined __BUILTIN_VA_ARG_INCR
+#    include <alloca.h> /* INFRINGES ON USER NAME SPACE */
+#   elif defined _AIX
+#    define YYSTACK_ALLOC __alloca
+#   elif defined _MSC_VER
+#    include <malloc.h> /* INFRINGES ON USER NAME SPACE */
+#    define alloca _alloca
+#   else
+#    define YYSTACK_ALLOC alloca
+#    if ! defined _ALLOCA_H && ! defined EXIT_SUCCESS
+#     include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
+      /* Use EXIT_SUCCESS as a witness for stdlib.h.  */
+#     ifndef EXIT_SUCCESS
+#      define EXIT_SUCCESS 0
+#     endif
+#    endif
 #   endif
 #  endif
 # endif
 
 # ifdef YYSTACK_ALLOC
-   /* Pacify GCC's `empty if-body' warning. */
+   /* Pacify GCC's 'empty if-body' warning.  */
 #  define YYSTACK_FREE(Ptr) do { /* empty */; } while (0)
-# else
-#  if defined (__STDC__) || defined (__cplusplus)
-#   include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
-#   define YYSIZE_T size_t
+#  ifndef YYSTACK_ALLOC_MAXIMUM
+    /* The OS might guarantee only one guard page at the bottom of the stack,
+       and a page size can be as small as 4096 bytes.  So we cannot safely
+       invoke alloca (N) if N exceeds 4096.  Use a slightly smaller number
+       to allow for a few compiler-allocated temporary stack slots.  */
+#   define YYSTACK_ALLOC_MAXIMUM 4032 /* reasonable circa 2006 */
 #  endif
+# else
 #  define YYSTACK_ALLOC YYMALLOC
 #  define YYSTACK_FREE YYFREE
+#  ifndef YYSTACK_ALLOC_MAXIMUM
+#   define YYSTACK_ALLOC_MAXIMUM YYSIZE_MAXIMUM
+#  endif
+#  if (defined __cplusplus && ! defined EXIT_SUCCESS \
+       && ! ((defined YYMALLOC || defined malloc) \
+             && (defined YYFREE || defined free)))
+#   include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
+#   ifndef EXIT_SUCCESS
+#    define EXIT_SUCCESS 0
+#   endif
+#  endif
+#  ifndef YYMALLOC
+#   define YYMALLOC malloc
+#   if ! defined malloc && ! defined EXIT_SUCCESS
+void *malloc (YYSIZE_T); /* INFRINGES ON USER NAME SPACE */
+#   endif
+#  endif
+#  ifndef YYFREE
+#   define YYFREE free
+#   if ! defined free && ! defined EXIT_SUCCESS
+void free (void *); /* INFRINGES ON USER NAME SPACE */
+#   endif
+#  endif
 # endif
-#endif /* ! defined (yyoverflow) || YYERROR_VERBOSE */
+#endif /* !defined yyoverflow */
 
-
-#if (! defined (yyoverflow) \
-     && (! defined (__cplusplus) \
-	 || (defined (YYSTYPE_IS_TRIVIAL) && YYSTYPE_IS_TRIVIAL)))
+#if (! defined yyoverflow \
+     && (! defined __cplusplus \
+         || (defined YYSTYPE_IS_TRIVIAL && YYSTYPE_IS_TRIVIAL)))
 
 /* A type that is properly aligned for any stack member.  */
 union yyalloc
 {
-  short int yyss;
-  YYSTYPE yyvs;
-  };
+  yy_state_t yyss_alloc;
+  YYSTYPE yyvs_alloc;
+};
 
 /* The size of the maximum gap between one aligned stack and the next.  */
-# define YYSTACK_GAP_MAXIMUM (sizeof (union yyalloc) - 1)
+# define YYSTACK_GAP_MAXIMUM (YYSIZEOF (union yyalloc) - 1)
 
 /* The size of an array large to enough to hold all stacks, each with
    N elements.  */
 # define YYSTACK_BYTES(N) \
-     ((N) * (sizeof (short int) + sizeof (YYSTYPE))			\
+     ((N) * (YYSIZEOF (yy_state_t) + YYSIZEOF (YYSTYPE)) \
       + YYSTACK_GAP_MAXIMUM)
 
-/* Copy COUNT objects from FROM to TO.  The source and destination do
-   not overlap.  */
-# ifndef YYCOPY
-#  if defined (__GNUC__) && 1 < __GNUC__
-#   define YYCOPY(To, From, Count) \
-      __builtin_memcpy (To, From, (Count) * sizeof (*(From)))
-#  else
-#   define YYCOPY(To, From, Count)		\
-      do					\
-	{					\
-	  register YYSIZE_T yyi;		\
-	  for (yyi = 0; yyi < (Count); yyi++)	\
-	    (To)[yyi] = (From)[yyi];		\
-	}					\
-      while (0)
-#  endif
-# endif
+# define YYCOPY_NEEDED 1
 
 /* Relocate STACK from its old location to the new one.  The
    local variables YYSIZE and YYSTACKSIZE give the old and new number of
    elements in the stack, and YYPTR gives the new location of the
    stack.  Advance YYPTR to a properly aligned location for the next
    stack.  */
-# define YYSTACK_RELOCATE(Stack)					\
-    do									\
-      {									\
-	YYSIZE_T yynewbytes;						\
-	YYCOPY (&yyptr->Stack, Stack, yysize);				\
-	Stack = &yyptr->Stack;						\
-	yynewbytes = yystacksize * sizeof (*Stack) + YYSTACK_GAP_MAXIMUM; \
-	yyptr += yynewbytes / sizeof (*yyptr);				\
-      }									\
+# define YYSTACK_RELOCATE(Stack_alloc, Stack)                           \
+    do                                                                  \
+      {                                                                 \
+        YYPTRDIFF_T yynewbytes;                                         \
+        YYCOPY (&yyptr->Stack_alloc, Stack, yysize);                    \
+        Stack = &yyptr->Stack_alloc;                                    \
+        yynewbytes = yystacksize * YYSIZEOF (*Stack) + YYSTACK_GAP_MAXIMUM; \
+        yyptr += yynewbytes / YYSIZEOF (*yyptr);                        \
+      }                                                                 \
     while (0)
 
 #endif
 
-#if defined (__STDC__) || defined (__cplusplus)
-   typedef signed char yysigned_char;
-#else
-   typedef short int yysigned_char;
-#endif
+#if defined YYCOPY_NEEDED && YYCOPY_NEEDED
+/* Copy COUNT objects from SRC to DST.  The source and destination do
+   not overlap.  */
+# ifndef YYCOPY
+#  if defined __GNUC__ && 1 < __GNUC__
+#   define YYCOPY(Dst, Src, Count) \
+      __builtin_memcpy (Dst, Src, YY_CAST (YYSIZE_T, (Count)) * sizeof (*(Src)))
+#  else
+#   define YYCOPY(Dst, Src, Count)              \
+      do                                        \
+        {                                       \
+          YYPTRDIFF_T yyi;                      \
+          for (yyi = 0; yyi < (Count); yyi++)   \
+            (Dst)[yyi] = (Src)[yyi];            \
+        }                                       \
+      while (0)
+#  endif
+# endif
+#endif /* !YYCOPY_NEEDED */
 
-/* YYFINAL -- State number of the termination state. */
+/* YYFINAL -- State number of the termination state.  */
 #define YYFINAL  2
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   68
-
-/* YYNTOKENS -- Number of terminals. */
-#define YYNTOKENS  18
-/* YYNNTS -- Number of nonterminals. */
-#define YYNNTS  14
-/* YYNRULES -- Number of rules. */
-#define YYNRULES  33
-/* YYNRULES -- Number of states. */
-#define YYNSTATES  49
-
-/* YYTRANSLATE(YYLEX) -- Bison symbol number corresponding to YYLEX.  */
-#define YYUNDEFTOK  2
-#define YYMAXUTOK   269
-
-#define YYTRANSLATE(YYX) 						\
-  ((unsigned int) (YYX) <= YYMAXUTOK ? yytranslate[YYX] : YYUNDEFTOK)
-
-/* YYTRANSLATE[YYLEX] -- Bison symbol number corresponding to YYLEX.  */
-static const unsigned char yytranslate[] =
+#define YYLAST   241
+
+/* YYNTOKENS -- Number of terminals.  */
+#define YYNTOKENS  35
+/* YYNNTS -- Number of nonterminals.  */
+#define YYNNTS  19
+/* YYNRULES -- Number of rules.  */
+#define YYNRULES  56
+/* YYNSTATES -- Number of states.  */
+#define YYNSTATES  95
+
+/* YYMAXUTOK -- Last valid token kind.  */
+#define YYMAXUTOK   284
+
+
+/* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex, with out-of-bounds checking.  */
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
+
+/* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex.  */
+static const yytype_int8 yytranslate[] =
 {
        0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-       2,     2,     2,     2,    17,     2,     2,     2,     2,     2,
+      33,    34,     2,     2,    32,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
@@ -301,7 +672,7 @@ static const unsigned char yytranslate[] =
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-       2,     2,     2,    15,     2,    16,     2,     2,     2,     2,
+       2,     2,     2,    30,     2,    31,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
@@ -315,233 +686,245 @@ static const unsigned char yytranslate[] =
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
-       5,     6,     7,     8,     9,    10,    11,    12,    13,    14
+       5,     6,     7,     8,     9,    10,    11,    12,    13,    14,
+      15,    16,    17,    18,    19,    20,    21,    22,    23,    24,
+      25,    26,    27,    28,    29
 };
 
 #if YYDEBUG
-/* YYPRHS[YYN] -- Index of the first RHS symbol of rule number YYN in
-   YYRHS.  */
-static const unsigned char yyprhs[] =
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+static const yytype_int16 yyrline[] =
 {
-       0,     0,     3,     6,     7,     9,    11,    13,    16,    19,
-      23,    27,    29,    32,    33,    35,    38,    41,    45,    48,
-      52,    54,    56,    58,    62,    64,    67,    68,    71,    73,
-      76,    79,    81,    83
+       0,   102,   102,   103,   106,   112,   118,   119,   124,   131,
+     133,   134,   136,   137,   139,   144,   145,   148,   151,   154,
+     155,   157,   165,   166,   169,   173,   178,   181,   186,   187,
+     189,   190,   193,   197,   205,   213,   218,   222,   223,   224,
+     225,   233,   234,   235,   236,   237,   240,   241,   243,   244,
+     246,   247,   248,   250,   251,   255,   256
 };
+#endif
 
-/* YYRHS -- A `-1'-separated list of the rules' RHS. */
-static const yysigned_char yyrhs[] =
-{
-      19,     0,    -1,    19,    20,    -1,    -1,    21,    -1,    25,
-      -1,    31,    -1,     4,    29,    -1,     5,    29,    -1,     3,
-      12,    22,    -1,    15,    23,    16,    -1,    24,    -1,    23,
-      24,    -1,    -1,    12,    -1,     4,    12,    -1,     5,    12,
-      -1,     8,    12,    29,    -1,    27,    29,    -1,    27,    17,
-      28,    -1,    28,    -1,    13,    -1,    11,    -1,    15,    30,
-      16,    -1,    31,    -1,    30,    31,    -1,    -1,     9,    12,
-      -1,    12,    -1,    14,    13,    -1,    10,    12,    -1,     6,
-      -1,     7,    -1,    26,    -1
-};
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
 
-/* YYRLINE[YYN] -- source line where rule number YYN was defined.  */
-static const unsigned char yyrline[] =
-{
-       0,    82,    82,    83,    86,    89,    92,    93,    96,   101,
-     103,   104,   106,   107,   109,   114,   115,   118,   121,   124,
-     125,   127,   128,   131,   132,   134,   135,   138,   139,   147,
-     148,   149,   150,   151
-};
-#endif
+#if YYDEBUG || 0
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
 
-#if YYDEBUG || YYERROR_VERBOSE
-/* YYTNME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
-   First, the terminals, then, starting at YYNTOKENS, nonterminals. */
+/* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
+   First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
 static const char *const yytname[] =
 {
-  "$end", "error", "$undefined", "STYLE", "PREPEND", "APPEND", "SKIP",
-  "BREAK", "MACRO", "INCLUDE", "SET", "NUMBER", "STRING", "MATCH", "SUBST",
-  "'{'", "'}'", "','", "$accept", "input", "input_item", "style_decl",
-  "style_body", "style_stmts", "style_stmt", "macro_decl", "match_decl",
-  "match_items", "match_item", "match_body", "match_stmts", "match_stmt", 0
+  "\"end of file\"", "error", "\"invalid token\"", "STYLE", "PREPEND",
+  "APPEND", "SKIP", "BREAK", "MACRO", "INCLUDE", "SET", "FIELDS", "FIELD",
+  "JSON", "AND", "OR", "NOT", "COMPARE", "DECIMAL", "ENTER", "LEAVE",
+  "ADD", "REMOVE", "IN", "NUMBER", "STRING", "MATCH", "SUBST", "LITERAL",
+  "TOKEN", "'{'", "'}'", "','", "'('", "')'", "$accept", "input",
+  "input_item", "style_decl", "style_body", "style_stmts", "style_stmt",
+  "macro_decl", "match_decl", "match_items", "match_item", "match_body",
+  "match_stmts", "match_stmt", "condition", "and_condition",
+  "not_condition", "decimal", "string", YY_NULLPTR
 };
-#endif
 
-# ifdef YYPRINT
-/* YYTOKNUM[YYLEX-NUM] -- Internal token number corresponding to
-   token YYLEX-NUM.  */
-static const unsigned short int yytoknum[] =
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
 {
-       0,   256,   257,   258,   259,   260,   261,   262,   263,   264,
-     265,   266,   267,   268,   269,   123,   125,    44
-};
-# endif
+  return yytname[yysymbol];
+}
+#endif
 
-/* YYR1[YYN] -- Symbol number of symbol that rule YYN derives.  */
-static const unsigned char yyr1[] =
-{
-       0,    18,    19,    19,    20,    20,    20,    20,    20,    21,
-      22,    22,    23,    23,    24,    24,    24,    25,    26,    27,
-      27,    28,    28,    29,    29,    30,    30,    31,    31,    31,
-      31,    31,    31,    31
-};
+#define YYPACT_NINF (-52)
+
+#define yypact_value_is_default(Yyn) \
+  ((Yyn) == YYPACT_NINF)
+
+#define YYTABLE_NINF (-1)
+
+#define yytable_value_is_error(Yyn) \
+  0
 
-/* YYR2[YYN] -- Number of symbols composing right hand side of rule YYN.  */
-static const unsigned char yyr2[] =
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
+static const yytype_int16 yypact[] =
 {
-       0,     2,     2,     0,     1,     1,     1,     2,     2,     3,
-       3,     1,     2,     0,     1,     2,     2,     3,     2,     3,
-       1,     1,     1,     3,     1,     2,     0,     2,     1,     2,
-       2,     1,     1,     1
+     -52,    77,   -52,    14,   155,   155,   -52,   -52,    14,    14,
+      14,   -21,   -13,    -8,    -2,    14,    14,    14,    14,    14,
+       4,    -6,   -52,     9,   -52,   -52,    -2,   -52,   -52,   -52,
+     -52,   102,   -52,   -52,   130,    11,   -52,   -52,   -52,     8,
+     -52,   -52,   -52,   -52,   155,   -52,   -52,   -52,   -52,   -52,
+       4,   -52,   -52,   -52,    14,    14,    14,    10,   -52,   -52,
+     -11,    33,   -52,    -2,   -52,    -2,    14,    14,   -52,   -52,
+     -52,   -52,   180,   -52,   -52,   -52,   155,   -52,   -52,   -52,
+     208,   -52,   -52,   -52,    11,   -52,   -52,   -52,     1,   -52,
+     -52,   -52,   -52,   -52,   -52
 };
 
-/* YYDEFACT[STATE-NAME] -- Default rule to reduce with in state
-   STATE-NUM when YYTABLE doesn't specify something else to do.  Zero
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
    means the default is an error.  */
-static const unsigned char yydefact[] =
+static const yytype_int8 yydefact[] =
 {
-       3,     0,     1,     0,     0,     0,    31,    32,     0,     0,
-       0,    22,    28,    21,     0,     2,     4,     5,    33,     0,
-      20,     6,     0,    26,     7,    24,     8,     0,    27,    30,
-      29,     0,    18,     0,     0,    14,    13,     9,    11,     0,
-      17,    19,    15,    16,     0,    23,    25,    10,    12
+       3,     0,     1,     0,     0,     0,    42,    43,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+      22,    33,    21,     0,    23,    24,     0,     2,     4,     5,
+      44,     0,    20,     6,     0,    47,    49,    55,    56,     0,
+      31,     7,    29,     8,     0,    32,    41,    25,    26,    27,
+       0,    50,    35,    36,     0,     0,     0,     0,    31,    40,
+       0,     0,    18,     0,    45,     0,     0,     0,    13,     9,
+      11,    14,     0,    17,    37,    38,     0,    54,    53,    52,
+       0,    51,    22,    19,    46,    48,    15,    16,     0,    28,
+      30,    39,    34,    10,    12
 };
 
-/* YYDEFGOTO[NTERM-NUM]. */
-static const yysigned_char yydefgoto[] =
+/* YYPGOTO[NTERM-NUM].  */
+static const yytype_int8 yypgoto[] =
 {
-      -1,     1,    15,    16,    37,    44,    38,    17,    18,    19,
-      20,    24,    39,    25
+     -52,   -52,   -52,   -52,   -52,   -52,   -51,   -52,   -52,   -52,
+     -20,    -4,   -15,    -1,    21,   -14,   -12,   -52,     0
 };
 
-/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
-   STATE-NUM.  */
-#define YYPACT_NINF -37
-static const yysigned_char yypact[] =
+/* YYDEFGOTO[NTERM-NUM].  */
+static const yytype_int8 yydefgoto[] =
 {
-     -37,    21,   -37,    -8,    53,    53,   -37,   -37,    -5,    -3,
-       0,   -37,   -37,   -37,     5,   -37,   -37,   -37,   -37,    30,
-     -37,   -37,     1,   -37,   -37,   -37,   -37,    53,   -37,   -37,
-     -37,     6,   -37,     8,    10,   -37,   -37,   -37,   -37,    42,
-     -37,   -37,   -37,   -37,    -2,   -37,   -37,   -37,   -37
+       0,     1,    27,    28,    69,    88,    70,    29,    30,    31,
+      32,    41,    72,    42,    34,    35,    36,    79,    71
 };
 
-/* YYPGOTO[NTERM-NUM].  */
-static const yysigned_char yypgoto[] =
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
+static const yytype_int8 yytable[] =
 {
-     -37,   -37,   -37,   -37,   -37,   -37,   -36,   -37,   -37,   -37,
-     -20,    -4,   -37,    -1
+      33,    43,    51,    39,    63,    66,    67,    47,    44,    45,
+      46,    48,    66,    67,    14,    52,    53,    54,    55,    56,
+      49,    57,    50,    81,    58,    65,    37,    62,    77,    38,
+      64,    26,    93,    37,    78,    59,    38,    94,    68,    37,
+      73,    83,    38,    80,    11,    12,    13,    60,     0,    84,
+       0,     0,     0,    85,    74,    75,    76,    82,     0,    22,
+       0,    24,    25,     0,     0,     0,    86,    87,     0,     0,
+       0,    90,    91,     0,     0,     0,     0,     2,     0,    90,
+       3,     4,     5,     6,     7,     8,     9,    10,    11,    12,
+      13,     0,     0,    14,     0,     0,    15,    16,    17,    18,
+      19,    20,    21,    22,    23,    24,    25,     0,     6,     7,
+      26,     9,    10,    11,    12,    13,     0,     0,    14,     0,
+       0,    15,    16,    17,    18,    19,    20,    21,    22,    23,
+      24,    25,    40,     0,    61,    26,     6,     7,     0,     9,
+      10,    11,    12,    13,     0,    63,    14,     0,     0,    15,
+      16,    17,    18,    19,    20,    21,    22,    23,    24,    25,
+      40,     6,     7,    26,     9,    10,    11,    12,    13,     0,
+       0,    14,     0,     0,    15,    16,    17,    18,    19,    20,
+      21,    22,    23,    24,    25,    40,     6,     7,    26,     9,
+      10,    11,    12,    13,     0,     0,    14,     0,     0,    15,
+      16,    17,    18,    19,    20,    21,    22,    23,    24,    25,
+       0,    89,     0,    26,     6,     7,     0,     9,    10,    11,
+      12,    13,     0,     0,    14,     0,     0,    15,    16,    17,
+      18,    19,    20,    21,    22,    23,    24,    25,     0,    92,
+       0,    26
 };
 
-/* YYTABLE[YYPACT[STATE-NUM]].  What to do in state STATE-NUM.  If
-   positive, shift that token.  If negative, reduce the rule which
-   number is the opposite.  If zero, do what YYDEFACT says.
-   If YYTABLE_NINF, syntax error.  */
-#define YYTABLE_NINF -1
-static const unsigned char yytable[] =
+static const yytype_int8 yycheck[] =
 {
-      21,    26,    33,    34,    22,    33,    34,    27,    48,    28,
-      35,    41,    29,    35,    47,    32,    36,    11,    30,    13,
-      42,     2,    43,    40,     3,     4,     5,     6,     7,     8,
-       9,    10,    11,    12,    13,    14,     6,     7,    46,     9,
-      10,    11,    12,    13,    14,    23,     0,    31,     6,     7,
-       0,     9,    10,    11,    12,    13,    14,     0,    45,     6,
-       7,     0,     9,    10,    11,    12,    13,    14,    23
+       1,     5,    14,     3,    15,     4,     5,    28,     8,     9,
+      10,    24,     4,     5,    16,    15,    16,    17,    18,    19,
+      28,    17,    24,    34,    30,    14,    25,    31,    18,    28,
+      34,    33,    31,    25,    24,    26,    28,    88,    30,    25,
+      44,    61,    28,    58,    11,    12,    13,    26,    -1,    63,
+      -1,    -1,    -1,    65,    54,    55,    56,    24,    -1,    26,
+      -1,    28,    29,    -1,    -1,    -1,    66,    67,    -1,    -1,
+      -1,    72,    76,    -1,    -1,    -1,    -1,     0,    -1,    80,
+       3,     4,     5,     6,     7,     8,     9,    10,    11,    12,
+      13,    -1,    -1,    16,    -1,    -1,    19,    20,    21,    22,
+      23,    24,    25,    26,    27,    28,    29,    -1,     6,     7,
+      33,     9,    10,    11,    12,    13,    -1,    -1,    16,    -1,
+      -1,    19,    20,    21,    22,    23,    24,    25,    26,    27,
+      28,    29,    30,    -1,    32,    33,     6,     7,    -1,     9,
+      10,    11,    12,    13,    -1,    15,    16,    -1,    -1,    19,
+      20,    21,    22,    23,    24,    25,    26,    27,    28,    29,
+      30,     6,     7,    33,     9,    10,    11,    12,    13,    -1,
+      -1,    16,    -1,    -1,    19,    20,    21,    22,    23,    24,
+      25,    26,    27,    28,    29,    30,     6,     7,    33,     9,
+      10,    11,    12,    13,    -1,    -1,    16,    -1,    -1,    19,
+      20,    21,    22,    23,    24,    25,    26,    27,    28,    29,
+      -1,    31,    -1,    33,     6,     7,    -1,     9,    10,    11,
+      12,    13,    -1,    -1,    16,    -1,    -1,    19,    20,    21,
+      22,    23,    24,    25,    26,    27,    28,    29,    -1,    31,
+      -1,    33
 };
 
-static const yysigned_char yycheck[] =
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
+static const yytype_int8 yystos[] =
 {
-       1,     5,     4,     5,    12,     4,     5,    12,    44,    12,
-      12,    31,    12,    12,    16,    19,    15,    11,    13,    13,
-      12,     0,    12,    27,     3,     4,     5,     6,     7,     8,
-       9,    10,    11,    12,    13,    14,     6,     7,    39,     9,
-      10,    11,    12,    13,    14,    15,    -1,    17,     6,     7,
-      -1,     9,    10,    11,    12,    13,    14,    -1,    16,     6,
-       7,    -1,     9,    10,    11,    12,    13,    14,    15
+       0,    36,     0,     3,     4,     5,     6,     7,     8,     9,
+      10,    11,    12,    13,    16,    19,    20,    21,    22,    23,
+      24,    25,    26,    27,    28,    29,    33,    37,    38,    42,
+      43,    44,    45,    48,    49,    50,    51,    25,    28,    53,
+      30,    46,    48,    46,    53,    53,    53,    28,    24,    28,
+      24,    51,    53,    53,    53,    53,    53,    17,    30,    26,
+      49,    32,    46,    15,    46,    14,     4,     5,    30,    39,
+      41,    53,    47,    46,    53,    53,    53,    18,    24,    52,
+      47,    34,    24,    45,    50,    51,    53,    53,    40,    31,
+      48,    46,    31,    31,    41
 };
 
-/* YYSTOS[STATE-NUM] -- The (internal number of the) accessing
-   symbol of state STATE-NUM.  */
-static const unsigned char yystos[] =
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr1[] =
 {
-       0,    19,     0,     3,     4,     5,     6,     7,     8,     9,
-      10,    11,    12,    13,    14,    20,    21,    25,    26,    27,
-      28,    31,    12,    15,    29,    31,    29,    12,    12,    12,
-      13,    17,    29,     4,     5,    12,    15,    22,    24,    30,
-      29,    28,    12,    12,    23,    16,    31,    16,    24
+       0,    35,    36,    36,    37,    37,    37,    37,    37,    38,
+      39,    39,    40,    40,    41,    41,    41,    42,    43,    44,
+      44,    45,    45,    45,    45,    45,    45,    45,    46,    46,
+      47,    47,    48,    48,    48,    48,    48,    48,    48,    48,
+      48,    48,    48,    48,    48,    48,    49,    49,    50,    50,
+      51,    51,    51,    52,    52,    53,    53
 };
 
-#if ! defined (YYSIZE_T) && defined (__SIZE_TYPE__)
-# define YYSIZE_T __SIZE_TYPE__
-#endif
-#if ! defined (YYSIZE_T) && defined (size_t)
-# define YYSIZE_T size_t
-#endif
-#if ! defined (YYSIZE_T)
-# if defined (__STDC__) || defined (__cplusplus)
-#  include <stddef.h> /* INFRINGES ON USER NAME SPACE */
-#  define YYSIZE_T size_t
-# endif
-#endif
-#if ! defined (YYSIZE_T)
-# define YYSIZE_T unsigned int
-#endif
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr2[] =
+{
+       0,     2,     2,     0,     1,     1,     1,     2,     2,     3,
+       3,     1,     2,     0,     1,     2,     2,     3,     2,     3,
+       1,     1,     1,     1,     1,     2,     2,     2,     3,     1,
+       2,     0,     2,     1,     4,     2,     2,     3,     3,     4,
+       2,     2,     1,     1,     1,     2,     3,     1,     3,     1,
+       2,     3,     3,     1,     1,     1,     1
+};
 
-#define yyerrok		(yyerrstatus = 0)
-#define yyclearin	(yychar = YYEMPTY)
-#define YYEMPTY		(-2)
-#define YYEOF		0
 
-#define YYACCEPT	goto yyacceptlab
-#define YYABORT		goto yyabortlab
-#define YYERROR		goto yyerrorlab
+enum { YYENOMEM = -2 };
 
+#define yyerrok         (yyerrstatus = 0)
+#define yyclearin       (yychar = YYEMPTY)
 
-/* Like YYERROR except do call yyerror.  This remains here temporarily
-   to ease the transition to the new meaning of YYERROR, for GCC.
-   Once GCC version 2 has supplanted version 1, this can go.  */
+#define YYACCEPT        goto yyacceptlab
+#define YYABORT         goto yyabortlab
+#define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
 
-#define YYFAIL		goto yyerrlab
 
 #define YYRECOVERING()  (!!yyerrstatus)
 
-#define YYBACKUP(Token, Value)					\
-do								\
-  if (yychar == YYEMPTY && yylen == 1)				\
-    {								\
-      yychar = (Token);						\
-      yylval = (Value);						\
-      yytoken = YYTRANSLATE (yychar);				\
-      YYPOPSTACK;						\
-      goto yybackup;						\
-    }								\
-  else								\
-    { 								\
-      yyerror ("syntax error: cannot back up");\
-      YYERROR;							\
-    }								\
-while (0)
-
-#define YYTERROR	1
-#define YYERRCODE	256
-
-/* YYLLOC_DEFAULT -- Compute the default location (before the actions
-   are run).  */
-
-#ifndef YYLLOC_DEFAULT
-# define YYLLOC_DEFAULT(Current, Rhs, N)		\
-   ((Current).first_line   = (Rhs)[1].first_line,	\
-    (Current).first_column = (Rhs)[1].first_column,	\
-    (Current).last_line    = (Rhs)[N].last_line,	\
-    (Current).last_column  = (Rhs)[N].last_column)
-#endif
+#define YYBACKUP(Token, Value)                                    \
+  do                                                              \
+    if (yychar == YYEMPTY)                                        \
+      {                                                           \
+        yychar = (Token);                                         \
+        yylval = (Value);                                         \
+        YYPOPSTACK (yylen);                                       \
+        yystate = *yyssp;                                         \
+        goto yybackup;                                            \
+      }                                                           \
+    else                                                          \
+      {                                                           \
+        yyerror (parser, YY_("syntax error: cannot back up")); \
+        YYERROR;                                                  \
+      }                                                           \
+  while (0)
+
+/* Backward compatibility with an undocumented macro.
+   Use YYerror or YYUNDEF. */
+#define YYERRCODE YYUNDEF
 
-/* YYLEX -- calling `yylex' with the right arguments.  */
-
-#ifdef YYLEX_PARAM
-# define YYLEX yylex (YYLEX_PARAM)
-#else
-# define YYLEX yylex ()
-#endif
 
 /* Enable debugging if requested.  */
 #if YYDEBUG
@@ -551,54 +934,82 @@ while (0)
 #  define YYFPRINTF fprintf
 # endif
 
-# define YYDPRINTF(Args)			\
-do {						\
-  if (yydebug)					\
-    YYFPRINTF Args;				\
+# define YYDPRINTF(Args)                        \
+do {                                            \
+  if (yydebug)                                  \
+    YYFPRINTF Args;                             \
 } while (0)
 
-# define YYDSYMPRINT(Args)			\
-do {						\
-  if (yydebug)					\
-    yysymprint Args;				\
-} while (0)
 
-# define YYDSYMPRINTF(Title, Token, Value, Location)		\
-do {								\
-  if (yydebug)							\
-    {								\
-      YYFPRINTF (stderr, "%s ", Title);				\
-      yysymprint (stderr, 					\
-                  Token, Value);	\
-      YYFPRINTF (stderr, "\n");					\
-    }								\
+
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
+do {                                                                      \
+  if (yydebug)                                                            \
+    {                                                                     \
+      YYFPRINTF (stderr, "%s ", Title);                                   \
+      yy_symbol_print (stderr,                                            \
+                  Kind, Value, parser); \
+      YYFPRINTF (stderr, "\n");                                           \
+    }                                                                     \
 } while (0)
 
+
+/*-----------------------------------.
+| Print this symbol's value on YYO.  |
+`-----------------------------------*/
+
+static void
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, Parser *parser)
+{
+  FILE *yyoutput = yyo;
+  YY_USE (yyoutput);
+  YY_USE (parser);
+  if (!yyvaluep)
+    return;
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+}
+
+
+/*---------------------------.
+| Print this symbol on YYO.  |
+`---------------------------*/
+
+static void
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, Parser *parser)
+{
+  YYFPRINTF (yyo, "%s %s (",
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
+
+  yy_symbol_value_print (yyo, yykind, yyvaluep, parser);
+  YYFPRINTF (yyo, ")");
+}
+
 /*------------------------------------------------------------------.
 | yy_stack_print -- Print the state stack from its BOTTOM up to its |
 | TOP (included).                                                   |
 `------------------------------------------------------------------*/
 
-#if defined (__STDC__) || defined (__cplusplus)
-static void
-yy_stack_print (short int *bottom, short int *top)
-#else
 static void
-yy_stack_print (bottom, top)
-    short int *bottom;
-    short int *top;
-#endif
+yy_stack_print (yy_state_t *yybottom, yy_state_t *yytop)
 {
   YYFPRINTF (stderr, "Stack now");
-  for (/* Nothing. */; bottom <= top; ++bottom)
-    YYFPRINTF (stderr, " %d", *bottom);
+  for (; yybottom <= yytop; yybottom++)
+    {
+      int yybot = *yybottom;
+      YYFPRINTF (stderr, " %d", yybot);
+    }
   YYFPRINTF (stderr, "\n");
 }
 
-# define YY_STACK_PRINT(Bottom, Top)				\
-do {								\
-  if (yydebug)							\
-    yy_stack_print ((Bottom), (Top));				\
+# define YY_STACK_PRINT(Bottom, Top)                            \
+do {                                                            \
+  if (yydebug)                                                  \
+    yy_stack_print ((Bottom), (Top));                           \
 } while (0)
 
 
@@ -606,45 +1017,45 @@ do {								\
 | Report that the YYRULE is going to be reduced.  |
 `------------------------------------------------*/
 
-#if defined (__STDC__) || defined (__cplusplus)
 static void
-yy_reduce_print (int yyrule)
-#else
-static void
-yy_reduce_print (yyrule)
-    int yyrule;
-#endif
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
+                 int yyrule, Parser *parser)
 {
+  int yylno = yyrline[yyrule];
+  int yynrhs = yyr2[yyrule];
   int yyi;
-  unsigned int yylno = yyrline[yyrule];
-  YYFPRINTF (stderr, "Reducing stack by rule %d (line %u), ",
+  YYFPRINTF (stderr, "Reducing stack by rule %d (line %d):\n",
              yyrule - 1, yylno);
-  /* Print the symbols being reduced, and their result.  */
-  for (yyi = yyprhs[yyrule]; 0 <= yyrhs[yyi]; yyi++)
-    YYFPRINTF (stderr, "%s ", yytname [yyrhs[yyi]]);
-  YYFPRINTF (stderr, "-> %s\n", yytname [yyr1[yyrule]]);
+  /* The symbols being reduced.  */
+  for (yyi = 0; yyi < yynrhs; yyi++)
+    {
+      YYFPRINTF (stderr, "   $%d = ", yyi + 1);
+      yy_symbol_print (stderr,
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)], parser);
+      YYFPRINTF (stderr, "\n");
+    }
 }
 
-# define YY_REDUCE_PRINT(Rule)		\
-do {					\
-  if (yydebug)				\
-    yy_reduce_print (Rule);		\
+# define YY_REDUCE_PRINT(Rule)          \
+do {                                    \
+  if (yydebug)                          \
+    yy_reduce_print (yyssp, yyvsp, Rule, parser); \
 } while (0)
 
 /* Nonzero means print parse trace.  It is left uninitialized so that
    multiple parsers can coexist.  */
 int yydebug;
 #else /* !YYDEBUG */
-# define YYDPRINTF(Args)
-# define YYDSYMPRINT(Args)
-# define YYDSYMPRINTF(Title, Token, Value, Location)
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
 # define YY_STACK_PRINT(Bottom, Top)
 # define YY_REDUCE_PRINT(Rule)
 #endif /* !YYDEBUG */
 
 
 /* YYINITDEPTH -- initial size of the parser's stacks.  */
-#ifndef	YYINITDEPTH
+#ifndef YYINITDEPTH
 # define YYINITDEPTH 200
 #endif
 
@@ -652,363 +1063,319 @@ int yydebug;
    if the built-in stack extension method is used).
 
    Do not make this value too large; the results are undefined if
-   SIZE_MAX < YYSTACK_BYTES (YYMAXDEPTH)
+   YYSTACK_ALLOC_MAXIMUM < YYSTACK_BYTES (YYMAXDEPTH)
    evaluated with infinite-precision integer arithmetic.  */
 
-#if defined (YYMAXDEPTH) && YYMAXDEPTH == 0
-# undef YYMAXDEPTH
-#endif
-
 #ifndef YYMAXDEPTH
 # define YYMAXDEPTH 10000
 #endif
 
-
 
-#if YYERROR_VERBOSE
 
-# ifndef yystrlen
-#  if defined (__GLIBC__) && defined (_STRING_H)
-#   define yystrlen strlen
-#  else
-/* Return the length of YYSTR.  */
-static YYSIZE_T
-#   if defined (__STDC__) || defined (__cplusplus)
-yystrlen (const char *yystr)
-#   else
-yystrlen (yystr)
-     const char *yystr;
-#   endif
-{
-  register const char *yys = yystr;
 
-  while (*yys++ != '\0')
-    continue;
 
-  return yys - yystr - 1;
-}
-#  endif
-# endif
 
-# ifndef yystpcpy
-#  if defined (__GLIBC__) && defined (_STRING_H) && defined (_GNU_SOURCE)
-#   define yystpcpy stpcpy
-#  else
-/* Copy YYSRC to YYDEST, returning the address of the terminating '\0' in
-   YYDEST.  */
-static char *
-#   if defined (__STDC__) || defined (__cplusplus)
-yystpcpy (char *yydest, const char *yysrc)
-#   else
-yystpcpy (yydest, yysrc)
-     char *yydest;
-     const char *yysrc;
-#   endif
+/*-----------------------------------------------.
+| Release the memory associated to this symbol.  |
+`-----------------------------------------------*/
+
+static void
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, Parser *parser)
 {
-  register char *yyd = yydest;
-  register const char *yys = yysrc;
+  YY_USE (yyvaluep);
+  YY_USE (parser);
+  if (!yymsg)
+    yymsg = "Deleting";
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
+
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  switch (yykind)
+    {
+    case YYSYMBOL_style_decl: /* style_decl  */
+#line 94 "parser.y"
+            { free_style(((*yyvaluep).style)); }
+#line 1099 "parser.c"
+        break;
 
-  while ((*yyd++ = *yys++) != '\0')
-    continue;
+    case YYSYMBOL_style_body: /* style_body  */
+#line 99 "parser.y"
+            { llist_iterate(((*yyvaluep).list), (IteratorFunc) free); llist_free(((*yyvaluep).list)); }
+#line 1105 "parser.c"
+        break;
 
-  return yyd - 1;
-}
-#  endif
-# endif
+    case YYSYMBOL_style_stmts: /* style_stmts  */
+#line 99 "parser.y"
+            { llist_iterate(((*yyvaluep).list), (IteratorFunc) free); llist_free(((*yyvaluep).list)); }
+#line 1111 "parser.c"
+        break;
 
-#endif /* !YYERROR_VERBOSE */
+    case YYSYMBOL_style_stmt: /* style_stmt  */
+#line 95 "parser.y"
+            { free(((*yyvaluep).styleinfo)); }
+#line 1117 "parser.c"
+        break;
 
-
+    case YYSYMBOL_macro_decl: /* macro_decl  */
+#line 93 "parser.y"
+            { free_macro(((*yyvaluep).macro)); }
+#line 1123 "parser.c"
+        break;
 
-#if YYDEBUG
-/*--------------------------------.
-| Print this symbol on YYOUTPUT.  |
-`--------------------------------*/
+    case YYSYMBOL_match_decl: /* match_decl  */
+#line 91 "parser.y"
+            { free_rule(((*yyvaluep).rule)); }
+#line 1129 "parser.c"
+        break;
 
-#if defined (__STDC__) || defined (__cplusplus)
-static void
-yysymprint (FILE *yyoutput, int yytype, YYSTYPE *yyvaluep)
-#else
-static void
-yysymprint (yyoutput, yytype, yyvaluep)
-    FILE *yyoutput;
-    int yytype;
-    YYSTYPE *yyvaluep;
-#endif
-{
-  /* Pacify ``unused variable'' warnings.  */
-  (void) yyvaluep;
+    case YYSYMBOL_match_items: /* match_items  */
+#line 97 "parser.y"
+            { llist_iterate(((*yyvaluep).list), (IteratorFunc) free_match); llist_free(((*yyvaluep).list)); }
+#line 1135 "parser.c"
+        break;
 
-  if (yytype < YYNTOKENS)
-    {
-      YYFPRINTF (yyoutput, "token %s (", yytname[yytype]);
-# ifdef YYPRINT
-      YYPRINT (yyoutput, yytoknum[yytype], *yyvaluep);
-# endif
-    }
-  else
-    YYFPRINTF (yyoutput, "nterm %s (", yytname[yytype]);
+    case YYSYMBOL_match_item: /* match_item  */
+#line 92 "parser.y"
+            { free_match(((*yyvaluep).match)); }
+#line 1141 "parser.c"
+        break;
 
-  switch (yytype)
-    {
-      default:
+    case YYSYMBOL_match_body: /* match_body  */
+#line 91 "parser.y"
+            { free_rule(((*yyvaluep).rule)); }
+#line 1147 "parser.c"
         break;
-    }
-  YYFPRINTF (yyoutput, ")");
-}
 
-#endif /* ! YYDEBUG */
-/*-----------------------------------------------.
-| Release the memory associated to this symbol.  |
-`-----------------------------------------------*/
+    case YYSYMBOL_match_stmts: /* match_stmts  */
+#line 98 "parser.y"
+            { llist_iterate(((*yyvaluep).list), (IteratorFunc) free_rule); llist_free(((*yyvaluep).list)); }
+#line 1153 "parser.c"
+        break;
 
-#if defined (__STDC__) || defined (__cplusplus)
-static void
-yydestruct (int yytype, YYSTYPE *yyvaluep)
-#else
-static void
-yydestruct (yytype, yyvaluep)
-    int yytype;
-    YYSTYPE *yyvaluep;
-#endif
-{
-  /* Pacify ``unused variable'' warnings.  */
-  (void) yyvaluep;
+    case YYSYMBOL_match_stmt: /* match_stmt  */
+#line 91 "parser.y"
+            { free_rule(((*yyvaluep).rule)); }
+#line 1159 "parser.c"
+        break;
 
-  switch (yytype)
-    {
+    case YYSYMBOL_condition: /* condition  */
+#line 96 "parser.y"
+            { free_condition(((*yyvaluep).condition)); }
+#line 1165 "parser.c"
+        break;
+
+    case YYSYMBOL_and_condition: /* and_condition  */
+#line 96 "parser.y"
+            { free_condition(((*yyvaluep).condition)); }
+#line 1171 "parser.c"
+        break;
+
+    case YYSYMBOL_not_condition: /* not_condition  */
+#line 96 "parser.y"
+            { free_condition(((*yyvaluep).condition)); }
+#line 1177 "parser.c"
+        break;
 
       default:
         break;
     }
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
-
-
-/* Prevent warnings from -Wmissing-prototypes.  */
 
-#ifdef YYPARSE_PARAM
-# if defined (__STDC__) || defined (__cplusplus)
-int yyparse (void *YYPARSE_PARAM);
-# else
-int yyparse ();
-# endif
-#else /* ! YYPARSE_PARAM */
-#if defined (__STDC__) || defined (__cplusplus)
-int yyparse (void);
-#else
-int yyparse ();
-#endif
-#endif /* ! YYPARSE_PARAM */
 
-
-
-/* The lookahead symbol.  */
+/* Lookahead token kind.  */
 int yychar;
 
 /* The semantic value of the lookahead symbol.  */
 YYSTYPE yylval;
-
 /* Number of syntax errors so far.  */
 int yynerrs;
 
 
 
+
 /*----------.
 | yyparse.  |
 `----------*/
 
-#ifdef YYPARSE_PARAM
-# if defined (__STDC__) || defined (__cplusplus)
-int yyparse (void *YYPARSE_PARAM)
-# else
-int yyparse (YYPARSE_PARAM)
-  void *YYPARSE_PARAM;
-# endif
-#else /* ! YYPARSE_PARAM */
-#if defined (__STDC__) || defined (__cplusplus)
-int
-yyparse (void)
-#else
 int
-yyparse ()
-
-#endif
-#endif
+yyparse (Parser *parser)
 {
-  
-  register int yystate;
-  register int yyn;
-  int yyresult;
-  /* Number of tokens to shift before error messages enabled.  */
-  int yyerrstatus;
-  /* Lookahead token as an internal (translated) token number.  */
-  int yytoken = 0;
+    yy_state_fast_t yystate = 0;
+    /* Number of tokens to shift before error messages enabled.  */
+    int yyerrstatus = 0;
 
-  /* Three stacks and their tools:
-     `yyss': related to states,
-     `yyvs': related to semantic values,
-     `yyls': related to locations.
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
+       to reallocate them elsewhere.  */
 
-     Refer to the stacks thru separate pointers, to allow yyoverflow
-     to reallocate them elsewhere.  */
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
 
-  /* The state stack.  */
-  short int yyssa[YYINITDEPTH];
-  short int *yyss = yyssa;
-  register short int *yyssp;
+    /* The state stack: array, bottom, top.  */
+    yy_state_t yyssa[YYINITDEPTH];
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
 
-  /* The semantic value stack.  */
-  YYSTYPE yyvsa[YYINITDEPTH];
-  YYSTYPE *yyvs = yyvsa;
-  register YYSTYPE *yyvsp;
-
-
-
-#define YYPOPSTACK   (yyvsp--, yyssp--)
-
-  YYSIZE_T yystacksize = YYINITDEPTH;
+    /* The semantic value stack: array, bottom, top.  */
+    YYSTYPE yyvsa[YYINITDEPTH];
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
 
+  int yyn;
+  /* The return value of yyparse.  */
+  int yyresult;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
   /* The variables used to return semantic value and location from the
      action routines.  */
   YYSTYPE yyval;
 
 
-  /* When reducing, the number of symbols on the RHS of the reduced
-     rule.  */
-  int yylen;
-
-  YYDPRINTF ((stderr, "Starting parse\n"));
 
-  yystate = 0;
-  yyerrstatus = 0;
-  yynerrs = 0;
-  yychar = YYEMPTY;		/* Cause a token to be read.  */
+#define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N))
 
-  /* Initialize stack pointers.
-     Waste one element of value and location stack
-     so that they stay on the same level as the state stack.
-     The wasted elements are never initialized.  */
+  /* The number of symbols on the RHS of the reduced rule.
+     Keep to zero when no symbol should be popped.  */
+  int yylen = 0;
 
-  yyssp = yyss;
-  yyvsp = yyvs;
+  YYDPRINTF ((stderr, "Starting parse\n"));
 
+  yychar = YYEMPTY; /* Cause a token to be read.  */
 
   goto yysetstate;
 
+
 /*------------------------------------------------------------.
-| yynewstate -- Push a new state, which is found in yystate.  |
+| yynewstate -- push a new state, which is found in yystate.  |
 `------------------------------------------------------------*/
- yynewstate:
+yynewstate:
   /* In all cases, when you get here, the value and location stacks
-     have just been pushed. so pushing a state here evens the stacks.
-     */
+     have just been pushed.  So pushing a state here evens the stacks.  */
   yyssp++;
 
- yysetstate:
-  *yyssp = yystate;
+
+/*--------------------------------------------------------------------.
+| yysetstate -- set current state (the top of the stack) to yystate.  |
+`--------------------------------------------------------------------*/
+yysetstate:
+  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
+  YY_ASSERT (0 <= yystate && yystate < YYNSTATES);
+  YY_IGNORE_USELESS_CAST_BEGIN
+  *yyssp = YY_CAST (yy_state_t, yystate);
+  YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
 
   if (yyss + yystacksize - 1 <= yyssp)
+#if !defined yyoverflow && !defined YYSTACK_RELOCATE
+    YYNOMEM;
+#else
     {
       /* Get the current used size of the three stacks, in elements.  */
-      YYSIZE_T yysize = yyssp - yyss + 1;
+      YYPTRDIFF_T yysize = yyssp - yyss + 1;
 
-#ifdef yyoverflow
+# if defined yyoverflow
       {
-	/* Give user a chance to reallocate the stack. Use copies of
-	   these so that the &'s don't force the real ones into
-	   memory.  */
-	YYSTYPE *yyvs1 = yyvs;
-	short int *yyss1 = yyss;
-
-
-	/* Each stack pointer address is followed by the size of the
-	   data in use in that stack, in bytes.  This used to be a
-	   conditional around just the two extra args, but that might
-	   be undefined if yyoverflow is a macro.  */
-	yyoverflow ("parser stack overflow",
-		    &yyss1, yysize * sizeof (*yyssp),
-		    &yyvs1, yysize * sizeof (*yyvsp),
-
-		    &yystacksize);
-
-	yyss = yyss1;
-	yyvs = yyvs1;
+        /* Give user a chance to reallocate the stack.  Use copies of
+           these so that the &'s don't force the real ones into
+           memory.  */
+        yy_state_t *yyss1 = yyss;
+        YYSTYPE *yyvs1 = yyvs;
+
+        /* Each stack pointer address is followed by the size of the
+           data in use in that stack, in bytes.  This used to be a
+           conditional around just the two extra args, but that might
+           be undefined if yyoverflow is a macro.  */
+        yyoverflow (YY_("memory exhausted"),
+                    &yyss1, yysize * YYSIZEOF (*yyssp),
+                    &yyvs1, yysize * YYSIZEOF (*yyvsp),
+                    &yystacksize);
+        yyss = yyss1;
+        yyvs = yyvs1;
       }
-#else /* no yyoverflow */
-# ifndef YYSTACK_RELOCATE
-      goto yyoverflowlab;
-# else
+# else /* defined YYSTACK_RELOCATE */
       /* Extend the stack our own way.  */
       if (YYMAXDEPTH <= yystacksize)
-	goto yyoverflowlab;
+        YYNOMEM;
       yystacksize *= 2;
       if (YYMAXDEPTH < yystacksize)
-	yystacksize = YYMAXDEPTH;
+        yystacksize = YYMAXDEPTH;
 
       {
-	short int *yyss1 = yyss;
-	union yyalloc *yyptr =
-	  (union yyalloc *) YYSTACK_ALLOC (YYSTACK_BYTES (yystacksize));
-	if (! yyptr)
-	  goto yyoverflowlab;
-	YYSTACK_RELOCATE (yyss);
-	YYSTACK_RELOCATE (yyvs);
-
+        yy_state_t *yyss1 = yyss;
+        union yyalloc *yyptr =
+          YY_CAST (union yyalloc *,
+                   YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
+        if (! yyptr)
+          YYNOMEM;
+        YYSTACK_RELOCATE (yyss_alloc, yyss);
+        YYSTACK_RELOCATE (yyvs_alloc, yyvs);
 #  undef YYSTACK_RELOCATE
-	if (yyss1 != yyssa)
-	  YYSTACK_FREE (yyss1);
+        if (yyss1 != yyssa)
+          YYSTACK_FREE (yyss1);
       }
 # endif
-#endif /* no yyoverflow */
 
       yyssp = yyss + yysize - 1;
       yyvsp = yyvs + yysize - 1;
 
-
-      YYDPRINTF ((stderr, "Stack size increased to %lu\n",
-		  (unsigned long int) yystacksize));
+      YY_IGNORE_USELESS_CAST_BEGIN
+      YYDPRINTF ((stderr, "Stack size increased to %ld\n",
+                  YY_CAST (long, yystacksize)));
+      YY_IGNORE_USELESS_CAST_END
 
       if (yyss + yystacksize - 1 <= yyssp)
-	YYABORT;
+        YYABORT;
     }
+#endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
 
-  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
+
+  if (yystate == YYFINAL)
+    YYACCEPT;
 
   goto yybackup;
 
+
 /*-----------.
 | yybackup.  |
 `-----------*/
 yybackup:
-
-/* Do appropriate processing given the current state.  */
-/* Read a lookahead token if we need one and don't already have one.  */
-/* yyresume: */
+  /* Do appropriate processing given the current state.  Read a
+     lookahead token if we need one and don't already have one.  */
 
   /* First try to decide what to do without reference to lookahead token.  */
-
   yyn = yypact[yystate];
-  if (yyn == YYPACT_NINF)
+  if (yypact_value_is_default (yyn))
     goto yydefault;
 
   /* Not known => get a lookahead token if don't already have one.  */
 
-  /* YYCHAR is either YYEMPTY or YYEOF or a valid lookahead symbol.  */
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
   if (yychar == YYEMPTY)
     {
-      YYDPRINTF ((stderr, "Reading a token: "));
-      yychar = YYLEX;
+      YYDPRINTF ((stderr, "Reading a token\n"));
+      yychar = yylex ();
     }
 
   if (yychar <= YYEOF)
     {
-      yychar = yytoken = YYEOF;
+      yychar = YYEOF;
+      yytoken = YYSYMBOL_YYEOF;
       YYDPRINTF ((stderr, "Now at end of input.\n"));
     }
+  else if (yychar == YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      goto yyerrlab1;
+    }
   else
     {
       yytoken = YYTRANSLATE (yychar);
-      YYDSYMPRINTF ("Next token is", yytoken, &yylval, &yylloc);
+      YY_SYMBOL_PRINT ("Next token is", yytoken, &yylval, &yylloc);
     }
 
   /* If the proper action on seeing token YYTOKEN is to reduce or to
@@ -1019,31 +1386,26 @@ yybackup:
   yyn = yytable[yyn];
   if (yyn <= 0)
     {
-      if (yyn == 0 || yyn == YYTABLE_NINF)
-	goto yyerrlab;
+      if (yytable_value_is_error (yyn))
+        goto yyerrlab;
       yyn = -yyn;
       goto yyreduce;
     }
 
-  if (yyn == YYFINAL)
-    YYACCEPT;
-
-  /* Shift the lookahead token.  */
-  YYDPRINTF ((stderr, "Shifting token %s, ", yytname[yytoken]));
-
-  /* Discard the token being shifted unless it is eof.  */
-  if (yychar != YYEOF)
-    yychar = YYEMPTY;
-
-  *++yyvsp = yylval;
-
-
   /* Count tokens shifted since error; after three, turn off error
      status.  */
   if (yyerrstatus)
     yyerrstatus--;
 
+  /* Shift the lookahead token.  */
+  YY_SYMBOL_PRINT ("Shifting", yytoken, &yylval, &yylloc);
   yystate = yyn;
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  *++yyvsp = yylval;
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+
+  /* Discard the shifted token.  */
+  yychar = YYEMPTY;
   goto yynewstate;
 
 
@@ -1058,14 +1420,14 @@ yydefault:
 
 
 /*-----------------------------.
-| yyreduce -- Do a reduction.  |
+| yyreduce -- do a reduction.  |
 `-----------------------------*/
 yyreduce:
   /* yyn is the number of a rule to reduce with.  */
   yylen = yyr2[yyn];
 
   /* If YYLEN is nonzero, implement the default value of the action:
-     `$$ = $1'.
+     '$$ = $1'.
 
      Otherwise, the following line sets YYVAL to garbage.
      This behavior is undocumented and Bison
@@ -1078,293 +1440,438 @@ yyreduce:
   YY_REDUCE_PRINT (yyn);
   switch (yyn)
     {
-        case 4:
-#line 86 "parser.y"
-    { if (hmap_contains_key(script->styles, yyvsp[0].style->name))
-										      script_die(_("style `%s' already defined"), yyvsp[0].style->name);
-										  hmap_put(script->styles, yyvsp[0].style->name, yyvsp[0].style); }
+  case 4: /* input_item: style_decl  */
+#line 106 "parser.y"
+                                                                { if (hmap_contains_key(parser->script->styles, (yyvsp[0].style)->name)) {
+											  script_error(parser, _("style `%s' already defined"), (yyvsp[0].style)->name);
+											  free_style((yyvsp[0].style));
+											  YYABORT;
+										  }
+										  hmap_put(parser->script->styles, (yyvsp[0].style)->name, (yyvsp[0].style)); }
+#line 1452 "parser.c"
     break;
 
-  case 5:
-#line 89 "parser.y"
-    { if (hmap_contains_key(script->macros, yyvsp[0].macro->name))
-										      script_die(_("macro `%s' already defined"), yyvsp[0].macro->name);
-										  hmap_put(script->macros, yyvsp[0].macro->name, yyvsp[0].macro); }
+  case 5: /* input_item: macro_decl  */
+#line 112 "parser.y"
+                                                                { if (hmap_contains_key(parser->script->macros, (yyvsp[0].macro)->name)) {
+											  script_error(parser, _("macro `%s' already defined"), (yyvsp[0].macro)->name);
+											  free_macro((yyvsp[0].macro));
+											  YYABORT;
+										  }
+										  hmap_put(parser->script->macros, (yyvsp[0].macro)->name, (yyvsp[0].macro)); }
+#line 1463 "parser.c"
     break;
 
-  case 6:
-#line 92 "parser.y"
-    { llist_add(file->rules, yyvsp[0].rule); }
+  case 6: /* input_item: match_stmt  */
+#line 118 "parser.y"
+                                                                { llist_add(parser->file->rules, (yyvsp[0].rule)); }
+#line 1469 "parser.c"
     break;
 
-  case 7:
-#line 93 "parser.y"
-    { if (script->prepend_rule != NULL)
-											  script_die(_("prepend rule already specifed"));
-										  script->prepend_rule = yyvsp[0].rule; }
+  case 7: /* input_item: PREPEND match_body  */
+#line 119 "parser.y"
+                                                        { if (parser->script->prepend_rule != NULL) {
+											  free_rule((yyvsp[0].rule));
+											  PARSE_ERROR(_("prepend rule already specifed"));
+										  }
+										  parser->script->prepend_rule = (yyvsp[0].rule); }
+#line 1479 "parser.c"
     break;
 
-  case 8:
-#line 96 "parser.y"
-    { if (script->append_rule != NULL)
-											  script_die(_("append rule already specifed"));
-										  script->append_rule = yyvsp[0].rule; }
+  case 8: /* input_item: APPEND match_body  */
+#line 124 "parser.y"
+                                                                { if (parser->script->append_rule != NULL) {
+											  free_rule((yyvsp[0].rule));
+											  PARSE_ERROR(_("append rule already specifed"));
+										  }
+										  parser->script->append_rule = (yyvsp[0].rule); }
+#line 1489 "parser.c"
     break;
 
-  case 9:
-#line 101 "parser.y"
-    { yyval.style = new_style(yyvsp[-1].text, yyvsp[0].list); }
+  case 9: /* style_decl: STYLE string style_body  */
+#line 131 "parser.y"
+                                                { (yyval.style) = new_style((yyvsp[-1].text), (yyvsp[0].list)); }
+#line 1495 "parser.c"
     break;
 
-  case 10:
-#line 103 "parser.y"
-    { yyval.list = yyvsp[-1].list; }
+  case 10: /* style_body: '{' style_stmts '}'  */
+#line 133 "parser.y"
+                                                        { (yyval.list) = (yyvsp[-1].list); }
+#line 1501 "parser.c"
     break;
 
-  case 11:
-#line 104 "parser.y"
-    { yyval.list = llist_new(); llist_add(yyval.list, yyvsp[0].styleinfo); }
+  case 11: /* style_body: style_stmt  */
+#line 134 "parser.y"
+                                                                { (yyval.list) = llist_new(); llist_add((yyval.list), (yyvsp[0].styleinfo)); }
+#line 1507 "parser.c"
     break;
 
-  case 12:
-#line 106 "parser.y"
-    { llist_add(yyvsp[-1].list, yyvsp[0].styleinfo); yyval.list = yyvsp[-1].list; }
+  case 12: /* style_stmts: style_stmts style_stmt  */
+#line 136 "parser.y"
+                                        { llist_add((yyvsp[-1].list), (yyvsp[0].styleinfo)); (yyval.list) = (yyvsp[-1].list); }
+#line 1513 "parser.c"
     break;
 
-  case 13:
-#line 107 "parser.y"
-    { yyval.list = llist_new(); }
+  case 13: /* style_stmts: %empty  */
+#line 137 "parser.y"
+                                                                { (yyval.list) = llist_new(); }
+#line 1519 "parser.c"
     break;
 
-  case 14:
-#line 109 "parser.y"
-    { Style *style = hmap_get(script->styles, yyvsp[0].text);
+  case 14: /* style_stmt: string  */
+#line 139 "parser.y"
+                                                                { Style *style = hmap_get(parser->script->styles, (yyvsp[0].text));
 						  				  if (style == NULL)
-						      				  script_die(_("no such style `%s'"), yyvsp[0].text);
-										  yyval.styleinfo = new_styleinfo_style(style);
+						      				  PARSE_ERROR(_("no such style `%s'"), (yyvsp[0].text));
+										  (yyval.styleinfo) = new_styleinfo_style(style);
 										}
+#line 1529 "parser.c"
     break;
 
-  case 15:
-#line 114 "parser.y"
-    { yyval.styleinfo = new_styleinfo_pre(yyvsp[0].text); }
+  case 15: /* style_stmt: PREPEND string  */
+#line 144 "parser.y"
+                                                                { (yyval.styleinfo) = new_styleinfo_pre((yyvsp[0].text)); }
+#line 1535 "parser.c"
     break;
 
-  case 16:
-#line 115 "parser.y"
-    { yyval.styleinfo = new_styleinfo_post(yyvsp[0].text); }
+  case 16: /* style_stmt: APPEND string  */
+#line 145 "parser.y"
+                                                                { (yyval.styleinfo) = new_styleinfo_post((yyvsp[0].text)); }
+#line 1541 "parser.c"
     break;
 
-  case 17:
-#line 118 "parser.y"
-    { yyval.macro = new_macro(yyvsp[-1].text, yyvsp[0].rule); }
+  case 17: /* macro_decl: MACRO string match_body  */
+#line 148 "parser.y"
+                                                { (yyval.macro) = new_macro((yyvsp[-1].text), (yyvsp[0].rule)); }
+#line 1547 "parser.c"
     break;
 
-  case 18:
-#line 121 "parser.y"
-    { yyval.rule = new_match_rule(yyvsp[-1].list, yyvsp[0].rule); }
+  case 18: /* match_decl: match_items match_body  */
+#line 151 "parser.y"
+                                                { (yyval.rule) = new_match_rule((yyvsp[-1].list), (yyvsp[0].rule)); }
+#line 1553 "parser.c"
     break;
 
-  case 19:
-#line 124 "parser.y"
-    { llist_add(yyvsp[-2].list, yyvsp[0].match); yyval.list = yyvsp[-2].list; }
+  case 19: /* match_items: match_items ',' match_item  */
+#line 154 "parser.y"
+                                                { llist_add((yyvsp[-2].list), (yyvsp[0].match)); (yyval.list) = (yyvsp[-2].list); }
+#line 1559 "parser.c"
     break;
 
-  case 20:
-#line 125 "parser.y"
-    { yyval.list = llist_new(); llist_add(yyval.list, yyvsp[0].match); }
+  case 20: /* match_items: match_item  */
+#line 155 "parser.y"
+                                                                        { (yyval.list) = llist_new(); llist_add((yyval.list), (yyvsp[0].match)); }
+#line 1565 "parser.c"
     break;
 
-  case 21:
-#line 127 "parser.y"
-    { yyval.match = new_regex_match(yyvsp[0].regex.text, yyvsp[0].regex.flags); }
+  case 21: /* match_item: MATCH  */
+#line 157 "parser.y"
+                                                                { char *msg;
+										  (yyval.match) = new_regex_match(parser->script, (yyvsp[0].regex).text, (yyvsp[0].regex).flags, &msg);
+										  if ((yyval.match) == NULL) {
+											  script_error(parser, "%s", msg);
+											  free(msg);
+											  YYABORT;
+										  }
+										}
+#line 1578 "parser.c"
     break;
 
-  case 22:
-#line 128 "parser.y"
-    { yyval.match = new_subex_match(yyvsp[0].number); }
+  case 22: /* match_item: NUMBER  */
+#line 165 "parser.y"
+                                                                        { (yyval.match) = new_subex_match((yyvsp[0].number)); }
+#line 1584 "parser.c"
     break;
 
-  case 23:
-#line 131 "parser.y"
-    { yyval.rule = new_multi_rule(yyvsp[-1].list); }
+  case 23: /* match_item: LITERAL  */
+#line 166 "parser.y"
+                                                                        { if ((yyvsp[0].regex).text[0] == '\0')
+											  PARSE_ERROR(_("empty literal match"));
+										  (yyval.match) = new_literal_match((yyvsp[0].regex).text, (yyvsp[0].regex).flags); }
+#line 1592 "parser.c"
     break;
 
-  case 25:
-#line 134 "parser.y"
-    { llist_add(yyvsp[-1].list, yyvsp[0].rule); yyval.list = yyvsp[-1].list; }
+  case 24: /* match_item: TOKEN  */
+#line 169 "parser.y"
+                                                                        { const Token *token = identify_token((yyvsp[0].regex).text);
+										  if (token == NULL)
+											  PARSE_ERROR(_("no such built-in token `@%s'"), (yyvsp[0].regex).text);
+										  (yyval.match) = new_token_match(token, (yyvsp[0].regex).flags); }
+#line 1601 "parser.c"
     break;
 
-  case 26:
-#line 135 "parser.y"
-    { yyval.list = llist_new(); }
+  case 25: /* match_item: FIELDS LITERAL  */
+#line 173 "parser.y"
+                                                                { if ((yyvsp[0].regex).flags != 0)
+											  PARSE_ERROR(_("flags not allowed after string"));
+										  if ((yyvsp[0].regex).text[0] == '\0')
+											  PARSE_ERROR(_("empty field delimiter"));
+										  (yyval.match) = new_field_match((yyvsp[0].regex).text, 0); }
+#line 1611 "parser.c"
     break;
 
-  case 27:
-#line 138 "parser.y"
-    { yyval.rule = include_script(yyvsp[0].text); }
+  case 26: /* match_item: FIELD NUMBER  */
+#line 178 "parser.y"
+                                                                { if ((yyvsp[0].number) == 0)
+											  PARSE_ERROR(_("field numbers start at 1"));
+										  (yyval.match) = new_field_match(" ", (yyvsp[0].number)); }
+#line 1619 "parser.c"
     break;
 
-  case 28:
-#line 139 "parser.y"
-    { if (hmap_contains_key(script->macros, yyvsp[0].text)) {
-											  yyval.rule = new_macro_rule(hmap_get(script->macros, yyvsp[0].text));
-										  } else if (hmap_contains_key(script->styles, yyvsp[0].text)) {
-											  yyval.rule = new_style_rule(hmap_get(script->styles, yyvsp[0].text));
+  case 27: /* match_item: JSON LITERAL  */
+#line 181 "parser.y"
+                                                                { if ((yyvsp[0].regex).flags != 0)
+											  PARSE_ERROR(_("flags not allowed after string"));
+										  (yyval.match) = new_json_match((yyvsp[0].regex).text); }
+#line 1627 "parser.c"
+    break;
+
+  case 28: /* match_body: '{' match_stmts '}'  */
+#line 186 "parser.y"
+                                                        { (yyval.rule) = new_multi_rule((yyvsp[-1].list)); }
+#line 1633 "parser.c"
+    break;
+
+  case 30: /* match_stmts: match_stmts match_stmt  */
+#line 189 "parser.y"
+                                                { llist_add((yyvsp[-1].list), (yyvsp[0].rule)); (yyval.list) = (yyvsp[-1].list); }
+#line 1639 "parser.c"
+    break;
+
+  case 31: /* match_stmts: %empty  */
+#line 190 "parser.y"
+                                                                { (yyval.list) = llist_new(); }
+#line 1645 "parser.c"
+    break;
+
+  case 32: /* match_stmt: INCLUDE string  */
+#line 193 "parser.y"
+                                                        { (yyval.rule) = include_script(parser, (yyvsp[0].text));
+										  if ((yyval.rule) == NULL)
+											  YYABORT;
+										}
+#line 1654 "parser.c"
+    break;
+
+  case 33: /* match_stmt: STRING  */
+#line 197 "parser.y"
+                                                                        { if (hmap_contains_key(parser->script->macros, (yyvsp[0].text))) {
+											  (yyval.rule) = new_macro_rule(hmap_get(parser->script->macros, (yyvsp[0].text)));
+										  } else if (hmap_contains_key(parser->script->styles, (yyvsp[0].text))) {
+											  (yyval.rule) = new_style_rule(hmap_get(parser->script->styles, (yyvsp[0].text)));
 										  } else {
-											  script_die(_("no such macro or style `%s'"), yyvsp[0].text);
+											  PARSE_ERROR(_("no such macro or style `%s'"), (yyvsp[0].text));
 										  }
 										}
+#line 1667 "parser.c"
     break;
 
-  case 29:
-#line 147 "parser.y"
-    { yyval.rule = new_substitution_rule(yyvsp[-1].text, yyvsp[0].regex.text, yyvsp[0].regex.flags); }
+  case 34: /* match_stmt: STRING '{' match_stmts '}'  */
+#line 205 "parser.y"
+                                                                { uint64_t mask;
+										  if (!state_mask(parser, (yyvsp[-3].text), &mask)) {
+											  llist_iterate((yyvsp[-1].list), (IteratorFunc) free_rule);
+											  llist_free((yyvsp[-1].list));
+											  YYABORT;
+										  }
+										  parser->tested_states |= mask;
+										  (yyval.rule) = new_state_rule(mask, new_multi_rule((yyvsp[-1].list))); }
+#line 1680 "parser.c"
     break;
 
-  case 30:
-#line 148 "parser.y"
-    { yyval.rule = new_set_rule(yyvsp[0].text); }
+  case 35: /* match_stmt: ENTER string  */
+#line 213 "parser.y"
+                                                                { uint64_t mask;
+										  if (!state_mask(parser, (yyvsp[0].text), &mask))
+											  YYABORT;
+										  parser->entered_states |= mask;
+										  (yyval.rule) = new_state_change_rule(mask, true); }
+#line 1690 "parser.c"
     break;
 
-  case 31:
-#line 149 "parser.y"
-    { yyval.rule = new_action_rule(ACTION_SKIP); }
+  case 36: /* match_stmt: LEAVE string  */
+#line 218 "parser.y"
+                                                                { uint64_t mask;
+										  if (!state_mask(parser, (yyvsp[0].text), &mask))
+											  YYABORT;
+										  (yyval.rule) = new_state_change_rule(mask, false); }
+#line 1699 "parser.c"
     break;
 
-  case 32:
-#line 150 "parser.y"
-    { yyval.rule = new_action_rule(ACTION_BREAK); }
+  case 37: /* match_stmt: ADD string string  */
+#line 222 "parser.y"
+                                                                { (yyval.rule) = new_list_rule(LIST_ADD, get_list(parser->script, (yyvsp[-1].text)), (yyvsp[0].text), NULL); }
+#line 1705 "parser.c"
     break;
 
+  case 38: /* match_stmt: REMOVE string string  */
+#line 223 "parser.y"
+                                                        { (yyval.rule) = new_list_rule(LIST_REMOVE, get_list(parser->script, (yyvsp[-1].text)), (yyvsp[0].text), NULL); }
+#line 1711 "parser.c"
+    break;
 
-    }
+  case 39: /* match_stmt: IN string string match_body  */
+#line 224 "parser.y"
+                                                                { (yyval.rule) = new_list_rule(LIST_IN, get_list(parser->script, (yyvsp[-2].text)), (yyvsp[-1].text), (yyvsp[0].rule)); }
+#line 1717 "parser.c"
+    break;
 
-/* Line 1010 of yacc.c.  */
-#line 1245 "parser.c"
-
-  yyvsp -= yylen;
-  yyssp -= yylen;
+  case 40: /* match_stmt: SUBST MATCH  */
+#line 225 "parser.y"
+                                                                { char *msg;
+										  (yyval.rule) = new_substitution_rule(parser->script, (yyvsp[-1].text), (yyvsp[0].regex).text, (yyvsp[0].regex).flags, &msg);
+										  if ((yyval.rule) == NULL) {
+											  script_error(parser, "%s", msg);
+											  free(msg);
+											  YYABORT;
+										  }
+										}
+#line 1730 "parser.c"
+    break;
 
+  case 41: /* match_stmt: SET string  */
+#line 233 "parser.y"
+                                                                { (yyval.rule) = new_set_rule((yyvsp[0].text)); }
+#line 1736 "parser.c"
+    break;
 
-  YY_STACK_PRINT (yyss, yyssp);
+  case 42: /* match_stmt: SKIP  */
+#line 234 "parser.y"
+                                                                        { (yyval.rule) = new_action_rule(ACTION_SKIP); }
+#line 1742 "parser.c"
+    break;
 
-  *++yyvsp = yyval;
+  case 43: /* match_stmt: BREAK  */
+#line 235 "parser.y"
+                                                                        { (yyval.rule) = new_action_rule(ACTION_BREAK); }
+#line 1748 "parser.c"
+    break;
 
+  case 45: /* match_stmt: condition match_body  */
+#line 237 "parser.y"
+                                                        { (yyval.rule) = new_condition_rule((yyvsp[-1].condition), (yyvsp[0].rule)); }
+#line 1754 "parser.c"
+    break;
 
-  /* Now `shift' the result of the reduction.  Determine what state
-     that goes to, based on the state we popped back to and the rule
-     number reduced by.  */
+  case 46: /* condition: condition OR and_condition  */
+#line 240 "parser.y"
+                                                        { (yyval.condition) = new_logic_condition(CONDITION_OR, (yyvsp[-2].condition), (yyvsp[0].condition)); }
+#line 1760 "parser.c"
+    break;
 
-  yyn = yyr1[yyn];
+  case 48: /* and_condition: and_condition AND not_condition  */
+#line 243 "parser.y"
+                                                { (yyval.condition) = new_logic_condition(CONDITION_AND, (yyvsp[-2].condition), (yyvsp[0].condition)); }
+#line 1766 "parser.c"
+    break;
 
-  yystate = yypgoto[yyn - YYNTOKENS] + *yyssp;
-  if (0 <= yystate && yystate <= YYLAST && yycheck[yystate] == *yyssp)
-    yystate = yytable[yystate];
-  else
-    yystate = yydefgoto[yyn - YYNTOKENS];
+  case 50: /* not_condition: NOT not_condition  */
+#line 246 "parser.y"
+                                                { (yyval.condition) = new_logic_condition(CONDITION_NOT, (yyvsp[0].condition), NULL); }
+#line 1772 "parser.c"
+    break;
+
+  case 51: /* not_condition: '(' condition ')'  */
+#line 247 "parser.y"
+                                                                { (yyval.condition) = (yyvsp[-1].condition); }
+#line 1778 "parser.c"
+    break;
+
+  case 52: /* not_condition: NUMBER COMPARE decimal  */
+#line 248 "parser.y"
+                                                                { (yyval.condition) = new_compare_condition((yyvsp[-2].number), (yyvsp[-1].number), (yyvsp[0].decimal)); }
+#line 1784 "parser.c"
+    break;
+
+  case 53: /* decimal: NUMBER  */
+#line 250 "parser.y"
+                                                                { (yyval.decimal) = (yyvsp[0].number); }
+#line 1790 "parser.c"
+    break;
+
+  case 54: /* decimal: DECIMAL  */
+#line 251 "parser.y"
+                                                                        { if (!parse_decimal((yyvsp[0].text), strlen((yyvsp[0].text)), &(yyval.decimal)))
+											  PARSE_ERROR(_("invalid number `%s'"), (yyvsp[0].text)); }
+#line 1797 "parser.c"
+    break;
+
+  case 56: /* string: LITERAL  */
+#line 256 "parser.y"
+                                                                        { if ((yyvsp[0].regex).flags != 0)
+											  PARSE_ERROR(_("flags not allowed after string"));
+										  (yyval.text) = (yyvsp[0].regex).text; }
+#line 1805 "parser.c"
+    break;
+
+
+#line 1809 "parser.c"
+
+      default: break;
+    }
+  /* User semantic actions sometimes alter yychar, and that requires
+     that yytoken be updated with the new translation.  We take the
+     approach of translating immediately before every use of yytoken.
+     One alternative is translating here after every semantic action,
+     but that translation would be missed if the semantic action invokes
+     YYABORT, YYACCEPT, or YYERROR immediately after altering yychar or
+     if it invokes YYBACKUP.  In the case of YYABORT or YYACCEPT, an
+     incorrect destructor might then be invoked immediately.  In the
+     case of YYERROR or YYBACKUP, subsequent parser actions might lead
+     to an incorrect destructor call or verbose syntax error message
+     before the lookahead is translated.  */
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
+
+  YYPOPSTACK (yylen);
+  yylen = 0;
+
+  *++yyvsp = yyval;
+
+  /* Now 'shift' the result of the reduction.  Determine what state
+     that goes to, based on the state we popped back to and the rule
+     number reduced by.  */
+  {
+    const int yylhs = yyr1[yyn] - YYNTOKENS;
+    const int yyi = yypgoto[yylhs] + *yyssp;
+    yystate = (0 <= yyi && yyi <= YYLAST && yycheck[yyi] == *yyssp
+               ? yytable[yyi]
+               : yydefgoto[yylhs]);
+  }
 
   goto yynewstate;
 
 
-/*------------------------------------.
-| yyerrlab -- here on detecting error |
-`------------------------------------*/
+/*--------------------------------------.
+| yyerrlab -- here on detecting error.  |
+`--------------------------------------*/
 yyerrlab:
+  /* Make sure we have latest lookahead translation.  See comments at
+     user semantic actions for why this is necessary.  */
+  yytoken = yychar == YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
   /* If not already recovering from an error, report this error.  */
   if (!yyerrstatus)
     {
       ++yynerrs;
-#if YYERROR_VERBOSE
-      yyn = yypact[yystate];
-
-      if (YYPACT_NINF < yyn && yyn < YYLAST)
-	{
-	  YYSIZE_T yysize = 0;
-	  int yytype = YYTRANSLATE (yychar);
-	  const char* yyprefix;
-	  char *yymsg;
-	  int yyx;
-
-	  /* Start YYX at -YYN if negative to avoid negative indexes in
-	     YYCHECK.  */
-	  int yyxbegin = yyn < 0 ? -yyn : 0;
-
-	  /* Stay within bounds of both yycheck and yytname.  */
-	  int yychecklim = YYLAST - yyn;
-	  int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
-	  int yycount = 0;
-
-	  yyprefix = ", expecting ";
-	  for (yyx = yyxbegin; yyx < yyxend; ++yyx)
-	    if (yycheck[yyx + yyn] == yyx && yyx != YYTERROR)
-	      {
-		yysize += yystrlen (yyprefix) + yystrlen (yytname [yyx]);
-		yycount += 1;
-		if (yycount == 5)
-		  {
-		    yysize = 0;
-		    break;
-		  }
-	      }
-	  yysize += (sizeof ("syntax error, unexpected ")
-		     + yystrlen (yytname[yytype]));
-	  yymsg = (char *) YYSTACK_ALLOC (yysize);
-	  if (yymsg != 0)
-	    {
-	      char *yyp = yystpcpy (yymsg, "syntax error, unexpected ");
-	      yyp = yystpcpy (yyp, yytname[yytype]);
-
-	      if (yycount < 5)
-		{
-		  yyprefix = ", expecting ";
-		  for (yyx = yyxbegin; yyx < yyxend; ++yyx)
-		    if (yycheck[yyx + yyn] == yyx && yyx != YYTERROR)
-		      {
-			yyp = yystpcpy (yyp, yyprefix);
-			yyp = yystpcpy (yyp, yytname[yyx]);
-			yyprefix = " or ";
-		      }
-		}
-	      yyerror (yymsg);
-	      YYSTACK_FREE (yymsg);
-	    }
-	  else
-	    yyerror ("syntax error; also virtual memory exhausted");
-	}
-      else
-#endif /* YYERROR_VERBOSE */
-	yyerror ("syntax error");
+      yyerror (parser, YY_("syntax error"));
     }
 
-
-
   if (yyerrstatus == 3)
     {
       /* If just tried and failed to reuse lookahead token after an
-	 error, discard it.  */
+         error, discard it.  */
 
       if (yychar <= YYEOF)
         {
-          /* If at end of input, pop the error token,
-	     then the rest of the stack, then return failure.  */
-	  if (yychar == YYEOF)
-	     for (;;)
-	       {
-		 YYPOPSTACK;
-		 if (yyssp == yyss)
-		   YYABORT;
-		 YYDSYMPRINTF ("Error: popping", yystos[*yyssp], yyvsp, yylsp);
-		 yydestruct (yystos[*yyssp], yyvsp);
-	       }
+          /* Return failure if at end of input.  */
+          if (yychar == YYEOF)
+            YYABORT;
         }
       else
-	{
-	  YYDSYMPRINTF ("Error: discarding", yytoken, &yylval, &yylloc);
-	  yydestruct (yytoken, &yylval);
-	  yychar = YYEMPTY;
-
-	}
+        {
+          yydestruct ("Error: discarding",
+                      yytoken, &yylval, parser);
+          yychar = YYEMPTY;
+        }
     }
 
   /* Else will try to reuse lookahead token after shifting the error
@@ -1376,16 +1883,17 @@ yyerrlab:
 | yyerrorlab -- error raised explicitly by YYERROR.  |
 `---------------------------------------------------*/
 yyerrorlab:
-
-#ifdef __GNUC__
-  /* Pacify GCC when the user code never invokes YYERROR and the label
-     yyerrorlab therefore never appears in user code.  */
+  /* Pacify compilers when the user code never invokes YYERROR and the
+     label yyerrorlab therefore never appears in user code.  */
   if (0)
-     goto yyerrorlab;
-#endif
+    YYERROR;
+  ++yynerrs;
 
-  yyvsp -= yylen;
-  yyssp -= yylen;
+  /* Do not reclaim the symbols of the rule whose action triggered
+     this YYERROR.  */
+  YYPOPSTACK (yylen);
+  yylen = 0;
+  YY_STACK_PRINT (yyss, yyssp);
   yystate = *yyssp;
   goto yyerrlab1;
 
@@ -1394,40 +1902,42 @@ yyerrorlab:
 | yyerrlab1 -- common code for both syntax error and YYERROR.  |
 `-------------------------------------------------------------*/
 yyerrlab1:
-  yyerrstatus = 3;	/* Each real token shifted decrements this.  */
+  yyerrstatus = 3;      /* Each real token shifted decrements this.  */
 
+  /* Pop stack until we find a state that shifts the error token.  */
   for (;;)
     {
       yyn = yypact[yystate];
-      if (yyn != YYPACT_NINF)
-	{
-	  yyn += YYTERROR;
-	  if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYTERROR)
-	    {
-	      yyn = yytable[yyn];
-	      if (0 < yyn)
-		break;
-	    }
-	}
+      if (!yypact_value_is_default (yyn))
+        {
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
+            {
+              yyn = yytable[yyn];
+              if (0 < yyn)
+                break;
+            }
+        }
 
       /* Pop the current state because it cannot handle the error token.  */
       if (yyssp == yyss)
-	YYABORT;
+        YYABORT;
+
 
-      YYDSYMPRINTF ("Error: popping", yystos[*yyssp], yyvsp, yylsp);
-      yydestruct (yystos[yystate], yyvsp);
-      YYPOPSTACK;
+      yydestruct ("Error: popping",
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, parser);
+      YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
     }
 
-  if (yyn == YYFINAL)
-    YYACCEPT;
-
-  YYDPRINTF ((stderr, "Shifting error token, "));
-
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
   *++yyvsp = yylval;
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+
 
+  /* Shift the error token.  */
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
 
   yystate = yyn;
   goto yynewstate;
@@ -1438,46 +1948,139 @@ yyerrlab1:
 `-------------------------------------*/
 yyacceptlab:
   yyresult = 0;
-  goto yyreturn;
+  goto yyreturnlab;
+
 
 /*-----------------------------------.
 | yyabortlab -- YYABORT comes here.  |
 `-----------------------------------*/
 yyabortlab:
   yyresult = 1;
-  goto yyreturn;
+  goto yyreturnlab;
 
-#ifndef yyoverflow
-/*----------------------------------------------.
-| yyoverflowlab -- parser overflow comes here.  |
-`----------------------------------------------*/
-yyoverflowlab:
-  yyerror ("parser stack overflow");
+
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
+yyexhaustedlab:
+  yyerror (parser, YY_("memory exhausted"));
   yyresult = 2;
-  /* Fall through.  */
-#endif
+  goto yyreturnlab;
+
 
-yyreturn:
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
+  if (yychar != YYEMPTY)
+    {
+      /* Make sure we have latest lookahead translation.  See comments at
+         user semantic actions for why this is necessary.  */
+      yytoken = YYTRANSLATE (yychar);
+      yydestruct ("Cleanup: discarding lookahead",
+                  yytoken, &yylval, parser);
+    }
+  /* Do not reclaim the symbols of the rule whose action triggered
+     this YYABORT or YYACCEPT.  */
+  YYPOPSTACK (yylen);
+  YY_STACK_PRINT (yyss, yyssp);
+  while (yyssp != yyss)
+    {
+      yydestruct ("Cleanup: popping",
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, parser);
+      YYPOPSTACK (1);
+    }
 #ifndef yyoverflow
   if (yyss != yyssa)
     YYSTACK_FREE (yyss);
 #endif
+
   return yyresult;
 }
 
-
-#line 154 "parser.y"
-
-
+#line 261 "parser.y"
+
+
+/**
+ * Read a rule file and the files it includes into a script.
+ *
+ * @param filename
+ *   Rule file, or NULL for a script without rules.
+ * @param lazy
+ *   Whether regexes may be compiled when first used rather than now.
+ *   Subexpression indexes under such regexes are then only checked
+ *   when matching.
+ * @param error
+ *   Set to a message, to be freed by the caller, if the file cannot be
+ *   read or has errors.
+ * @return
+ *   The script, or NULL on errors.
+ */
 RemarkScript *
-parse_script(const char *filename)
+read_script(const char *filename, bool lazy, char **error)
 {
-	script = xmalloc(sizeof(RemarkScript));
+	RemarkScript *script = xmalloc(sizeof(RemarkScript));
+	Parser parser;
+	uint64_t unentered;
+	uint32_t index;
+
 	script->styles = hmap_new();
 	script->macros = hmap_new();
+	script->states = hmap_new();
+	script->lists = hmap_new();
+	script->includes = hmap_new();
+	script->regexes = hmap_new();
+	script->lazy = lazy;
 	script->prepend_rule = NULL;
 	script->append_rule = NULL;
-	script->rule = (filename == NULL ? NULL : include_script(filename));
+	script->rule = NULL;
+
+	if (filename != NULL) {
+		parser.script = script;
+		parser.file = NULL;
+		parser.error = NULL;
+		parser.tested_states = 0;
+		parser.entered_states = 0;
+		script->rule = include_script(&parser, filename);
+		if (script->rule == NULL) {
+			free_script(script);
+			*error = parser.error;
+			return NULL;
+		}
+		if (!check_subexpressions(script->rule, 1, &index)
+				|| !check_subexpressions(script->prepend_rule, 1, &index)
+				|| !check_subexpressions(script->append_rule, 1, &index)) {
+			free_script(script);
+			*error = xasprintf(_("%s: subexpression index %u is out of range"), filename, index);
+			return NULL;
+		}
+		/* A block for a state that is never entered is never run,
+		 * which is most likely a misspelled name.
+		 */
+		unentered = parser.tested_states & ~parser.entered_states;
+		if (unentered != 0) {
+			for (index = 0; (unentered & ((uint64_t) 1 << index)) == 0; index++);
+			*error = xasprintf(_("%s: state `%s' is never entered"), filename, parser.state_names[index]);
+			free_script(script);
+			return NULL;
+		}
+	}
+	return script;
+}
+
+/**
+ * Read a rule file like read_script, with regexes compiled when first
+ * used. Errors in the file are fatal.
+ */
+RemarkScript *
+parse_script(const char *filename)
+{
+	RemarkScript *script;
+	char *error;
+
+	script = read_script(filename, true, &error);
+	if (script == NULL)
+		die("%s", error);
 	return script;
 }
 
@@ -1486,59 +2089,131 @@ free_script(RemarkScript *script)
 {
 	hmap_foreach_value(script->styles, (IteratorFunc) free_style);
 	hmap_free(script->styles);
-	hmap_foreach_value(script->macros, (IteratorFunc) free_rule);
+	hmap_foreach_value(script->macros, (IteratorFunc) free_macro);
 	hmap_free(script->macros);
+	hmap_foreach_key(script->states, free);
+	hmap_free(script->states);
+	hmap_foreach_key(script->lists, free);
+	hmap_free(script->lists);
+	hmap_foreach_key(script->includes, free);
+	hmap_foreach_value(script->includes, (IteratorFunc) free_macro);
+	hmap_free(script->includes);
 	free_rule(script->prepend_rule);
 	free_rule(script->append_rule);
 	free_rule(script->rule);
+	hmap_free(script->regexes);
 	free(script);
 }
 
-static Rule *
-include_script(const char *filename)
+/* States are numbered in order of first use. The map holds the
+ * number plus one, so that no state is stored as NULL.
+ */
+static bool
+state_mask(Parser *parser, const char *name, uint64_t *mask)
 {
-	RemarkFile rf;
-	int old_yychar = yychar;
-	int old_yylineno = yylineno;
-
-	if (filename[0] == '/') {
-		rf.file = fopen(filename, "r");
-		if (rf.file == NULL)
-			script_die(_("cannot open `%s': %s"), filename, strerror(errno));
-	} else {
-		rf.file = NULL;
-		if (file != NULL) {
-			char *name = cat_files(file->directory, filename);
-			rf.file = fopen(name, "r");
-			if (rf.file == NULL && errno != ENOENT)
-				script_die(_("cannot open `%s': %s"), name, strerror(errno));
-			free(name);
-		} else {
-			rf.file = fopen(filename, "r");
-			if (rf.file == NULL && errno != ENOENT)
-				script_die(_("cannot open `%s': %s"), filename, strerror(errno));
+	RemarkScript *script = parser->script;
+	uintptr_t index = (uintptr_t) hmap_get(script->states, name);
+	char *key;
+
+	if (index == 0) {
+		if (hmap_contains_key(script->macros, name) || hmap_contains_key(script->styles, name)) {
+			script_error(parser, _("`%s' is a macro or style, not a state"), name);
+			return false;
 		}
-		if (rf.file == NULL) {
-			char *dir = cat_files(getenv("HOME"), PKGUSERDIR);
-			char *name = cat_files(dir, filename);
-			rf.file = fopen(name, "r");
-			if (rf.file == NULL && errno != ENOENT)
-				script_die(_("cannot open `%s': %s"), name, strerror(errno));
-			free(name);
-			free(dir);
+		index = hmap_size(script->states) + 1;
+		if (index > MAX_STATES) {
+			script_error(parser, _("too many states (at most %d allowed)"), MAX_STATES);
+			return false;
 		}
-		if (rf.file == NULL) {
-			char *name = cat_files(PKGDATADIR, filename);
-			rf.file = fopen(name, "r");
-			if (rf.file == NULL && errno != ENOENT)
-				script_die(_("cannot open `%s': %s"), name, strerror(errno));
+		key = xstrdup(name);
+		hmap_put(script->states, key, (void *) index);
+		parser->state_names[index - 1] = key;
+	}
+
+	*mask = (uint64_t) 1 << (index - 1);
+	return true;
+}
+
+/* Lists are numbered in order of first use, like states. The values
+ * of a list are kept by each input, in ListSets.
+ */
+static uint32_t
+get_list(RemarkScript *script, const char *name)
+{
+	uintptr_t index = (uintptr_t) hmap_get(script->lists, name);
+
+	if (index == 0) {
+		index = hmap_size(script->lists) + 1;
+		hmap_put(script->lists, xstrdup(name), (void *) index);
+	}
+
+	return index - 1;
+}
+
+/* Relative names are looked up next to the including file (or in the
+ * current directory), then in the user's and the shared rule directory.
+ */
+static FILE *
+open_script(Parser *parser, const char *filename)
+{
+	char *name;
+	char *dir;
+	FILE *fh;
+
+	if (filename[0] != '/' && parser->file != NULL)
+		name = cat_files(parser->file->directory, filename);
+	else
+		name = xstrdup(filename);
+	fh = fopen(name, "r");
+	if (fh == NULL && errno == ENOENT && filename[0] != '/') {
+		free(name);
+		dir = cat_files(getenv("HOME"), PKGUSERDIR);
+		name = cat_files(dir, filename);
+		free(dir);
+		fh = fopen(name, "r");
+		if (fh == NULL && errno == ENOENT) {
 			free(name);
+			name = cat_files(PKGDATADIR, filename);
+			fh = fopen(name, "r");
 		}
-		if (rf.file == NULL)
-			script_die(_("cannot open `%s': %s"), filename, strerror(errno));
+	}
+	if (fh == NULL)
+		script_error(parser, _("cannot open `%s': %s"), errno == ENOENT ? filename : name, strerror(errno));
+	free(name);
+	return fh;
+}
 
+/* A file is only parsed the first time it is included. Its rules
+ * are kept like a macro, so later includes of the same file share
+ * them. Files are identified by device and inode, since the same file
+ * can be reached through different names.
+ */
+static Rule *
+include_script(Parser *parser, const char *filename)
+{
+	RemarkFile rf;
+	int old_yychar = yychar;
+	int old_yylineno = yylineno;
+	struct stat statbuf;
+	Macro *included;
+	char *key;
+	int rc;
+
+	rf.file = open_script(parser, filename);
+	if (rf.file == NULL)
+		return NULL;
+	if (fstat(fileno(rf.file), &statbuf) < 0) {
+		script_error(parser, _("cannot stat `%s': %s"), filename, strerror(errno));
+		fclose(rf.file);
+		return NULL;
+	}
+	key = xasprintf("%lu:%lu", (unsigned long) statbuf.st_dev, (unsigned long) statbuf.st_ino);
+	included = hmap_get(parser->script->includes, key);
+	if (included != NULL) {
+		fclose(rf.file);
+		free(key);
+		return new_macro_rule(included);
 	}
-	assert(rf.file != NULL);
 
 	yychar = '\0';
 	yylineno = 1;
@@ -1546,14 +2221,14 @@ include_script(const char *filename)
 	rf.directory = dir_name(filename);
 	rf.rules = llist_new();
 	rf.tokens = llist_new();
-	rf.previous = file;
-	file = &rf;
+	rf.previous = parser->file;
+	parser->file = &rf;
 
 	lexer_set_buffer(&rf);
-	yyparse();
+	rc = yyparse(parser);
 	lexer_restore_buffer(rf.previous);
 
-	file = rf.previous;
+	parser->file = rf.previous;
 	llist_iterate(rf.tokens, (IteratorFunc) free);
 	llist_free(rf.tokens);
 	fclose(rf.file);
@@ -1561,28 +2236,42 @@ include_script(const char *filename)
 	yylineno = old_yylineno;
 	yychar = old_yychar;
 
-	return new_multi_rule(rf.rules);
+	if (rc != 0) {
+		llist_iterate(rf.rules, (IteratorFunc) free_rule);
+		llist_free(rf.rules);
+		free(key);
+		return NULL;
+	}
+	included = new_macro(filename, new_multi_rule(rf.rules));
+	hmap_put(parser->script->includes, key, included);
+	return new_macro_rule(included);
 }
 
+/* Errors are reported with the file and line being read, and the
+ * first one stops the parser.
+ */
 static void
-script_die(const char *msg, ...)
+script_error(Parser *parser, const char *msg, ...)
 {
 	va_list ap;
-	
+	char *text;
+
+	if (parser->error != NULL)
+		return;
+
 	va_start(ap, msg);
-	if (file != NULL)
-		fprintf(stderr, "%s:%d: ", file->filename, yylineno);
-	else
-		fprintf(stderr, "%s: ", program_name);
-	vfprintf(stderr, msg, ap);
-	fprintf(stderr, "\n");
+	text = xvasprintf(msg, ap);
 	va_end(ap);
-	exit(1);
+	if (parser->file != NULL) {
+		parser->error = xasprintf("%s:%d: %s", parser->file->filename, yylineno, text);
+		free(text);
+	} else {
+		parser->error = text;
+	}
 }
 
 static void
-yyerror(char *msg)
+yyerror(Parser *parser, const char *msg)
 {
-	script_die("%s", msg);
+	script_error(parser, "%s", msg);
 }
-
@@ -1,12 +1,14 @@
-/* A Bison parser, made by GNU Bison 1.875d.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
-/* Skeleton parser for Yacc-like parsing with Bison,
-   Copyright (C) 1984, 1989, 1990, 2000, 2001, 2002, 2003, 2004 Free Software Foundation, Inc.
+/* Bison interface for Yacc-like parsers in C
 
-   This program is free software; you can redistribute it and/or modify
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
+   This program is free software: you can redistribute it and/or modify
    it under the terms of the GNU General Public License as published by
-   the Free Software Foundation; either version 2, or (at your option)
-   any later version.
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
 
    This program is distributed in the hope that it will be useful,
    but WITHOUT ANY WARRANTY; without even the implied warranty of
@@ -14,35 +16,79 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program; if not, write to the Free Software
-   Foundation, Inc., 59 Temple Place - Suite 330,
-   Boston, MA 02111-1307, USA.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* As a special exception, you may create a larger work that contains
+   part or all of the Bison parser skeleton and distribute that work
+   under terms of your choice, so long as that work isn't itself a
+   parser generator using the skeleton or a modified version thereof
+   as a parser skeleton.  Alternatively, if you modify or redistribute
+   the parser skeleton itself, you may (at your option) remove this
+   special exception, which will cause the skeleton and the resulting
+   Bison output files to be licensed under the GNU General Public
+   License without this special exception.
 
-/* As a special exception, when this file is copied by Bison into a
-   Bison output file, you may use that output file without restriction.
-   This special exception was added by the Free Software Foundation
-   in version 1.24 of Bison.  */
+   This special exception was added by the Free Software Foundation in
+   version 2.2 of Bison.  */
 
-/* Tokens.  */
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
+#ifndef YY_YY_PARSER_H_INCLUDED
+# define YY_YY_PARSER_H_INCLUDED
+/* Debug traces.  */
+#ifndef YYDEBUG
+# define YYDEBUG 0
+#endif
+#if YYDEBUG
+extern int yydebug;
+#endif
+
+/* Token kinds.  */
 #ifndef YYTOKENTYPE
 # define YYTOKENTYPE
-   /* Put the tokens into the symbol table, so that GDB and other debuggers
-      know about them.  */
-   enum yytokentype {
-     STYLE = 258,
-     PREPEND = 259,
-     APPEND = 260,
-     SKIP = 261,
-     BREAK = 262,
-     MACRO = 263,
-     INCLUDE = 264,
-     SET = 265,
-     NUMBER = 266,
-     STRING = 267,
-     MATCH = 268,
-     SUBST = 269
-   };
+  enum yytokentype
+  {
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    STYLE = 258,                   /* STYLE  */
+    PREPEND = 259,                 /* PREPEND  */
+    APPEND = 260,                  /* APPEND  */
+    SKIP = 261,                    /* SKIP  */
+    BREAK = 262,                   /* BREAK  */
+    MACRO = 263,                   /* MACRO  */
+    INCLUDE = 264,                 /* INCLUDE  */
+    SET = 265,                     /* SET  */
+    FIELDS = 266,                  /* FIELDS  */
+    FIELD = 267,                   /* FIELD  */
+    JSON = 268,                    /* JSON  */
+    AND = 269,                     /* AND  */
+    OR = 270,                      /* OR  */
+    NOT = 271,                     /* NOT  */
+    COMPARE = 272,                 /* COMPARE  */
+    DECIMAL = 273,                 /* DECIMAL  */
+    ENTER = 274,                   /* ENTER  */
+    LEAVE = 275,                   /* LEAVE  */
+    ADD = 276,                     /* ADD  */
+    REMOVE = 277,                  /* REMOVE  */
+    IN = 278,                      /* IN  */
+    NUMBER = 279,                  /* NUMBER  */
+    STRING = 280,                  /* STRING  */
+    MATCH = 281,                   /* MATCH  */
+    SUBST = 282,                   /* SUBST  */
+    LITERAL = 283,                 /* LITERAL  */
+    TOKEN = 284                    /* TOKEN  */
+  };
+  typedef enum yytokentype yytoken_kind_t;
 #endif
+/* Token kinds.  */
+#define YYEMPTY -2
+#define YYEOF 0
+#define YYerror 256
+#define YYUNDEF 257
 #define STYLE 258
 #define PREPEND 259
 #define APPEND 260
@@ -51,17 +97,32 @@
 #define MACRO 263
 #define INCLUDE 264
 #define SET 265
-#define NUMBER 266
-#define STRING 267
-#define MATCH 268
-#define SUBST 269
-
+#define FIELDS 266
+#define FIELD 267
+#define JSON 268
+#define AND 269
+#define OR 270
+#define NOT 271
+#define COMPARE 272
+#define DECIMAL 273
+#define ENTER 274
+#define LEAVE 275
+#define ADD 276
+#define REMOVE 277
+#define IN 278
+#define NUMBER 279
+#define STRING 280
+#define MATCH 281
+#define SUBST 282
+#define LITERAL 283
+#define TOKEN 284
 
+/* Value type.  */
+#if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
+union YYSTYPE
+{
+#line 59 "parser.y"
 
-
-#if ! defined (YYSTYPE) && ! defined (YYSTYPE_IS_DECLARED)
-#line 54 "parser.y"
-typedef union YYSTYPE {
 	const char *text;
 	int32_t number;
 	Rule *rule;
@@ -70,19 +131,26 @@ typedef union YYSTYPE {
 	LList *list;
 	Style *style;
 	StyleInfo *styleinfo;
+	Condition *condition;
+	double decimal;
 	struct {
 		const char *text;
 		RegexFlags flags;
 	} regex;
-} YYSTYPE;
-/* Line 1285 of yacc.c.  */
-#line 80 "parser.h"
-# define yystype YYSTYPE /* obsolescent; will be withdrawn */
-# define YYSTYPE_IS_DECLARED 1
+
+#line 142 "parser.h"
+
+};
+typedef union YYSTYPE YYSTYPE;
 # define YYSTYPE_IS_TRIVIAL 1
+# define YYSTYPE_IS_DECLARED 1
 #endif
 
+
 extern YYSTYPE yylval;
 
 
+int yyparse (Parser *parser);
+
 
+#endif /* !YY_YY_PARSER_H_INCLUDED  */
@@ -22,16 +22,18 @@
 /* C89 */
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <errno.h>
-#include <assert.h>
 #include <string.h>
+/* POSIX */
+#include <sys/stat.h>
 /* Gettext */
 #include <gettext.h>
 #define _(String) gettext(String)
 /* gnulib */
 #include <dirname.h>
 #include <xalloc.h>
-#include <progname.h>
+#include <xvasprintf.h>
 /* common */
 #include "common/string-utils.h"
 #include "common/intutil.h"
@@ -42,15 +44,18 @@
 /* regex-markup */
 #include "remark.h"
 
-static RemarkFile *file = NULL;
-static RemarkScript *script;
+static Rule *include_script(Parser *parser, const char *filename);
+static bool state_mask(Parser *parser, const char *name, uint64_t *mask);
+static uint32_t get_list(RemarkScript *script, const char *name);
+static void script_error(Parser *parser, const char *msg, ...);
+static void yyerror(Parser *parser, const char *msg);
 
-static Rule *include_script(const char *filename);
-static void script_die(const char *msg, ...);
-static void yyerror(char *msg);
+#define PARSE_ERROR(...) do { script_error(parser, __VA_ARGS__); YYABORT; } while (0)
 
 %}
 
+%parse-param { Parser *parser }
+
 %union {
 	const char *text;
 	int32_t number;
@@ -60,45 +65,70 @@ static void yyerror(char *msg);
 	LList *list;
 	Style *style;
 	StyleInfo *styleinfo;
+	Condition *condition;
+	double decimal;
 	struct {
 		const char *text;
 		RegexFlags flags;
 	} regex;
 }
 
-%token STYLE PREPEND APPEND SKIP BREAK MACRO INCLUDE SET
-%token NUMBER STRING MATCH SUBST
+%token STYLE PREPEND APPEND SKIP BREAK MACRO INCLUDE SET FIELDS FIELD JSON
+%token AND OR NOT COMPARE DECIMAL ENTER LEAVE ADD REMOVE IN
+%token NUMBER STRING MATCH SUBST LITERAL TOKEN
 %type <rule> match_body match_stmt match_decl
 %type <list> match_items match_stmts style_body style_stmts
 %type <styleinfo> style_stmt
 %type <match> match_item
 %type <macro> macro_decl
 %type <style> style_decl
-%type <regex> MATCH
-%type <text> STRING SUBST
-%type <number> NUMBER
+%type <regex> MATCH LITERAL TOKEN
+%type <text> STRING SUBST DECIMAL string
+%type <condition> condition and_condition not_condition
+%type <decimal> decimal
+%type <number> NUMBER COMPARE
+
+%destructor { free_rule($$); } <rule>
+%destructor { free_match($$); } <match>
+%destructor { free_macro($$); } <macro>
+%destructor { free_style($$); } <style>
+%destructor { free($$); } <styleinfo>
+%destructor { free_condition($$); } <condition>
+%destructor { llist_iterate($$, (IteratorFunc) free_match); llist_free($$); } match_items
+%destructor { llist_iterate($$, (IteratorFunc) free_rule); llist_free($$); } match_stmts
+%destructor { llist_iterate($$, (IteratorFunc) free); llist_free($$); } style_body style_stmts
 
 %%
 input:			input input_item
 				| /* empty */
 				;
 
-input_item:		style_decl 				{ if (hmap_contains_key(script->styles, $1->name))
-										      script_die(_("style `%s' already defined"), $1->name);
-										  hmap_put(script->styles, $1->name, $1); }
-				| macro_decl 			{ if (hmap_contains_key(script->macros, $1->name))
-										      script_die(_("macro `%s' already defined"), $1->name);
-										  hmap_put(script->macros, $1->name, $1); }
-				| match_stmt 			{ llist_add(file->rules, $1); }
-				| PREPEND match_body	{ if (script->prepend_rule != NULL)
-											  script_die(_("prepend rule already specifed"));
-										  script->prepend_rule = $2; }
-				| APPEND match_body		{ if (script->append_rule != NULL)
-											  script_die(_("append rule already specifed"));
-										  script->append_rule = $2; }
+input_item:		style_decl 				{ if (hmap_contains_key(parser->script->styles, $1->name)) {
+											  script_error(parser, _("style `%s' already defined"), $1->name);
+											  free_style($1);
+											  YYABORT;
+										  }
+										  hmap_put(parser->script->styles, $1->name, $1); }
+				| macro_decl 			{ if (hmap_contains_key(parser->script->macros, $1->name)) {
+											  script_error(parser, _("macro `%s' already defined"), $1->name);
+											  free_macro($1);
+											  YYABORT;
+										  }
+										  hmap_put(parser->script->macros, $1->name, $1); }
+				| match_stmt 			{ llist_add(parser->file->rules, $1); }
+				| PREPEND match_body	{ if (parser->script->prepend_rule != NULL) {
+											  free_rule($2);
+											  PARSE_ERROR(_("prepend rule already specifed"));
+										  }
+										  parser->script->prepend_rule = $2; }
+				| APPEND match_body		{ if (parser->script->append_rule != NULL) {
+											  free_rule($2);
+											  PARSE_ERROR(_("append rule already specifed"));
+										  }
+										  parser->script->append_rule = $2; }
 				;
 
-style_decl:	  	STYLE STRING style_body	{ $$ = new_style($2, $3); }
+style_decl:	  	STYLE string style_body	{ $$ = new_style($2, $3); }
 				;
 style_body:		'{' style_stmts '}'		{ $$ = $2; }
 				| style_stmt			{ $$ = llist_new(); llist_add($$, $1); }
@@ -106,16 +136,16 @@ style_body:		'{' style_stmts '}'		{ $$ = $2; }
 style_stmts:	style_stmts style_stmt	{ llist_add($1, $2); $$ = $1; }
 				| /* empty */			{ $$ = llist_new(); }
 				;
-style_stmt:		STRING					{ Style *style = hmap_get(script->styles, $1);
+style_stmt:		string					{ Style *style = hmap_get(parser->script->styles, $1);
 						  				  if (style == NULL)
-						      				  script_die(_("no such style `%s'"), $1);
+						      				  PARSE_ERROR(_("no such style `%s'"), $1);
 										  $$ = new_styleinfo_style(style);
 										}
-				| PREPEND STRING		{ $$ = new_styleinfo_pre($2); }
-				| APPEND STRING			{ $$ = new_styleinfo_post($2); }
+				| PREPEND string		{ $$ = new_styleinfo_pre($2); }
+				| APPEND string			{ $$ = new_styleinfo_post($2); }
 				;
 
-macro_decl:		MACRO STRING match_body	{ $$ = new_macro($2, $3); }
+macro_decl:		MACRO string match_body	{ $$ = new_macro($2, $3); }
 				;
 
 match_decl:		match_items match_body	{ $$ = new_match_rule($1, $2); }
@@ -124,8 +154,33 @@ match_decl:		match_items match_body	{ $$ = new_match_rule($1, $2); }
 match_items:	match_items ','	match_item	{ llist_add($1, $3); $$ = $1; }
 				| match_item				{ $$ = llist_new(); llist_add($$, $1); }
 				;
-match_item:		MATCH					{ $$ = new_regex_match($1.text, $1.flags); }
+match_item:		MATCH					{ char *msg;
+										  $$ = new_regex_match(parser->script, $1.text, $1.flags, &msg);
+										  if ($$ == NULL) {
+											  script_error(parser, "%s", msg);
+											  free(msg);
+											  YYABORT;
+										  }
+										}
 				| NUMBER				{ $$ = new_subex_match($1); }
+				| LITERAL				{ if ($1.text[0] == '\0')
+											  PARSE_ERROR(_("empty literal match"));
+										  $$ = new_literal_match($1.text, $1.flags); }
+				| TOKEN					{ const Token *token = identify_token($1.text);
+										  if (token == NULL)
+											  PARSE_ERROR(_("no such built-in token `@%s'"), $1.text);
+										  $$ = new_token_match(token, $1.flags); }
+				| FIELDS LITERAL		{ if ($2.flags != 0)
+											  PARSE_ERROR(_("flags not allowed after string"));
+										  if ($2.text[0] == '\0')
+											  PARSE_ERROR(_("empty field delimiter"));
+										  $$ = new_field_match($2.text, 0); }
+				| FIELD NUMBER			{ if ($2 == 0)
+											  PARSE_ERROR(_("field numbers start at 1"));
+										  $$ = new_field_match(" ", $2); }
+				| JSON LITERAL			{ if ($2.flags != 0)
+											  PARSE_ERROR(_("flags not allowed after string"));
+										  $$ = new_json_match($2.text); }
 				;
 
 match_body:		'{' match_stmts	'}'		{ $$ = new_multi_rule($2); }
@@ -135,33 +190,156 @@ match_stmts:	match_stmts	match_stmt	{ llist_add($1, $2); $$ = $1; }
 				| /* empty */			{ $$ = llist_new(); }
 				;
 
-match_stmt:		INCLUDE	STRING			{ $$ = include_script($2); }
-				| STRING				{ if (hmap_contains_key(script->macros, $1)) {
-											  $$ = new_macro_rule(hmap_get(script->macros, $1));
-										  } else if (hmap_contains_key(script->styles, $1)) {
-											  $$ = new_style_rule(hmap_get(script->styles, $1));
+match_stmt:		INCLUDE	string			{ $$ = include_script(parser, $2);
+										  if ($$ == NULL)
+											  YYABORT;
+										}
+				| STRING				{ if (hmap_contains_key(parser->script->macros, $1)) {
+											  $$ = new_macro_rule(hmap_get(parser->script->macros, $1));
+										  } else if (hmap_contains_key(parser->script->styles, $1)) {
+											  $$ = new_style_rule(hmap_get(parser->script->styles, $1));
 										  } else {
-											  script_die(_("no such macro or style `%s'"), $1);
+											  PARSE_ERROR(_("no such macro or style `%s'"), $1);
 										  }
 										}
-				| SUBST	MATCH			{ $$ = new_substitution_rule($1, $2.text, $2.flags); }
-				| SET STRING			{ $$ = new_set_rule($2); }
+				| STRING '{' match_stmts '}'	{ uint64_t mask;
+										  if (!state_mask(parser, $1, &mask)) {
+											  llist_iterate($3, (IteratorFunc) free_rule);
+											  llist_free($3);
+											  YYABORT;
+										  }
+										  parser->tested_states |= mask;
+										  $$ = new_state_rule(mask, new_multi_rule($3)); }
+				| ENTER string			{ uint64_t mask;
+										  if (!state_mask(parser, $2, &mask))
+											  YYABORT;
+										  parser->entered_states |= mask;
+										  $$ = new_state_change_rule(mask, true); }
+				| LEAVE string			{ uint64_t mask;
+										  if (!state_mask(parser, $2, &mask))
+											  YYABORT;
+										  $$ = new_state_change_rule(mask, false); }
+				| ADD string string		{ $$ = new_list_rule(LIST_ADD, get_list(parser->script, $2), $3, NULL); }
+				| REMOVE string string	{ $$ = new_list_rule(LIST_REMOVE, get_list(parser->script, $2), $3, NULL); }
+				| IN string string match_body	{ $$ = new_list_rule(LIST_IN, get_list(parser->script, $2), $3, $4); }
+				| SUBST	MATCH			{ char *msg;
+										  $$ = new_substitution_rule(parser->script, $1, $2.text, $2.flags, &msg);
+										  if ($$ == NULL) {
+											  script_error(parser, "%s", msg);
+											  free(msg);
+											  YYABORT;
+										  }
+										}
+				| SET string			{ $$ = new_set_rule($2); }
 				| SKIP					{ $$ = new_action_rule(ACTION_SKIP); }
 				| BREAK					{ $$ = new_action_rule(ACTION_BREAK); }
 				| match_decl
+				| condition match_body	{ $$ = new_condition_rule($1, $2); }
+				;
+
+condition:		condition OR and_condition	{ $$ = new_logic_condition(CONDITION_OR, $1, $3); }
+				| and_condition
+				;
+and_condition:	and_condition AND not_condition	{ $$ = new_logic_condition(CONDITION_AND, $1, $3); }
+				| not_condition
+				;
+not_condition:	NOT not_condition		{ $$ = new_logic_condition(CONDITION_NOT, $2, NULL); }
+				| '(' condition ')'		{ $$ = $2; }
+				| NUMBER COMPARE decimal	{ $$ = new_compare_condition($1, $2, $3); }
+				;
+decimal:		NUMBER					{ $$ = $1; }
+				| DECIMAL				{ if (!parse_decimal($1, strlen($1), &$$))
+											  PARSE_ERROR(_("invalid number `%s'"), $1); }
+				;
+
+string:			STRING
+				| LITERAL				{ if ($1.flags != 0)
+											  PARSE_ERROR(_("flags not allowed after string"));
+										  $$ = $1.text; }
 				;
 
 %%
 
+/**
+ * Read a rule file and the files it includes into a script.
+ *
+ * @param filename
+ *   Rule file, or NULL for a script without rules.
+ * @param lazy
+ *   Whether regexes may be compiled when first used rather than now.
+ *   Subexpression indexes under such regexes are then only checked
+ *   when matching.
+ * @param error
+ *   Set to a message, to be freed by the caller, if the file cannot be
+ *   read or has errors.
+ * @return
+ *   The script, or NULL on errors.
+ */
 RemarkScript *
-parse_script(const char *filename)
+read_script(const char *filename, bool lazy, char **error)
 {
-	script = xmalloc(sizeof(RemarkScript));
+	RemarkScript *script = xmalloc(sizeof(RemarkScript));
+	Parser parser;
+	uint64_t unentered;
+	uint32_t index;
+
 	script->styles = hmap_new();
 	script->macros = hmap_new();
+	script->states = hmap_new();
+	script->lists = hmap_new();
+	script->includes = hmap_new();
+	script->regexes = hmap_new();
+	script->lazy = lazy;
 	script->prepend_rule = NULL;
 	script->append_rule = NULL;
-	script->rule = (filename == NULL ? NULL : include_script(filename));
+	script->rule = NULL;
+
+	if (filename != NULL) {
+		parser.script = script;
+		parser.file = NULL;
+		parser.error = NULL;
+		parser.tested_states = 0;
+		parser.entered_states = 0;
+		script->rule = include_script(&parser, filename);
+		if (script->rule == NULL) {
+			free_script(script);
+			*error = parser.error;
+			return NULL;
+		}
+		if (!check_subexpressions(script->rule, 1, &index)
+				|| !check_subexpressions(script->prepend_rule, 1, &index)
+				|| !check_subexpressions(script->append_rule, 1, &index)) {
+			free_script(script);
+			*error = xasprintf(_("%s: subexpression index %u is out of range"), filename, index);
+			return NULL;
+		}
+		/* A block for a state that is never entered is never run,
+		 * which is most likely a misspelled name.
+		 */
+		unentered = parser.tested_states & ~parser.entered_states;
+		if (unentered != 0) {
+			for (index = 0; (unentered & ((uint64_t) 1 << index)) == 0; index++);
+			*error = xasprintf(_("%s: state `%s' is never entered"), filename, parser.state_names[index]);
+			free_script(script);
+			return NULL;
+		}
+	}
+	return script;
+}
+
+/**
+ * Read a rule file like read_script, with regexes compiled when first
+ * used. Errors in the file are fatal.
+ */
+RemarkScript *
+parse_script(const char *filename)
+{
+	RemarkScript *script;
+	char *error;
+
+	script = read_script(filename, true, &error);
+	if (script == NULL)
+		die("%s", error);
 	return script;
 }
 
@@ -170,59 +348,131 @@ free_script(RemarkScript *script)
 {
 	hmap_foreach_value(script->styles, (IteratorFunc) free_style);
 	hmap_free(script->styles);
-	hmap_foreach_value(script->macros, (IteratorFunc) free_rule);
+	hmap_foreach_value(script->macros, (IteratorFunc) free_macro);
 	hmap_free(script->macros);
+	hmap_foreach_key(script->states, free);
+	hmap_free(script->states);
+	hmap_foreach_key(script->lists, free);
+	hmap_free(script->lists);
+	hmap_foreach_key(script->includes, free);
+	hmap_foreach_value(script->includes, (IteratorFunc) free_macro);
+	hmap_free(script->includes);
 	free_rule(script->prepend_rule);
 	free_rule(script->append_rule);
 	free_rule(script->rule);
+	hmap_free(script->regexes);
 	free(script);
 }
 
-static Rule *
-include_script(const char *filename)
+/* States are numbered in order of first use. The map holds the
+ * number plus one, so that no state is stored as NULL.
+ */
+static bool
+state_mask(Parser *parser, const char *name, uint64_t *mask)
 {
-	RemarkFile rf;
-	int old_yychar = yychar;
-	int old_yylineno = yylineno;
+	RemarkScript *script = parser->script;
+	uintptr_t index = (uintptr_t) hmap_get(script->states, name);
+	char *key;
 
-	if (filename[0] == '/') {
-		rf.file = fopen(filename, "r");
-		if (rf.file == NULL)
-			script_die(_("cannot open `%s': %s"), filename, strerror(errno));
-	} else {
-		rf.file = NULL;
-		if (file != NULL) {
-			char *name = cat_files(file->directory, filename);
-			rf.file = fopen(name, "r");
-			if (rf.file == NULL && errno != ENOENT)
-				script_die(_("cannot open `%s': %s"), name, strerror(errno));
-			free(name);
-		} else {
-			rf.file = fopen(filename, "r");
-			if (rf.file == NULL && errno != ENOENT)
-				script_die(_("cannot open `%s': %s"), filename, strerror(errno));
+	if (index == 0) {
+		if (hmap_contains_key(script->macros, name) || hmap_contains_key(script->styles, name)) {
+			script_error(parser, _("`%s' is a macro or style, not a state"), name);
+			return false;
 		}
-		if (rf.file == NULL) {
-			char *dir = cat_files(getenv("HOME"), PKGUSERDIR);
-			char *name = cat_files(dir, filename);
-			rf.file = fopen(name, "r");
-			if (rf.file == NULL && errno != ENOENT)
-				script_die(_("cannot open `%s': %s"), name, strerror(errno));
-			free(name);
-			free(dir);
+		index = hmap_size(script->states) + 1;
+		if (index > MAX_STATES) {
+			script_error(parser, _("too many states (at most %d allowed)"), MAX_STATES);
+			return false;
 		}
-		if (rf.file == NULL) {
-			char *name = cat_files(PKGDATADIR, filename);
-			rf.file = fopen(name, "r");
-			if (rf.file == NULL && errno != ENOENT)
-				script_die(_("cannot open `%s': %s"), name, strerror(errno));
+		key = xstrdup(name);
+		hmap_put(script->states, key, (void *) index);
+		parser->state_names[index - 1] = key;
+	}
+
+	*mask = (uint64_t) 1 << (index - 1);
+	return true;
+}
+
+/* Lists are numbered in order of first use, like states. The values
+ * of a list are kept by each input, in ListSets.
+ */
+static uint32_t
+get_list(RemarkScript *script, const char *name)
+{
+	uintptr_t index = (uintptr_t) hmap_get(script->lists, name);
+
+	if (index == 0) {
+		index = hmap_size(script->lists) + 1;
+		hmap_put(script->lists, xstrdup(name), (void *) index);
+	}
+
+	return index - 1;
+}
+
+/* Relative names are looked up next to the including file (or in the
+ * current directory), then in the user's and the shared rule directory.
+ */
+static FILE *
+open_script(Parser *parser, const char *filename)
+{
+	char *name;
+	char *dir;
+	FILE *fh;
+
+	if (filename[0] != '/' && parser->file != NULL)
+		name = cat_files(parser->file->directory, filename);
+	else
+		name = xstrdup(filename);
+	fh = fopen(name, "r");
+	if (fh == NULL && errno == ENOENT && filename[0] != '/') {
+		free(name);
+		dir = cat_files(getenv("HOME"), PKGUSERDIR);
+		name = cat_files(dir, filename);
+		free(dir);
+		fh = fopen(name, "r");
+		if (fh == NULL && errno == ENOENT) {
 			free(name);
+			name = cat_files(PKGDATADIR, filename);
+			fh = fopen(name, "r");
 		}
-		if (rf.file == NULL)
-			script_die(_("cannot open `%s': %s"), filename, strerror(errno));
+	}
+	if (fh == NULL)
+		script_error(parser, _("cannot open `%s': %s"), errno == ENOENT ? filename : name, strerror(errno));
+	free(name);
+	return fh;
+}
 
+/* A file is only parsed the first time it is included. Its rules
+ * are kept like a macro, so later includes of the same file share
+ * them. Files are identified by device and inode, since the same file
+ * can be reached through different names.
+ */
+static Rule *
+include_script(Parser *parser, const char *filename)
+{
+	RemarkFile rf;
+	int old_yychar = yychar;
+	int old_yylineno = yylineno;
+	struct stat statbuf;
+	Macro *included;
+	char *key;
+	int rc;
+
+	rf.file = open_script(parser, filename);
+	if (rf.file == NULL)
+		return NULL;
+	if (fstat(fileno(rf.file), &statbuf) < 0) {
+		script_error(parser, _("cannot stat `%s': %s"), filename, strerror(errno));
+		fclose(rf.file);
+		return NULL;
+	}
+	key = xasprintf("%lu:%lu", (unsigned long) statbuf.st_dev, (unsigned long) statbuf.st_ino);
+	included = hmap_get(parser->script->includes, key);
+	if (included != NULL) {
+		fclose(rf.file);
+		free(key);
+		return new_macro_rule(included);
 	}
-	assert(rf.file != NULL);
 
 	yychar = '\0';
 	yylineno = 1;
@@ -230,14 +480,14 @@ include_script(const char *filename)
 	rf.directory = dir_name(filename);
 	rf.rules = llist_new();
 	rf.tokens = llist_new();
-	rf.previous = file;
-	file = &rf;
+	rf.previous = parser->file;
+	parser->file = &rf;
 
 	lexer_set_buffer(&rf);
-	yyparse();
+	rc = yyparse(parser);
 	lexer_restore_buffer(rf.previous);
 
-	file = rf.previous;
+	parser->file = rf.previous;
 	llist_iterate(rf.tokens, (IteratorFunc) free);
 	llist_free(rf.tokens);
 	fclose(rf.file);
@@ -245,27 +495,42 @@ include_script(const char *filename)
 	yylineno = old_yylineno;
 	yychar = old_yychar;
 
-	return new_multi_rule(rf.rules);
+	if (rc != 0) {
+		llist_iterate(rf.rules, (IteratorFunc) free_rule);
+		llist_free(rf.rules);
+		free(key);
+		return NULL;
+	}
+	included = new_macro(filename, new_multi_rule(rf.rules));
+	hmap_put(parser->script->includes, key, included);
+	return new_macro_rule(included);
 }
 
+/* Errors are reported with the file and line being read, and the
+ * first one stops the parser.
+ */
 static void
-script_die(const char *msg, ...)
+script_error(Parser *parser, const char *msg, ...)
 {
 	va_list ap;
-	
+	char *text;
+
+	if (parser->error != NULL)
+		return;
+
 	va_start(ap, msg);
-	if (file != NULL)
-		fprintf(stderr, "%s:%d: ", file->filename, yylineno);
-	else
-		fprintf(stderr, "%s: ", program_name);
-	vfprintf(stderr, msg, ap);
-	fprintf(stderr, "\n");
+	text = xvasprintf(msg, ap);
 	va_end(ap);
-	exit(1);
+	if (parser->file != NULL) {
+		parser->error = xasprintf("%s:%d: %s", parser->file->filename, yylineno, text);
+		free(text);
+	} else {
+		parser->error = text;
+	}
 }
 
 static void
-yyerror(char *msg)
+yyerror(Parser *parser, const char *msg)
 {
-	script_die("%s", msg);
+	script_error(parser, "%s", msg);
 }
@@ -23,6 +23,7 @@
 /* POSIX */
 #include <unistd.h>
 /* C89 */
+#include <limits.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
@@ -30,8 +31,9 @@
 #include <getopt.h>
 #include "dirname.h"
 #include "progname.h"
-#include "getline.h"
 #include "version-etc.h"
+#include "xalloc.h"
+#include "xvasprintf.h"
 /* Gettext */
 #include <gettext.h>
 #define _(String) gettext(String)
@@ -42,28 +44,91 @@
 #include "common/error.h"
 #include "common/llist.h"
 #include "common/intutil.h"
+#include "common/hmap.h"
 /* regex-markup */
 #include "remark.h"
 
 #define PROGRAM "remark"
+/* Default milliseconds to wait for the rest of a partial line with
+ * --cache-newline before it is written anyway.
+ */
+#define PARTIAL_TIMEOUT 100
 
 enum {
 	VERSION_OPT	= 1000,
 	HELP_OPT,
+	REGEX_ENGINE_OPT,
+	CHECK_OPT,
+	STATISTICS_OPT,
+	REGEX_STEPS_OPT,
+	BYTES_OPT,
+	ESCAPES_OPT,
+	FOLLOW_OPT,
+	STATE_OPT,
+	SINCE_OPT,
+	UNTIL_OPT,
+	TIME_FORMAT_OPT,
+	CACHE_NEWLINE_OPT,
+	SOURCE_OPT,
+	DAEMON_OPT,
+	SOCKET_OPT,
+};
+
+typedef struct _LineTarget LineTarget;
+
+struct _LineTarget {
+	RemarkScript *script;
+	RemarkInput *input;
+	char *tag;
+	uint64_t states;
+	ListSets lists;
 };
 
 static uint32_t prepend_len = 0;
 static uint32_t append_len = 0;
 static char *prepend_string = "";
 static char *append_string = "";
+static uint32_t wrap_width = UINT32_MAX;
+static uint32_t wrap_retain = 0;
+static WrapperType wrapper = WRAPPER_NONE;
+static EscapeMode escape_mode = ESCAPES_KEEP;
+static bool check = false;
+static bool regex_options = false;
+static bool statistics = false;
+static bool follow = false;
+static bool tail = false;
+static uint32_t tail_lines = 0;
+static char *time_since = NULL;
+static char *time_until = NULL;
+static char *state_file = NULL;
+static int partial_timeout = -1;
+static LList *source_specs = NULL;
+static char *daemon_socket = NULL;
+static char *client_socket = NULL;
 
-static char *short_opts = "a:f:p:r:w:";
+static char *short_opts = "a:f:n:p:r:w:";
 static struct option long_opts[] = {
 	{ "prepend",   required_argument, NULL, 'p' },
 	{ "append",    required_argument, NULL, 'a' },
 	{ "retain",    required_argument, NULL, 'r' },
 	{ "width",     required_argument, NULL, 'w' },
 	{ "wrap",      required_argument, NULL, 'f' },
+	{ "lines",     required_argument, NULL, 'n' },
+	{ "regex-engine", required_argument, NULL, REGEX_ENGINE_OPT },
+	{ "check",     no_argument,	  NULL, CHECK_OPT },
+	{ "statistics", no_argument,	  NULL, STATISTICS_OPT },
+	{ "regex-steps", required_argument, NULL, REGEX_STEPS_OPT },
+	{ "bytes",     no_argument,	  NULL, BYTES_OPT },
+	{ "escapes",   required_argument, NULL, ESCAPES_OPT },
+	{ "follow",    no_argument,	  NULL, FOLLOW_OPT },
+	{ "state",     required_argument, NULL, STATE_OPT },
+	{ "since",     required_argument, NULL, SINCE_OPT },
+	{ "until",     required_argument, NULL, UNTIL_OPT },
+	{ "time-format", required_argument, NULL, TIME_FORMAT_OPT },
+	{ "cache-newline", optional_argument, NULL, CACHE_NEWLINE_OPT },
+	{ "source",    required_argument, NULL, SOURCE_OPT },
+	{ "daemon",    required_argument, NULL, DAEMON_OPT },
+	{ "socket",    required_argument, NULL, SOCKET_OPT },
 	{ "version",   no_argument,	  NULL, VERSION_OPT },
 	{ "help",      no_argument,	  NULL, HELP_OPT },
 	{ 0 },
@@ -84,57 +149,161 @@ static void
 display_help(void)
 {
 	printf(_("Usage: %s [OPTION]... FILE [TEXT]\n\
+  or:  %s [OPTION]... FILE -- COMMAND [ARG]...\n\
+  or:  %s [OPTION]... -- -- COMMAND [ARG]...\n\
 Read lines of text from standard in (or use TEXT as input string), highlight\n\
-according to rules defined in FILE, and print to standard out.\n\
+according to rules defined in FILE, and print to standard out. With COMMAND,\n\
+run it and highlight its output instead, using the rules for COMMAND if FILE\n\
+is not given. A -- before FILE only ends the options.\n\
 \n\
   -p, --prepend=STRING       string to prepend to all split lines (except last)\n\
   -a, --append=STRING        string to append to all split lines (except first)\n\
   -r, --retain=COUNT         copy characters from first line to wrapped ones\n\
   -w, --width=COLUMNS        wrapping width\n\
   -f, --wrap=TYPE            specifies wrapping type (word/char/none).\n\
+  -n, --lines=COUNT          only read the last COUNT lines of the files given\n\
+                             after FILE, or of standard in\n\
+      --regex-engine=NAME    regex engine (auto/libc/gnulib/pcre2)\n\
+      --regex-steps=COUNT    give up regex matches that backtrack more than\n\
+                             COUNT times (0 for no limit)\n\
+      --bytes                match regexes against bytes, not characters\n\
+      --escapes=MODE         escape sequences in input (keep/strip/restore)\n\
+      --follow               follow the files given after FILE as they grow\n\
+      --state=STATEFILE      save and resume positions of followed files\n\
+      --source=LOGFILE[,tag=TAG][,rules=RULEFILE]\n\
+                             follow LOGFILE too, which may also be a FIFO, a\n\
+                             socket or - for standard in, printing TAG before\n\
+                             its lines and highlighting them with RULEFILE\n\
+      --since=TIME           only read lines from TIME on in the files given\n\
+                             after FILE, or in standard in\n\
+      --until=TIME           only read lines up to TIME\n\
+      --time-format=FORMAT   strptime format of times at the start of lines\n\
+      --cache-newline[=MSECS]\n\
+                             hold back the last newline of output, and write\n\
+                             partial lines of standard in after MSECS\n\
+      --daemon=SOCKET        serve highlighting to clients connecting to SOCKET\n\
+      --socket=SOCKET        let the daemon at SOCKET highlight standard in, if\n\
+                             one is running (default $REMARK_SOCKET)\n\
+      --check                check FILE and all its regexes, then exit\n\
+      --statistics           print memory statistics to standard error\n\
       --help                 display this help and exit\n\
       --version              output version information and exit\n\
 \n\
-Report bugs to <%s>.\n"), program_name, PACKAGE_BUGREPORT);
+Report bugs to <%s>.\n"), program_name, program_name, program_name, PACKAGE_BUGREPORT);
+}
+
+/* Set up input for highlighting with the wrapping and escape options. */
+static void
+setup_input(RemarkInput *input)
+{
+	init_input(input);
+	input->escape_mode = escape_mode;
+	input->wrapper = wrapper;
+	input->wrap_width = wrap_width;
+	input->wrap_retain = wrap_retain;
+}
+
+static void
+init_target(LineTarget *target, RemarkScript *script, RemarkInput *input)
+{
+	target->script = script;
+	target->input = input;
+	target->tag = NULL;
+	target->states = 0;
+	target->lists.sets = NULL;
+	target->lists.count = 0;
+}
+
+static void
+free_target(LineTarget *target)
+{
+	free_list_sets(&target->lists);
+	free(target->tag);
 }
 
+/* Highlight and print a line. Each target has its own states and list
+ * values, so that lines from different sources do not affect each other.
+ */
 static void
-try_line(RemarkScript *script, RemarkInput *input, char *text)
+try_line(LineTarget *target, char *text, bool partial)
 {
+	RemarkInput *input = target->input;
+
+	input->states = target->states;
+	input->lists = target->lists;
 	strbuf_set(input->mb.buffer, text);
 	input->mb.bufferlen = strlen(text);
+	if (input->escape_mode != ESCAPES_KEEP)
+		strip_escapes(input);
 	strbuf_set(input->append_mb.buffer, append_string);
 	input->append_mb.bufferlen = append_len;
 	strbuf_set(input->prepend_mb.buffer, prepend_string);
 	input->prepend_mb.bufferlen = prepend_len;
 
-	if (execute_script(script, input)) {
-		fputs(strbuf_buffer(input->mb.buffer), stdout);
-		fflush(stdout);
+	if (execute_script(target->script, input)) {
+		if (target->tag != NULL)
+			write_output(target->tag, strlen(target->tag), false);
+		write_output(strbuf_buffer(input->mb.buffer), strbuf_length(input->mb.buffer), partial);
 	}
+	target->states = input->states;
+	target->lists = input->lists;
+	input->lists.sets = NULL;
+	input->lists.count = 0;
 }
 
-int
-main(int argc, char **argv)
+static void
+follow_line(char *line, void *userdata)
 {
-	struct sigaction action;
-	RemarkInput input;
-	int c;
+	try_line(userdata, line, false);
+}
 
-	set_program_name(argv[0]);
+static void
+partial_line(char *line, void *userdata)
+{
+	try_line(userdata, line, true);
+}
 
-	setlocale(LC_ALL, "");
-	bindtextdomain(PACKAGE, LOCALEDIR);
-	textdomain(PACKAGE);
+/* Parse a --source specification into a source whose target has the
+ * script named by `rules=', or script by default. Scripts are parsed
+ * once and shared between sources.
+ */
+static void
+parse_source(char *spec, FollowSource *source, RemarkScript *script, RemarkInput *input, HMap *scripts)
+{
+	LineTarget *target = xmalloc(sizeof(LineTarget));
+	char *field;
+	char *next;
 
-	memset(&action, 0, sizeof(struct sigaction));
-	/* 2003-04-11 : I don't know why this is good in the first place... */
-	/*if (!isatty(STDIN_FILENO)) {
-		action.sa_handler = SIG_IGN;
-		action.sa_flags = SA_RESTART;
-		if (sigaction(SIGINT, &action, NULL) < 0)
-			die_errno(NULL);
-	}*/
+	init_target(target, script, input);
+	spec = xstrdup(spec);
+	source->filename = spec;
+	source->userdata = target;
+
+	for (field = strchr(spec, ','); field != NULL; field = next) {
+		*field++ = '\0';
+		next = strchr(field, ',');
+		if (next != NULL)
+			*next = '\0';
+		if (starts_with(field, "tag=")) {
+			target->tag = xasprintf("%s ", field+4);
+		} else if (starts_with(field, "rules=")) {
+			target->script = hmap_get(scripts, field+6);
+			if (target->script == NULL) {
+				target->script = parse_script(field+6);
+				hmap_put(scripts, field+6, target->script);
+			}
+		} else {
+			die(_("invalid source field: %s"), field);
+		}
+	}
+	if (*spec == '\0')
+		die(_("missing file name in source"));
+}
+
+static void
+parse_options(int argc, char **argv)
+{
+	int c;
 
 	while ((c = getopt_long (argc, argv, short_opts, long_opts, NULL)) != -1) {
 		switch (c) {
@@ -152,10 +321,80 @@ main(int argc, char **argv)
 			if (!parse_uint32(optarg, &wrap_width))
 				die(_("invalid width: %s"), optarg);
 			break;
+		case 'n':
+			if (!parse_uint32(optarg, &tail_lines))
+				die(_("invalid number of lines: %s"), optarg);
+			tail = true;
+			break;
 		case 'f':
-			if (!identify_wrapper(optarg))
+			if (!identify_wrapper(optarg, &wrapper))
 				die(_("invalid wrapping type: %s"), optarg);
 			break;
+		case REGEX_ENGINE_OPT:
+			regex_options = true;
+			if (!identify_regex_engine(optarg))
+				die(_("unknown regex engine: %s"), optarg);
+			break;
+		case CHECK_OPT:
+			check = true;
+			break;
+		case REGEX_STEPS_OPT:
+			regex_options = true;
+			if (!parse_uint32(optarg, &regex_max_steps))
+				die(_("invalid step count: %s"), optarg);
+			break;
+		case BYTES_OPT:
+			regex_options = true;
+#ifdef HAVE_USELOCALE
+			regex_bytes = true;
+#else
+			setlocale(LC_CTYPE, "C");
+#endif
+			break;
+		case ESCAPES_OPT:
+			if (!identify_escape_mode(optarg, &escape_mode))
+				die(_("invalid escape mode: %s"), optarg);
+			break;
+		case FOLLOW_OPT:
+			follow = true;
+			break;
+		case SOURCE_OPT:
+			if (source_specs == NULL)
+				source_specs = llist_new();
+			llist_add_last(source_specs, optarg);
+			follow = true;
+			break;
+		case DAEMON_OPT:
+			daemon_socket = optarg;
+			break;
+		case SOCKET_OPT:
+			client_socket = optarg;
+			break;
+		case STATE_OPT:
+			state_file = optarg;
+			break;
+		case SINCE_OPT:
+			time_since = optarg;
+			break;
+		case UNTIL_OPT:
+			time_until = optarg;
+			break;
+		case TIME_FORMAT_OPT:
+			time_format = optarg;
+			break;
+		case CACHE_NEWLINE_OPT:
+			cache_newline = true;
+			partial_timeout = PARTIAL_TIMEOUT;
+			if (optarg != NULL) {
+				uint32_t timeout;
+				if (!parse_uint32(optarg, &timeout) || timeout > INT_MAX)
+					die(_("invalid timeout: %s"), optarg);
+				partial_timeout = timeout;
+			}
+			break;
+		case STATISTICS_OPT:
+			statistics = true;
+			break;
 		case VERSION_OPT:
 			display_version();
 			exit(0);
@@ -171,37 +410,213 @@ main(int argc, char **argv)
 
 	append_len = strlen(append_string);
 	prepend_len = strlen(prepend_string);
+	if (wrapper != WRAPPER_NONE && wrap_width == UINT32_MAX)
+		wrap_width = 80;
 	if (wrapper == 0)
 		wrapper = WRAPPER_CHAR;
-	if (wrap_retain + append_len + prepend_len >= wrap_width)
+	if ((uint64_t) wrap_retain + display_width(append_string, append_len)
+			+ display_width(prepend_string, prepend_len) >= wrap_width)
 		die(_("retain, append and prepend too long"));
+}
+
+/* Highlight the input of a daemon client, in a process of its own.
+ * Errors go to the client. Options that change how the script is
+ * compiled cannot be used, since the daemon compiled it already, nor
+ * can options for anything but highlighting standard in.
+ */
+static void
+serve_client(int fd, RemarkScript *script, int argc, char **argv)
+{
+	RemarkInput input;
+	LineTarget target;
 
-	init_input(&input);
+	if (dup2(fd, STDERR_FILENO) < 0)
+		exit(1);
+	check = false;
+	regex_options = false;
+	follow = false;
+	tail = false;
+	time_since = NULL;
+	time_until = NULL;
+	daemon_socket = NULL;
+	optind = 0;
+	parse_options(argc, argv);
+	if (regex_options)
+		die(_("--regex-engine, --regex-steps and --bytes cannot be used by a daemon client"));
+	if (check || follow || tail || time_since != NULL || time_until != NULL || daemon_socket != NULL)
+		die(_("a daemon client can only highlight standard in"));
+	setup_input(&input);
+	init_target(&target, script, &input);
+	stream_fd(fd, _("client"), partial_timeout, follow_line, partial_line, &target);
+	finish_output();
+	free_target(&target);
+	free_input(&input);
+}
 
-	if (argc-optind >= 2) {
-		RemarkScript *script = parse_script(argv[optind]);
-		for (c = optind+1; c < argc; c++)
-			try_line(script, &input, argv[c]);
+int
+main(int argc, char **argv)
+{
+	struct sigaction action;
+	RemarkInput input;
+	char **command = NULL;
+	int status = 0;
+	int c;
+
+	set_program_name(argv[0]);
+
+	setlocale(LC_ALL, "");
+	bindtextdomain(PACKAGE, LOCALEDIR);
+	textdomain(PACKAGE);
+
+	memset(&action, 0, sizeof(struct sigaction));
+	/* 2003-04-11 : I don't know why this is good in the first place... */
+	/*if (!isatty(STDIN_FILENO)) {
+		action.sa_handler = SIG_IGN;
+		action.sa_flags = SA_RESTART;
+		if (sigaction(SIGINT, &action, NULL) < 0)
+			die_errno(NULL);
+	}*/
+
+	/* A -- after the rule file starts a command to run, and everything
+	 * after it are arguments for that command. A -- before the rule
+	 * file only ends the options.
+	 */
+	for (c = 1; c < argc && strcmp(argv[c], "--") != 0; c++)
+		;
+	parse_options(c, argv);
+	if (c < argc && optind == c) {
+		optind = c+1;
+		for (c = optind; c < argc && strcmp(argv[c], "--") != 0; c++)
+			;
+	}
+	if (c < argc) {
+		command = argv+c+1;
+		argv[c] = NULL;
+		argc = c;
+	}
+
+	if (check) {
+		RemarkScript *script;
+		char *error;
+
+		if (argc-optind < 1)
+			die(_("missing file operand"));
+		script = read_script(argv[optind], false, &error);
+		if (script == NULL)
+			die("%s", error);
 		free_script(script);
+		exit(0);
 	}
-	else {
-		RemarkScript *script = NULL;
-		size_t linesize = 0;
-		char *line = NULL;
-
-		script = parse_script(argc > optind ? argv[optind] : NULL);
-		while (getline(&line, &linesize, stdin) != -1) {
-			chomp(line);
-			try_line(script, &input, line);
+
+	if (daemon_socket != NULL)
+		run_daemon(daemon_socket, serve_client);
+
+	setup_input(&input);
+
+	if (command != NULL) {
+		LineTarget target;
+		char *rules;
+
+		if (*command == NULL)
+			die(_("missing command operand"));
+		if (follow || tail || time_since != NULL || time_until != NULL)
+			die(_("a command cannot be run with --follow, --lines, --since or --until"));
+		if (argc-optind > 1)
+			die(_("too many arguments"));
+		rules = (argc > optind ? xstrdup(argv[optind]) : command_rule_file(command[0]));
+		init_target(&target, parse_script(rules), &input);
+		status = run_command(command, partial_timeout, follow_line, partial_line, &target);
+		free_target(&target);
+		free_script(target.script);
+		free(rules);
+	}
+	else if (time_since != NULL || time_until != NULL) {
+		LineTarget target;
+
+		if (follow || tail)
+			die(_("--since and --until cannot be used with --follow or --lines"));
+		if (argc-optind < 1)
+			die(_("missing file operand"));
+		init_target(&target, parse_script(argv[optind]), &input);
+		window_files(argv+optind+1, argc-optind-1, time_since, time_until, follow_line, &target);
+		free_target(&target);
+		free_script(target.script);
+	}
+	else if (follow) {
+		LineTarget target;
+		FollowSource *sources;
+		HMap *scripts = hmap_new();
+		uint32_t specs = (source_specs == NULL ? 0 : llist_size(source_specs));
+		uint32_t count;
+
+		if (argc-optind < (specs == 0 ? 2 : 1))
+			die(_("missing file operand"));
+		init_target(&target, parse_script(argv[optind]), &input);
+		count = argc-optind-1;
+		sources = xmalloc((count + specs) * sizeof(FollowSource));
+		for (c = 0; c < count; c++) {
+			sources[c].filename = argv[optind+1+c];
+			sources[c].userdata = &target;
 		}
-		free(line);
-		free_script(script);
+		for (c = 0; c < specs; c++)
+			parse_source(llist_get(source_specs, c), &sources[count+c], target.script, &input, scripts);
+
+		follow_files(sources, count+specs, tail_lines, state_file, follow_line);
+
+		for (c = count; c < count+specs; c++) {
+			LineTarget *source_target = sources[c].userdata;
+			free_target(source_target);
+			free(source_target);
+			free((char *) sources[c].filename);
+		}
+		free(sources);
+		hmap_foreach_value(scripts, free_script);
+		hmap_free(scripts);
+		if (source_specs != NULL)
+			llist_free(source_specs);
+		free_target(&target);
+		free_script(target.script);
+	}
+	else if (tail) {
+		LineTarget target;
 
-		if (ferror(stdin))
-			die_errno(_("cannot read from standard in"));
+		if (argc-optind < 1)
+			die(_("missing file operand"));
+		init_target(&target, parse_script(argv[optind]), &input);
+		tail_files(argv+optind+1, argc-optind-1, tail_lines, follow_line, &target);
+		free_target(&target);
+		free_script(target.script);
 	}
+	else if (argc-optind >= 2) {
+		LineTarget target;
 
+		init_target(&target, parse_script(argv[optind]), &input);
+		for (c = optind+1; c < argc; c++)
+			try_line(&target, argv[c], false);
+		free_target(&target);
+		free_script(target.script);
+	}
+	else {
+		char *rules = (argc > optind ? argv[optind] : NULL);
+		LineTarget target;
+
+		if (client_socket == NULL)
+			client_socket = getenv("REMARK_SOCKET");
+		if (client_socket == NULL || statistics || regex_options || !run_client(client_socket, rules, argc, argv)) {
+			init_target(&target, parse_script(rules), &input);
+			stream_fd(STDIN_FILENO, _("standard in"), partial_timeout, follow_line, partial_line, &target);
+			free_target(&target);
+			free_script(target.script);
+		}
+	}
+
+	finish_output();
+
+	if (statistics) {
+		fprintf(stderr, _("allocations while matching: %u\n"), input.scratch.allocations);
+		fprintf(stderr, _("regex matches over the step limit: %u\n"), input.scratch.exceeded);
+	}
 	free_input(&input);
 
-	exit(0);
+	exit_like(status);
 }
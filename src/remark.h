@@ -25,9 +25,14 @@
 #include <stdio.h>		/* C89 */
 #include "common/llist.h"
 #include "common/hmap.h"
+#include "common/hset.h"
 #include "common/strbuf.h"
+#include "libremark.h"
 
 #define PKGUSERDIR ".remark"
+#define MAX_STATES 64
+#define LIST_CAPACITY 1024
+#define MATCH_STATE_SUBC 10
 
 typedef enum _ActionType ActionType;
 typedef enum _MatchType MatchType;
@@ -35,10 +40,21 @@ typedef enum _RuleType RuleType;
 typedef enum _StyleInfoType StyleInfoType;
 typedef enum _RegexFlags RegexFlags;
 typedef enum _WrapperType WrapperType;
+typedef enum _EscapeMode EscapeMode;
+typedef enum _ConditionType ConditionType;
+typedef enum _CompareOp CompareOp;
+typedef enum _ListOp ListOp;
 typedef struct _StyleInfo StyleInfo;
 typedef struct _Match Match;
 typedef struct _SubexMatch SubexMatch;
+typedef struct _Regex Regex;
+typedef struct _RegexEngine RegexEngine;
 typedef struct _RegexMatch RegexMatch;
+typedef struct _LiteralMatch LiteralMatch;
+typedef struct _TokenMatch TokenMatch;
+typedef struct _FieldMatch FieldMatch;
+typedef struct _JsonMatch JsonMatch;
+typedef struct _Token Token;
 typedef struct _Rule Rule;
 typedef struct _Macro Macro;
 typedef struct _Style Style;
@@ -49,13 +65,22 @@ typedef struct _MatchRule MatchRule;
 typedef struct _ActionRule ActionRule;
 typedef struct _SubstitutionRule SubstitutionRule;
 typedef struct _SetRule SetRule;
+typedef struct _ConditionRule ConditionRule;
+typedef struct _StateRule StateRule;
+typedef struct _StateChangeRule StateChangeRule;
+typedef struct _ListRule ListRule;
+typedef struct _Condition Condition;
 typedef struct _MatchState MatchState;
 typedef struct _MatchBuffer MatchBuffer;
+typedef struct _MatchScratch MatchScratch;
+typedef struct _ListSets ListSets;
+typedef struct _JsonIndex JsonIndex;
 typedef struct _SubmatchSpec SubmatchSpec;
 typedef struct _StyleRange StyleRange;
 typedef struct _RemarkInput RemarkInput;
 typedef struct _RemarkFile RemarkFile;
-typedef struct _RemarkScript RemarkScript;
+typedef struct _Parser Parser;
+typedef struct _FollowSource FollowSource;
 
 enum _ActionType {
 	ACTION_CONTINUE,
@@ -66,6 +91,10 @@ enum _ActionType {
 enum _MatchType {
 	MATCH_REGEX,
 	MATCH_SUBEX,
+	MATCH_LITERAL,
+	MATCH_TOKEN,
+	MATCH_FIELD,
+	MATCH_JSON,
 };
 
 enum _RuleType {
@@ -76,6 +105,10 @@ enum _RuleType {
 	RULE_ACTION,
 	RULE_SUBSTITUTION,
 	RULE_SET,
+	RULE_CONDITION,
+	RULE_STATE,
+	RULE_STATE_CHANGE,
+	RULE_LIST,
 };
 
 enum _StyleInfoType {
@@ -87,6 +120,31 @@ enum _StyleInfoType {
 enum _RegexFlags {
 	REGEX_GLOBAL		= 1 << 0,
 	REGEX_IGNORE_CASE	= 1 << 1,
+	REGEX_ENGINE_LIBC	= 1 << 2,
+	REGEX_ENGINE_GNULIB	= 1 << 3,
+	REGEX_ENGINE_PCRE2	= 1 << 4,
+};
+
+enum _ConditionType {
+	CONDITION_COMPARE,
+	CONDITION_AND,
+	CONDITION_OR,
+	CONDITION_NOT,
+};
+
+enum _CompareOp {
+	COMPARE_EQ,
+	COMPARE_NE,
+	COMPARE_LT,
+	COMPARE_LE,
+	COMPARE_GT,
+	COMPARE_GE,
+};
+
+enum _ListOp {
+	LIST_ADD,
+	LIST_REMOVE,
+	LIST_IN,
 };
 
 enum _WrapperType {
@@ -95,6 +153,12 @@ enum _WrapperType {
 	WRAPPER_WORD,
 };
 
+enum _EscapeMode {
+	ESCAPES_KEEP,
+	ESCAPES_STRIP,
+	ESCAPES_RESTORE,
+};
+
 struct _StyleInfo {
 	StyleInfoType type;
 	const void *value;
@@ -106,11 +170,37 @@ struct _Match {
 
 struct _RegexMatch {
 	Match m;
-	regex_t regex;
+	Regex *regex;
 	char *regex_string;
 	RegexFlags flags;
 };
 
+struct _LiteralMatch {
+	Match m;
+	char *string;
+	uint32_t length;
+	RegexFlags flags;
+};
+
+struct _TokenMatch {
+	Match m;
+	const Token *token;
+	RegexFlags flags;
+};
+
+struct _FieldMatch {
+	Match m;
+	char *delimiter;
+	uint32_t length;
+	uint32_t index;
+};
+
+struct _JsonMatch {
+	Match m;
+	char *key;
+	uint32_t length;
+};
+
 struct _SubexMatch {
 	Match m;
 	uint32_t index;
@@ -163,7 +253,7 @@ struct _ActionRule {
 
 struct _SubstitutionRule {
 	Rule r;
-	regex_t regex;
+	Regex *regex;
 	RegexFlags flags;
 	char *replacement;
 };
@@ -173,11 +263,66 @@ struct _SetRule {
 	char *replacement;
 };
 
+struct _Condition {
+	ConditionType type;
+	Condition *left;
+	Condition *right;
+	uint32_t index;
+	CompareOp op;
+	double value;
+};
+
+struct _ConditionRule {
+	Rule r;
+	Condition *condition;
+	Rule *rule;
+};
+
+struct _StateRule {
+	Rule r;
+	uint64_t mask;
+	Rule *rule;
+};
+
+struct _StateChangeRule {
+	Rule r;
+	uint64_t mask;
+	bool enter;
+};
+
+struct _ListRule {
+	Rule r;
+	ListOp op;
+	uint32_t list;
+	char *key;
+	int32_t key_index;
+	Rule *rule;
+};
+
 struct _MatchBuffer {
 	StrBuf *buffer;
 	uint32_t bufferlen;
+	uint32_t serial;
+	uint64_t *states;
+	ListSets *lists;
+	MatchScratch *scratch;
 	LList *styles;
 	Iterator *styles_it;
+	LList *escapes;
+};
+
+/* Memory that matching reuses from line to line. The buffers of an
+ * input share one, so that inputs have nothing in common but the
+ * compiled script.
+ */
+struct _MatchScratch {
+	MatchState *free_states;
+	SubmatchSpec *fields;
+	uint32_t fields_size;
+	JsonIndex *json;
+	uint32_t json_next;
+	uint32_t allocations;
+	uint32_t exceeded;
 };
 
 struct _SubmatchSpec {
@@ -188,7 +333,9 @@ struct _SubmatchSpec {
 struct _MatchState {
 	MatchBuffer *top;
 	MatchState *parent;
+	bool fields;
 	uint32_t subc;
+	uint32_t size;
 	SubmatchSpec subv[0];
 };
 
@@ -200,10 +347,29 @@ struct _StyleRange {
 	uint32_t post_length;
 };
 
+/* The values of the lists of a script, indexed by the number the
+ * script gives each list. Like states, they belong to the input and
+ * not to the script. A set is made when a value is first added.
+ */
+struct _ListSets {
+	HSet **sets;
+	uint32_t count;
+};
+
 struct _RemarkInput {
+	uint64_t states;
+	ListSets lists;
+	MatchScratch scratch;
 	MatchBuffer mb;
 	MatchBuffer append_mb;
 	MatchBuffer prepend_mb;
+	HMap *escapes;
+	EscapeMode escape_mode;
+	WrapperType wrapper;
+	uint32_t wrap_width;
+	uint32_t wrap_retain;
+	uint32_t append_cols;
+	uint32_t prepend_cols;
 };
 
 struct _RemarkFile {
@@ -216,14 +382,36 @@ struct _RemarkFile {
 	void *lex_buffer;
 };
 
+/* What the parser works on while it reads a rule file and the files
+ * it includes. Only the first error is kept.
+ */
+struct _Parser {
+	RemarkScript *script;
+	RemarkFile *file;
+	char *error;
+	uint64_t tested_states;		/* states that blocks are named after */
+	uint64_t entered_states;
+	const char *state_names[MAX_STATES];
+};
+
 struct _RemarkScript {
 	HMap *styles;
 	HMap *macros;
+	HMap *states;
+	HMap *lists;
+	HMap *includes;
+	HMap *regexes;
+	bool lazy;
 	Rule *prepend_rule;
 	Rule *append_rule;
 	Rule *rule;
 };
 
+struct _FollowSource {
+	const char *filename;
+	void *userdata;
+};
+
 /* style.c */
 StyleInfo *new_styleinfo_style(Style *style);
 StyleInfo *new_styleinfo_pre(const char *string);
@@ -242,20 +430,54 @@ Rule *new_multi_rule(LList *rules);
 Rule *new_match_rule(LList *matches, Rule *rule);
 Rule *new_action_rule(ActionType action);
 void free_rule(Rule *anyrule);
-Rule *new_substitution_rule(const char *match, const char *repl, RegexFlags flags);
+Rule *new_substitution_rule(RemarkScript *script, const char *match, const char *repl, RegexFlags flags, char **error);
 Rule *new_prepend_rule(Rule *rule);
 Rule *new_append_rule(Rule *rule);
 Rule *new_set_rule(const char *replacement);
+Rule *new_condition_rule(Condition *condition, Rule *rule);
+Rule *new_state_rule(uint64_t mask, Rule *rule);
+Rule *new_state_change_rule(uint64_t mask, bool enter);
+Rule *new_list_rule(ListOp op, uint32_t list, const char *key, Rule *rule);
+Condition *new_compare_condition(uint32_t index, CompareOp op, double value);
+Condition *new_logic_condition(ConditionType type, Condition *left, Condition *right);
+void free_condition(Condition *condition);
+bool check_subexpressions(Rule *anyrule, uint32_t subc, uint32_t *index);
 
 /* match.c */
 void free_match(Match *anymatch);
-Match *new_regex_match(const char *respec, RegexFlags flags);
+Match *new_regex_match(RemarkScript *script, const char *respec, RegexFlags flags, char **error);
 Match *new_subex_match(uint32_t index);
+Match *new_literal_match(const char *string, RegexFlags flags);
+Match *new_token_match(const Token *token, RegexFlags flags);
+Match *new_field_match(const char *delimiter, uint32_t index);
+Match *new_json_match(const char *key);
 MatchState *new_match_state(MatchBuffer *mb, uint32_t so, uint32_t eo, uint32_t subc);
 MatchState *try_match(Match *match, MatchState *ms, uint32_t *start, uint32_t call);
+uint32_t match_subexpressions(Match *match);
 void free_match_state(MatchState *ms);
+void free_match_scratch(MatchScratch *scratch);
 char *expand_substitution(const char *repl, MatchState *ms, uint32_t subc, SubmatchSpec *subv);
 
+/* token.c */
+const Token *identify_token(const char *name);
+uint32_t token_subexpressions(const Token *token);
+bool token_search(const Token *token, const char *buf, uint32_t bo, uint32_t so, uint32_t eo, SubmatchSpec *subv);
+
+/* engine.c */
+extern const RegexEngine *regex_engine;
+extern bool regex_bytes;
+extern uint32_t regex_max_steps;
+bool identify_regex_engine(const char *name);
+Regex *new_regex(RemarkScript *script, const char *pattern, RegexFlags flags, char **error);
+void free_regex(Regex *regex);
+bool regex_compiled(Regex *regex);
+uint32_t regex_nsub(Regex *regex);
+bool regex_exec(Regex *regex, MatchBuffer *mb, uint32_t so, uint32_t eo, uint32_t subc, SubmatchSpec *subv);
+
+/* json.c */
+bool json_lookup(MatchBuffer *mb, uint32_t so, uint32_t eo, const char *key, uint32_t keylen, SubmatchSpec *value);
+void json_free_cache(MatchScratch *scratch);
+
 /* lexer.l */
 int yylex(void);
 void lexer_set_buffer(RemarkFile *rf);
@@ -263,22 +485,53 @@ void lexer_restore_buffer(RemarkFile *file);
 extern int yylineno;
 
 /* parser.y */
+RemarkScript *read_script(const char *filename, bool lazy, char **error);
 RemarkScript *parse_script(const char *filename);
 void free_script(RemarkScript *script);
 
 /* execute.c */
+bool identify_escape_mode(const char *name, EscapeMode *mode);
+void strip_escapes(RemarkInput *input);
 bool execute_script(RemarkScript *script, RemarkInput *input);
+void free_list_sets(ListSets *lists);
 void init_input(RemarkInput *input);
 void free_input(RemarkInput *input);
 
 /* wrap.c */
-extern uint32_t wrap_retain;
-extern uint32_t wrap_width;
-extern WrapperType wrapper;
-bool identify_wrapper(const char *spec);
+bool identify_wrapper(const char *spec, WrapperType *type);
 
 void check_args(void);
 void wrap_line(RemarkScript *script, RemarkInput *input);
 void apply_styles(MatchBuffer *mb, uint32_t ep);
 
+/* follow.c */
+typedef void (*FollowHandler)(char *line, void *userdata);
+void follow_files(FollowSource *sources, uint32_t count, uint32_t lines, const char *state_file, FollowHandler handler);
+void tail_files(char **filenames, uint32_t count, uint32_t lines, FollowHandler handler, void *userdata);
+extern const char *time_format;
+void window_files(char **filenames, uint32_t count, const char *since, const char *until, FollowHandler handler, void *userdata);
+void stream_fd(int fd, const char *filename, int timeout, FollowHandler handler, FollowHandler partial_handler, void *userdata);
+int64_t current_millis(void);
+
+/* run.c */
+char *command_rule_file(const char *command);
+int run_command(char **args, int timeout, FollowHandler handler, FollowHandler partial_handler, void *userdata);
+void exit_like(int status) __attribute__ ((noreturn));
+
+/* daemon.c */
+typedef void (*DaemonHandler)(int fd, RemarkScript *script, int argc, char **argv);
+void run_daemon(const char *socket_file, DaemonHandler handler) __attribute__ ((noreturn));
+bool run_client(const char *socket_file, const char *rules, int argc, char **argv);
+
+/* output.c */
+extern bool cache_newline;
+void write_output(const char *text, uint32_t len, bool partial);
+void flush_output(void);
+void finish_output(void);
+
+/* width.c */
+uint32_t display_width(const char *str, uint32_t len);
+uint32_t display_span(const char *str, uint32_t len, uint32_t width);
+uint32_t escape_length(const char *escape, uint32_t len);
+
 #endif
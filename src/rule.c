@@ -26,9 +26,10 @@
 /* gnulib */
 #include <regex.h>
 #include <xalloc.h>
-/* common */
-#include "common/regex-utils.h"
-#include "common/error.h"
+#include <xvasprintf.h>
+/* Gettext */
+#include <gettext.h>
+#define _(String) gettext(String)
 /* regex-markup */
 #include "remark.h"
 
@@ -100,6 +101,7 @@ free_rule(Rule *anyrule)
 		for (c = 0; c < rule->match_count; c++)
 			free_match(rule->matches[c]);
 		free(rule->matches);
+		free_rule(rule->rule);
 	}
 	else if (anyrule->type == RULE_MACRO) {
 		MacroRule *rule = (MacroRule *) anyrule;
@@ -120,13 +122,30 @@ free_rule(Rule *anyrule)
 	}
 	else if (anyrule->type == RULE_SUBSTITUTION) {
 		SubstitutionRule *rule = (SubstitutionRule *) anyrule;
-		regfree(&rule->regex);
+		free_regex(rule->regex);
 		free(rule->replacement);
 	}
 	else if (anyrule->type == RULE_SET) {
 		SetRule *rule = (SetRule *) anyrule;
 		free(rule->replacement);
 	}
+	else if (anyrule->type == RULE_CONDITION) {
+		ConditionRule *rule = (ConditionRule *) anyrule;
+		free_condition(rule->condition);
+		free_rule(rule->rule);
+	}
+	else if (anyrule->type == RULE_STATE) {
+		StateRule *rule = (StateRule *) anyrule;
+		free_rule(rule->rule);
+	}
+	else if (anyrule->type == RULE_STATE_CHANGE) {
+		/* no operation */
+	}
+	else if (anyrule->type == RULE_LIST) {
+		ListRule *rule = (ListRule *) anyrule;
+		free(rule->key);
+		free_rule(rule->rule);
+	}
 
 	free(anyrule);
 }
@@ -207,26 +226,22 @@ new_action_rule(ActionType action)
 }
 
 Rule *
-new_substitution_rule(const char *match, const char *repl, RegexFlags flags)
+new_substitution_rule(RemarkScript *script, const char *match, const char *repl, RegexFlags flags, char **error)
 {
-	SubstitutionRule *rule = new_rule(RULE_SUBSTITUTION, sizeof(SubstitutionRule));
-	int init_flags = REG_EXTENDED;
-	int rc;
+	SubstitutionRule *rule;
+	Regex *regex;
+	char *msg;
 
-	memset(&rule->regex, 0, sizeof(regex_t));
-	rule->replacement = xstrdup(repl);
-	rule->flags = flags;
-	if (flags & REGEX_IGNORE_CASE)
-		init_flags |= REG_ICASE;
-
-	rc = regcomp(&rule->regex, match, init_flags);
-	if (rc != 0) {
-		char *msg = xregerror(rc, &rule->regex);
-		regfree(&rule->regex);
-		warn("cannot compile regex: %s", msg);
+	regex = new_regex(script, match, flags, &msg);
+	if (regex == NULL) {
+		*error = xasprintf(_("cannot compile regex `%s': %s"), match, msg);
 		free(msg);
-		exit(1);
+		return NULL;
 	}
+	rule = new_rule(RULE_SUBSTITUTION, sizeof(SubstitutionRule));
+	rule->regex = regex;
+	rule->replacement = xstrdup(repl);
+	rule->flags = flags;
 
 	return (Rule *) rule;
 }
@@ -240,3 +255,181 @@ new_set_rule(const char *replacement)
 
 	return (Rule *) rule;
 }
+
+Rule *
+new_condition_rule(Condition *condition, Rule *subrule)
+{
+	ConditionRule *rule = new_rule(RULE_CONDITION, sizeof(ConditionRule));
+	rule->condition = condition;
+	rule->rule = subrule;
+	return (Rule *) rule;
+}
+
+Rule *
+new_state_rule(uint64_t mask, Rule *subrule)
+{
+	StateRule *rule = new_rule(RULE_STATE, sizeof(StateRule));
+	rule->mask = mask;
+	rule->rule = subrule;
+	return (Rule *) rule;
+}
+
+Rule *
+new_state_change_rule(uint64_t mask, bool enter)
+{
+	StateChangeRule *rule = new_rule(RULE_STATE_CHANGE, sizeof(StateChangeRule));
+	rule->mask = mask;
+	rule->enter = enter;
+	return (Rule *) rule;
+}
+
+/* When the key is a plain subexpression reference such as "$1" or
+ * "${1}", key_index is set so that the key need not be expanded.
+ */
+Rule *
+new_list_rule(ListOp op, uint32_t list, const char *key, Rule *subrule)
+{
+	ListRule *rule = new_rule(RULE_LIST, sizeof(ListRule));
+	const char *digits = key + 1;
+	uint32_t len;
+	uint32_t c;
+
+	rule->op = op;
+	rule->list = list;
+	rule->key = xstrdup(key);
+	rule->rule = subrule;
+	rule->key_index = -1;
+
+	if (key[0] == '$') {
+		len = strlen(digits);
+		if (digits[0] == '{' && len > 2 && digits[len-1] == '}') {
+			digits++;
+			len -= 2;
+		}
+		if (len > 0 && len < 10 && strspn(digits, "0123456789") == len) {
+			rule->key_index = 0;
+			for (c = 0; c < len; c++)
+				rule->key_index = rule->key_index*10 + (digits[c] - '0');
+		}
+	}
+
+	return (Rule *) rule;
+}
+
+Condition *
+new_compare_condition(uint32_t index, CompareOp op, double value)
+{
+	Condition *condition = xmalloc(sizeof(Condition));
+	condition->type = CONDITION_COMPARE;
+	condition->left = NULL;
+	condition->right = NULL;
+	condition->index = index;
+	condition->op = op;
+	condition->value = value;
+	return condition;
+}
+
+/* For CONDITION_NOT, right is NULL. */
+Condition *
+new_logic_condition(ConditionType type, Condition *left, Condition *right)
+{
+	Condition *condition = xmalloc(sizeof(Condition));
+	condition->type = type;
+	condition->left = left;
+	condition->right = right;
+	return condition;
+}
+
+void
+free_condition(Condition *condition)
+{
+	if (condition != NULL) {
+		free_condition(condition->left);
+		free_condition(condition->right);
+		free(condition);
+	}
+}
+
+static bool
+check_condition(Condition *condition, uint32_t subc, uint32_t *index)
+{
+	if (condition == NULL)
+		return true;
+	if (condition->type == CONDITION_COMPARE) {
+		if (subc != 0 && condition->index >= subc) {
+			*index = condition->index;
+			return false;
+		}
+		return true;
+	}
+	return check_condition(condition->left, subc, index)
+		&& check_condition(condition->right, subc, index);
+}
+
+/* Check that the subexpressions a rule refers to by index exist in
+ * the match it runs under, so that such errors are found when the
+ * script is read rather than on some line of input. subc counts the
+ * whole match too, or is 0 if it is not known until matching. Macros
+ * and includes are checked where they are used. On errors, index is
+ * set to the first index out of range.
+ */
+bool
+check_subexpressions(Rule *anyrule, uint32_t subc, uint32_t *index)
+{
+	int c;
+	int d;
+
+	if (anyrule == NULL) {
+		return true;
+	}
+	else if (anyrule->type == RULE_MATCH) {
+		MatchRule *rule = (MatchRule *) anyrule;
+		for (c = 0; c < rule->match_count; c++) {
+			Match *match = rule->matches[c];
+			if (match->type == MATCH_SUBEX) {
+				SubexMatch *submatch = (SubexMatch *) match;
+				if (subc != 0 && submatch->index >= subc) {
+					*index = submatch->index;
+					return false;
+				}
+			}
+			/* Matches with the same count need only be checked once. */
+			for (d = 0; d < c; d++) {
+				if (match_subexpressions(rule->matches[d]) == match_subexpressions(match))
+					break;
+			}
+			if (d == c && !check_subexpressions(rule->rule, match_subexpressions(match), index))
+				return false;
+		}
+	}
+	else if (anyrule->type == RULE_MACRO) {
+		MacroRule *rule = (MacroRule *) anyrule;
+		return check_subexpressions(rule->macro->rule, subc, index);
+	}
+	else if (anyrule->type == RULE_MULTI) {
+		MultiRule *rule = (MultiRule *) anyrule;
+		for (c = 0; c < rule->rule_count; c++) {
+			if (!check_subexpressions(rule->rules[c], subc, index))
+				return false;
+		}
+	}
+	else if (anyrule->type == RULE_CONDITION) {
+		ConditionRule *rule = (ConditionRule *) anyrule;
+		return check_condition(rule->condition, subc, index)
+			&& check_subexpressions(rule->rule, subc, index);
+	}
+	else if (anyrule->type == RULE_STATE) {
+		StateRule *rule = (StateRule *) anyrule;
+		return check_subexpressions(rule->rule, subc, index);
+	}
+	else if (anyrule->type == RULE_LIST) {
+		ListRule *rule = (ListRule *) anyrule;
+		if (subc != 0 && rule->key_index >= 0 && (uint32_t) rule->key_index >= subc) {
+			*index = rule->key_index;
+			return false;
+		}
+		return check_subexpressions(rule->rule, subc, index);
+	}
+
+	return true;
+}
@@ -0,0 +1,251 @@
+/* run.c - Running commands on a pseudo-terminal.
+ *
+ * Copyright (C) 2001-2005 Oskar Liljeblad
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <config.h>
+#include <stdlib.h>		/* C89 */
+#include <string.h>		/* C89 */
+#include <errno.h>		/* C89 */
+#include <signal.h>		/* C89 */
+#include <stdio.h>		/* C89 */
+#include <sys/types.h>		/* POSIX */
+#include <sys/wait.h>		/* POSIX */
+#include <sys/ioctl.h>		/* POSIX */
+#include <fcntl.h>		/* POSIX */
+#include <termios.h>		/* POSIX */
+#include <unistd.h>		/* POSIX */
+#include "dirname.h"		/* Gnulib */
+#include "getline.h"		/* Gnulib */
+#include "gettext.h"		/* Gnulib */
+#define _(String) gettext(String)
+#include "common/error.h"
+#include "common/string-utils.h"
+#include "remark.h"
+
+/* Name of the file in rule directories that maps commands to rules. */
+#define INDEX_FILE	"index"
+
+static pid_t child_pid = -1;
+static int master_fd = -1;
+
+/* Look up a command in the index file of a rule directory. */
+static char *
+lookup_index(const char *dir, const char *command)
+{
+	char *name = cat_files(dir, INDEX_FILE);
+	char *rules = NULL;
+	size_t linesize = 0;
+	char *line = NULL;
+	FILE *fh;
+
+	fh = fopen(name, "r");
+	free(name);
+	if (fh == NULL)
+		return NULL;
+
+	while (rules == NULL && getline(&line, &linesize, fh) != -1) {
+		char *key = line + strspn(line, " \t");
+		char *value;
+		size_t len;
+
+		if (*key == '#')
+			continue;
+		len = strcspn(key, " \t\n");
+		value = key + len;
+		value += strspn(value, " \t");
+		if (len == 0 || strlen(command) != len || memcmp(key, command, len) != 0)
+			continue;
+		value[strcspn(value, " \t\n")] = '\0';
+		if (*value != '\0')
+			rules = cat_files(dir, value);
+	}
+
+	free(line);
+	fclose(fh);
+	return rules;
+}
+
+/**
+ * Find the rule file to use for a command, according to the index
+ * file in the rule directory of the user, or else in the system-wide
+ * rule directory. Each line of an index names a command and then a
+ * rule file, relative to the directory of the index.
+ *
+ * @return
+ *   Newly allocated file name, or NULL if the command has no rules.
+ */
+char *
+command_rule_file(const char *command)
+{
+	const char *name = base_name(command);
+	char *rules = NULL;
+
+	if (getenv("HOME") != NULL) {
+		char *dir = cat_files(getenv("HOME"), PKGUSERDIR);
+		rules = lookup_index(dir, name);
+		free(dir);
+	}
+	if (rules == NULL)
+		rules = lookup_index(PKGDATADIR, name);
+	return rules;
+}
+
+/* Signals that a user sends with kill(1) are passed on to the command.
+ * Those from the terminal, such as SIGINT on Ctrl-C, reach the command
+ * anyway, since it stays in the same process group. Either way, remark
+ * keeps highlighting until the command closes its output.
+ */
+static void
+forward_signal(int signal, siginfo_t *info, void *context)
+{
+	if (info == NULL || info->si_code == SI_USER || info->si_code == SI_QUEUE)
+		kill(child_pid, signal);
+}
+
+static void
+resize_terminal(int signal)
+{
+	struct winsize ws;
+
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0)
+		ioctl(master_fd, TIOCSWINSZ, &ws);
+}
+
+/* Create the terminal that the command will write to. Output
+ * processing is turned off so that newlines are not turned into CR LF.
+ * Without pseudo-terminals, a pipe is used, and the command will most
+ * likely buffer its output.
+ */
+static void
+open_terminal(int *slave_fd)
+{
+#ifdef HAVE_POSIX_OPENPT
+	master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master_fd >= 0) {
+		char *name;
+
+		if (grantpt(master_fd) == 0 && unlockpt(master_fd) == 0
+		    && (name = ptsname(master_fd)) != NULL
+		    && (*slave_fd = open(name, O_RDWR | O_NOCTTY)) >= 0) {
+			struct termios tio;
+
+			if (tcgetattr(*slave_fd, &tio) == 0) {
+				tio.c_oflag &= ~OPOST;
+				tcsetattr(*slave_fd, TCSANOW, &tio);
+			}
+			resize_terminal(SIGWINCH);
+			return;
+		}
+		close(master_fd);
+	}
+#endif
+	{
+		int fds[2];
+
+		if (pipe(fds) < 0)
+			die_errno(_("cannot create pipe"));
+		master_fd = fds[0];
+		*slave_fd = fds[1];
+	}
+}
+
+/**
+ * Run a command with its standard out and standard error connected to
+ * a pseudo-terminal, so that it does not buffer its output the way it
+ * would writing to a pipe. The lines it writes are passed to handler
+ * as they arrive, and partial lines to partial_handler as with
+ * stream_fd.
+ *
+ * @return
+ *   Exit status of the command as returned by waitpid.
+ */
+int
+run_command(char **args, int timeout, FollowHandler handler, FollowHandler partial_handler, void *userdata)
+{
+	struct sigaction action;
+	struct sigaction old_actions[4];
+	static const int forwarded[4] = { SIGINT, SIGQUIT, SIGTERM, SIGHUP };
+	int slave_fd;
+	int status;
+	int c;
+
+	open_terminal(&slave_fd);
+
+	child_pid = fork();
+	if (child_pid < 0)
+		die_errno(_("cannot create process"));
+	if (child_pid == 0) {
+		close(master_fd);
+		if (dup2(slave_fd, STDOUT_FILENO) < 0 || dup2(slave_fd, STDERR_FILENO) < 0)
+			die_errno(_("cannot duplicate file descriptor"));
+		if (slave_fd > STDERR_FILENO)
+			close(slave_fd);
+		execvp(args[0], args);
+		warn_errno(_("cannot run `%s'"), args[0]);
+		_exit(errno == ENOENT ? 127 : 126);
+	}
+	close(slave_fd);
+
+	memset(&action, 0, sizeof(struct sigaction));
+	action.sa_sigaction = forward_signal;
+	action.sa_flags = SA_SIGINFO | SA_RESTART;
+	for (c = 0; c < 4; c++)
+		sigaction(forwarded[c], &action, &old_actions[c]);
+	memset(&action, 0, sizeof(struct sigaction));
+	action.sa_handler = resize_terminal;
+	action.sa_flags = SA_RESTART;
+	sigaction(SIGWINCH, &action, NULL);
+
+	stream_fd(master_fd, args[0], timeout, handler, partial_handler, userdata);
+	close(master_fd);
+
+	while (waitpid(child_pid, &status, 0) < 0) {
+		if (errno != EINTR)
+			die_errno(_("cannot wait for `%s'"), args[0]);
+	}
+
+	signal(SIGWINCH, SIG_DFL);
+	for (c = 0; c < 4; c++)
+		sigaction(forwarded[c], &old_actions[c], NULL);
+	child_pid = -1;
+	master_fd = -1;
+	return status;
+}
+
+/**
+ * Exit the way a command did according to its exit status. If it was
+ * terminated by SIGINT, SIGTERM or SIGHUP, the same signal is raised,
+ * so that a shell running remark sees that too.
+ */
+void
+exit_like(int status)
+{
+	if (WIFSIGNALED(status)) {
+		int signal = WTERMSIG(status);
+		if (signal == SIGINT || signal == SIGTERM || signal == SIGHUP) {
+			struct sigaction action;
+
+			memset(&action, 0, sizeof(struct sigaction));
+			action.sa_handler = SIG_DFL;
+			sigaction(signal, &action, NULL);
+			raise(signal);
+		}
+		exit(128 + signal);
+	}
+	exit(WIFEXITED(status) ? WEXITSTATUS(status) : 1);
+}
@@ -82,6 +82,9 @@ new_style(const char *name, LList *spec)
 			strbuf_prepend(postbuf, add_style->post_string);
 		}
 	}
+	iterator_free(it);
+	llist_iterate(spec, (IteratorFunc) free);
+	llist_free(spec);
 
 	style->pre_string = strbuf_free_to_string(prebuf);
 	style->post_string = strbuf_free_to_string(postbuf);
@@ -0,0 +1,26 @@
+# Resume following with --state: lines written before remark was
+# stopped are not repeated, and a partial line is read again in whole.
+rules="$1"
+dir=`mktemp -d`
+trap 'rm -rf "$dir"' EXIT
+log="$dir/log"
+
+# Follow until COUNT lines have been written, or 20 seconds have passed.
+follow() {
+  $REMARK --follow --state="$dir/state" -n 10 "$rules" "$log" >"$dir/out" &
+  pid=$!
+  for i in `seq 1 100`; do
+    [ `wc -l <"$dir/out"` -ge $1 ] && break
+    sleep 0.2
+  done
+  kill -TERM $pid
+  wait $pid
+  cat "$dir/out"
+}
+
+printf 'first error\nnothing\nsecond err' >"$log"
+follow 2
+echo "-- state: `cut -d' ' -f3 "$dir/state"`"
+printf 'or\nthird error\n' >>"$log"
+follow 2
+echo "-- state: `cut -d' ' -f3 "$dir/state"`"
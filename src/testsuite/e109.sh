@@ -0,0 +1,35 @@
+# Follow a file that is appended to, truncated in place (copytruncate)
+# and rotated, then check that following standard in leaves it blocking.
+rules="$1"
+dir=`mktemp -d`
+trap 'rm -rf "$dir"' EXIT
+log="$dir/log"
+
+: >"$log"
+# Wait until COUNT lines have been written, or 20 seconds have passed.
+wait_lines() {
+  for i in `seq 1 100`; do
+    [ `wc -l <"$dir/out"` -ge $1 ] && break
+    sleep 0.2
+  done
+}
+
+$REMARK --follow -n 10 "$rules" "$log" >"$dir/out" &
+pid=$!
+printf 'appended error\nmore\n' >>"$log"
+wait_lines 2
+: >"$log"
+printf 'truncated\n' >>"$log"
+wait_lines 3
+mv "$log" "$log.1"
+printf 'rotated error\n' >"$log"
+wait_lines 4
+kill $pid
+wait $pid 2>/dev/null
+cat "$dir/out"
+
+printf 'piped error\n' | {
+  $REMARK --source=-,tag=stdin: "$rules"
+  flags=`awk '/^flags/ { print $2 }' /proc/self/fdinfo/0 2>/dev/null`
+  echo "nonblocking: $(( 0${flags:-0} & 04000 ))"
+}
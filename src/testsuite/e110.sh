@@ -0,0 +1,11 @@
+# Restore more different escape sequences than are remembered at a time.
+rules="$1"
+dir=`mktemp -d`
+trap 'rm -rf "$dir"' EXIT
+
+for i in `seq 1 600`; do
+  printf 'plain \033[%dmfile\033[0m\n' $i
+done >"$dir/in"
+$REMARK --escapes=restore "$rules" <"$dir/in" >"$dir/out"
+sed 's/file/FILE/' "$dir/in" | cmp - "$dir/out" && echo same
+tail -n 1 "$dir/out" | cat -v
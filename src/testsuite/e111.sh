@@ -0,0 +1,12 @@
+# A -- before the rule file ends the options, and one after it starts a
+# command, which may have a -- of its own.
+rules="$1"
+dir=`mktemp -d`
+trap 'rm -rf "$dir"' EXIT
+case "$REMARK" in /*) ;; */*) REMARK="`pwd`/$REMARK" ;; esac
+cp "$rules" "$dir/-rules"
+
+(cd "$dir" && $REMARK -w 80 -- -rules "an error")
+(cd "$dir" && $REMARK -- -rules -- echo -- "command error")
+$REMARK -w 80 "$rules" -- echo "-- error"
+$REMARK -- -- echo "no rules error"
@@ -0,0 +1,16 @@
+# With the default engines in a UTF-8 locale, `.', bracket expressions,
+# word operators and case folding match whole characters, since such
+# expressions are run by the C library on lines with non-ASCII
+# characters. On lines of only ASCII they are run by gnulib, which
+# keeps to the step limit.
+rules="$1"
+locale=
+for l in C.UTF-8 C.utf8 en_US.UTF-8 en_US.utf8; do
+  if [ "`LC_ALL=$l locale charmap 2>/dev/null`" = "UTF-8" ]; then
+    locale="$l"
+    break
+  fi
+done
+[ -z "$locale" ] && exit 77
+
+LC_ALL="$locale" $REMARK --statistics "$rules"
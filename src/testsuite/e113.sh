@@ -0,0 +1,41 @@
+# Serve two clients from a daemon, each with rule files relative to its
+# own directory and options of its own, and reload a rule file once it
+# has been modified. The daemon wraps at 12 columns, which clients that
+# highlight the input themselves would not do. A client that connects
+# and sends nothing must not keep the others waiting, and a client that
+# gives regex options highlights the input itself.
+rules="$1"
+case "$REMARK" in /*) ;; */*) REMARK="`pwd`/$REMARK" ;; esac
+dir=`mktemp -d`
+mkdir "$dir/a" "$dir/b"
+cp "$rules" "$dir/a/rules"
+sed 's/error/warning/' "$rules" >"$dir/b/rules"
+sock="$dir/socket"
+
+$REMARK --daemon="$sock" -w 12 &
+pid=$!
+trap 'kill $pid; rm -rf "$dir"' EXIT
+for i in `seq 1 100`; do
+  [ -S "$sock" ] && break
+  sleep 0.2
+done
+
+if perl -MIO::Socket::UNIX -e 1 2>/dev/null; then
+  perl -MIO::Socket::UNIX -e '$s = IO::Socket::UNIX->new(Peer => $ARGV[0]) or exit 1;
+    open(F, ">", $ARGV[1]) and close(F); sleep 60' "$sock" "$dir/silent" &
+  silent=$!
+  for i in `seq 1 100`; do
+    [ -f "$dir/silent" ] && break
+    sleep 0.2
+  done
+fi
+
+(cd "$dir/a" && echo "an error and a warning" | timeout 30 $REMARK --socket="$sock" rules)
+[ -n "$silent" ] && kill $silent
+(cd "$dir/b" && echo "an error and a warning" | $REMARK --socket="$sock" --prepend=+ -- rules)
+(cd "$dir/a" && echo "an error again" | $REMARK --socket="$sock" -w 40 rules)
+(cd "$dir/a" && echo "an error and a warning" | $REMARK --socket="$sock" --bytes rules)
+
+sed 's/error/again/' "$rules" >"$dir/a/rules"
+touch -d @`expr \`date +%s\` + 5` "$dir/a/rules"
+(cd "$dir/a" && echo "an error again" | $REMARK --socket="$sock" -w 40 rules)
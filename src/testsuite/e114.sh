@@ -0,0 +1,22 @@
+# Pass input through cacheline between pipes, where it is spliced, and
+# between files, where it is copied. Both must give the input without
+# its last newline, if it has one.
+dir=`mktemp -d`
+trap 'rm -rf "$dir"' EXIT
+
+seq 1 30000 >"$dir/blocks"
+printf 'first\nsecond\nno newline' >"$dir/partial"
+printf 'blank\n\n\n' >"$dir/blank"
+printf '\n' >"$dir/newline"
+
+for name in blocks partial blank newline; do
+  f="$dir/$name"
+  if [ -z "`tail -c 1 "$f"`" ]; then
+    head -c -1 "$f" >"$dir/expected"
+  else
+    cat "$f" >"$dir/expected"
+  fi
+  cat "$f" | $CACHELINE | cat >"$dir/spliced"
+  $CACHELINE <"$f" >"$dir/copied"
+  cmp "$dir/expected" "$dir/spliced" && cmp "$dir/expected" "$dir/copied" && echo "$name: same"
+done
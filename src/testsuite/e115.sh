@@ -0,0 +1,18 @@
+# Highlight lines with the library from two contexts that share one
+# script, and check that broken rule files give error messages without
+# ending the program. Subexpression indexes out of range are broken
+# too, also when in a macro used under a match with fewer of them, and
+# so is a block for a state that is never entered.
+rules="$1"
+dir=`mktemp -d`
+trap 'rm -rf "$dir"' EXIT
+case "$REMARK" in /*) ;; */*) REMARK="`pwd`/$REMARK" ;; esac
+test=`dirname "$REMARK"`/libremark-test
+cp "$rules" "$dir/rules"
+printf 'style red { pre "[" post "]" }\n/x/ { red }\n/y/ { blue }\n' >"$dir/broken"
+printf 'style red { pre "[" post "]" }\nmacro second { 2 red }\n/(a)(b)/ second\n/(a)/ second\n' >"$dir/macro"
+printf '/(a)/ { add seen $2 }\n' >"$dir/key"
+printf 'style red { pre "[" post "]" }\n/([0-9]+)/ { 1 > 1 red }\n1 < 2 red\n' >"$dir/compare"
+printf '/^at/ enter trace\n/^$/ leave trace\ntrcae { /x/ skip }\n' >"$dir/state"
+
+(cd "$dir" && $test rules broken macro key compare state)
@@ -0,0 +1,17 @@
+# Follow two sources that share one script, and check that a value
+# added to a list from the first source is not seen by the second.
+rules="$1"
+dir=`mktemp -d`
+trap 'rm -rf "$dir"' EXIT
+
+printf 'err 7\npid 7\n' >"$dir/a"
+printf 'pid 7\n' >"$dir/b"
+$REMARK --follow --lines=10 --source="$dir/a,tag=a:" --source="$dir/b,tag=b:" "$rules" >"$dir/out" &
+pid=$!
+for i in `seq 1 100`; do
+  [ `wc -l <"$dir/out"` -ge 3 ] && break
+  sleep 0.2
+done
+kill $pid
+wait $pid 2>/dev/null
+cat "$dir/out"
@@ -0,0 +1,16 @@
+# Highlight the input, and then 100 times as many lines of the same
+# kind. Once buffers have grown to fit the lines, matching allocates
+# no more, so both must make the same number of allocations.
+rules="$1"
+dir=`mktemp -d`
+trap 'rm -rf "$dir"' EXIT
+
+cat >"$dir/small"
+seq 0 3999 | awk '{
+  if ($1 % 2) print "line " $1 " word" $1 " other more"
+  else print "x" $1 " {\"k\": \"v" $1 "\"}"
+}' >"$dir/large"
+$REMARK --regex-engine=gnulib --statistics "$rules" <"$dir/small" 2>"$dir/small.stats"
+$REMARK --regex-engine=gnulib --statistics "$rules" <"$dir/large" 2>"$dir/large.stats" >/dev/null
+cat "$dir/small.stats"
+cmp "$dir/small.stats" "$dir/large.stats" && echo "same allocations for 4000 lines"
@@ -0,0 +1,398 @@
+/* token.c - Built-in token scanners.
+ *
+ * Copyright (C) 2001-2005 Oskar Liljeblad
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <config.h>
+#include <stdint.h>		/* Gnulib/C99/POSIX */
+#include <string.h>		/* C89 */
+#include "common/string-utils.h"
+#include "remark.h"
+
+#define IS_DIGIT(c)	((c) >= '0' && (c) <= '9')
+#define IS_HEX(c)	(IS_DIGIT(c) || ((c) >= 'a' && (c) <= 'f') || ((c) >= 'A' && (c) <= 'F'))
+#define IS_ALPHA(c)	(((c) >= 'a' && (c) <= 'z') || ((c) >= 'A' && (c) <= 'Z'))
+#define IS_WORD(c)	(IS_DIGIT(c) || IS_ALPHA(c) || (c) == '_' || (c) >= 0x80)
+
+typedef uint32_t (*TokenScanner)(const unsigned char *buf, uint32_t pos, uint32_t eo, SubmatchSpec *subv);
+
+/* A scanner is only called at positions holding a byte in the range
+ * first_lo to first_hi, which lets token_search skip over the rest
+ * of the line a word at a time. The scanner returns the length of
+ * the token at pos, or 0 if there is none.
+ */
+struct _Token {
+	char *name;
+	uint32_t nsub;
+	unsigned char first_lo;
+	unsigned char first_hi;
+	TokenScanner scan;
+};
+
+static uint32_t scan_int(const unsigned char *buf, uint32_t pos, uint32_t eo, SubmatchSpec *subv);
+static uint32_t scan_float(const unsigned char *buf, uint32_t pos, uint32_t eo, SubmatchSpec *subv);
+static uint32_t scan_hex(const unsigned char *buf, uint32_t pos, uint32_t eo, SubmatchSpec *subv);
+static uint32_t scan_uuid(const unsigned char *buf, uint32_t pos, uint32_t eo, SubmatchSpec *subv);
+static uint32_t scan_ipv4(const unsigned char *buf, uint32_t pos, uint32_t eo, SubmatchSpec *subv);
+static uint32_t scan_ipv6(const unsigned char *buf, uint32_t pos, uint32_t eo, SubmatchSpec *subv);
+static uint32_t scan_time(const unsigned char *buf, uint32_t pos, uint32_t eo, SubmatchSpec *subv);
+static uint32_t scan_syslogtime(const unsigned char *buf, uint32_t pos, uint32_t eo, SubmatchSpec *subv);
+
+static Token tokens[] = {
+	{ "int",		0, '+', '9', scan_int },
+	{ "float",		0, '+', '9', scan_float },
+	{ "hex",		1, '0', 'f', scan_hex },
+	{ "uuid",		0, '0', 'f', scan_uuid },
+	{ "ipv4",		4, '0', '9', scan_ipv4 },
+	{ "ipv6",		0, '0', 'f', scan_ipv6 },
+	{ "time",		3, '0', '9', scan_time },
+	{ "syslogtime",	2, 'A', 'S', scan_syslogtime },
+};
+
+static const char *months[] = {
+	"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+	"Jul", "Aug", "Sep", "Oct", "Nov", "Dec",
+};
+
+const Token *
+identify_token(const char *name)
+{
+	int c;
+
+	for (c = 0; c < sizeof(tokens)/sizeof(Token); c++) {
+		if (strcmp(name, tokens[c].name) == 0)
+			return &tokens[c];
+	}
+
+	return NULL;
+}
+
+uint32_t
+token_subexpressions(const Token *token)
+{
+	return token->nsub;
+}
+
+/* A token must not be glued to a word or to a number it could be
+ * part of, so "1.2.3" is neither a float nor contains an int, and
+ * "abc123" contains no int.
+ */
+static bool
+left_bound(const unsigned char *buf, uint32_t bo, uint32_t pos)
+{
+	if (pos == bo)
+		return true;
+	if (IS_WORD(buf[pos-1]))
+		return false;
+	if (buf[pos-1] == '.' && pos-1 > bo && IS_DIGIT(buf[pos-2]))
+		return false;
+	return true;
+}
+
+static bool
+right_bound(const unsigned char *buf, uint32_t pos, uint32_t eo)
+{
+	if (pos == eo)
+		return true;
+	if (IS_WORD(buf[pos]))
+		return false;
+	if (buf[pos] == '.' && pos+1 < eo && IS_DIGIT(buf[pos+1]))
+		return false;
+	return true;
+}
+
+/* Search for the leftmost token in buf between so and eo. bo is
+ * the start of the enclosing match, before which the text is not
+ * looked at. On success subv[0] holds the token, and subv[1] and
+ * on hold the subexpressions of the token (-1 if unmatched).
+ */
+bool
+token_search(const Token *token, const char *text, uint32_t bo, uint32_t so, uint32_t eo, SubmatchSpec *subv)
+{
+	const unsigned char *buf = (const unsigned char *) text;
+	uint32_t pos;
+
+	for (pos = so; pos < eo; pos++) {
+		const unsigned char *p;
+		uint32_t c;
+		uint32_t len;
+
+		p = memrange(buf+pos, eo-pos, token->first_lo, token->first_hi);
+		if (p == NULL)
+			return false;
+		pos = p - buf;
+		if (!left_bound(buf, bo, pos))
+			continue;
+
+		for (c = 1; c <= token->nsub; c++) {
+			subv[c].so = -1;
+			subv[c].eo = -1;
+		}
+		len = token->scan(buf, pos, eo, subv);
+		if (len != 0 && right_bound(buf, pos+len, eo)) {
+			subv[0].so = pos;
+			subv[0].eo = pos+len;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static uint32_t
+skip_digits(const unsigned char *buf, uint32_t pos, uint32_t eo)
+{
+	while (pos < eo && IS_DIGIT(buf[pos]))
+		pos++;
+	return pos;
+}
+
+static uint32_t
+skip_sign(const unsigned char *buf, uint32_t pos, uint32_t eo)
+{
+	if (pos < eo && (buf[pos] == '-' || buf[pos] == '+'))
+		pos++;
+	return pos;
+}
+
+static uint32_t
+scan_int(const unsigned char *buf, uint32_t pos, uint32_t eo, SubmatchSpec *subv)
+{
+	uint32_t p = skip_sign(buf, pos, eo);
+	uint32_t end = skip_digits(buf, p, eo);
+
+	return (end == p ? 0 : end - pos);
+}
+
+static uint32_t
+scan_float(const unsigned char *buf, uint32_t pos, uint32_t eo, SubmatchSpec *subv)
+{
+	uint32_t p = skip_sign(buf, pos, eo);
+	uint32_t end = skip_digits(buf, p, eo);
+	bool fraction = false;
+
+	if (end == p)
+		return 0;
+	if (end+1 < eo && buf[end] == '.' && IS_DIGIT(buf[end+1])) {
+		end = skip_digits(buf, end+1, eo);
+		fraction = true;
+	}
+	if (end < eo && (buf[end] == 'e' || buf[end] == 'E')) {
+		p = skip_sign(buf, end+1, eo);
+		if (p < eo && IS_DIGIT(buf[p]))
+			return skip_digits(buf, p, eo) - pos;
+	}
+
+	return (fraction ? end - pos : 0);
+}
+
+/* Without a 0x prefix, a hex number must contain both decimal digits
+ * and letters, or ordinary words and integers would match.
+ */
+static uint32_t
+scan_hex(const unsigned char *buf, uint32_t pos, uint32_t eo, SubmatchSpec *subv)
+{
+	bool digit = false;
+	bool letter = false;
+	uint32_t p = pos;
+
+	if (p+2 < eo && buf[p] == '0' && (buf[p+1] == 'x' || buf[p+1] == 'X') && IS_HEX(buf[p+2])) {
+		p += 2;
+		digit = letter = true;
+	}
+	subv[1].so = p;
+	for (; p < eo && IS_HEX(buf[p]); p++) {
+		if (IS_DIGIT(buf[p]))
+			digit = true;
+		else
+			letter = true;
+	}
+	subv[1].eo = p;
+
+	return (digit && letter ? p - pos : 0);
+}
+
+static uint32_t
+scan_uuid(const unsigned char *buf, uint32_t pos, uint32_t eo, SubmatchSpec *subv)
+{
+	static const char layout[] = "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx";
+	uint32_t c;
+
+	if (eo - pos < sizeof(layout)-1)
+		return 0;
+	for (c = 0; c < sizeof(layout)-1; c++) {
+		if (layout[c] == '-' ? buf[pos+c] != '-' : !IS_HEX(buf[pos+c]))
+			return 0;
+	}
+
+	return sizeof(layout)-1;
+}
+
+static uint32_t
+scan_octet(const unsigned char *buf, uint32_t pos, uint32_t eo)
+{
+	uint32_t value = 0;
+	uint32_t p;
+
+	for (p = pos; p < eo && p-pos < 3 && IS_DIGIT(buf[p]); p++)
+		value = value*10 + (buf[p]-'0');
+	if (p == pos || value > 255 || (p < eo && IS_DIGIT(buf[p])))
+		return 0;
+
+	return p - pos;
+}
+
+static uint32_t
+scan_ipv4(const unsigned char *buf, uint32_t pos, uint32_t eo, SubmatchSpec *subv)
+{
+	uint32_t p = pos;
+	uint32_t c;
+
+	for (c = 1; c <= 4; c++) {
+		uint32_t len;
+
+		if (c > 1) {
+			if (p >= eo || buf[p] != '.')
+				return 0;
+			p++;
+		}
+		len = scan_octet(buf, p, eo);
+		if (len == 0)
+			return 0;
+		subv[c].so = p;
+		subv[c].eo = p + len;
+		p += len;
+	}
+
+	return p - pos;
+}
+
+/* Groups of one to four hex digits separated by colons, with at most
+ * one "::" and optionally ending in a dotted IPv4 address.
+ */
+static uint32_t
+scan_ipv6(const unsigned char *buf, uint32_t pos, uint32_t eo, SubmatchSpec *subv)
+{
+	SubmatchSpec ipv4_subv[5];
+	bool compressed = false;
+	uint32_t groups = 0;
+	uint32_t p = pos;
+
+	if (p+1 < eo && buf[p] == ':' && buf[p+1] == ':') {
+		compressed = true;
+		p += 2;
+	}
+	while (p < eo && IS_HEX(buf[p])) {
+		uint32_t len;
+
+		len = scan_ipv4(buf, p, eo, ipv4_subv);
+		if (len != 0) {
+			groups += 2;
+			p += len;
+			break;
+		}
+		for (len = 0; p+len < eo && IS_HEX(buf[p+len]); len++);
+		if (len > 4)
+			return 0;
+		groups++;
+		p += len;
+
+		if (p+1 < eo && buf[p] == ':' && buf[p+1] == ':' && !compressed) {
+			compressed = true;
+			p += 2;
+		} else if (p+1 < eo && buf[p] == ':' && IS_HEX(buf[p+1])) {
+			p++;
+		} else {
+			break;
+		}
+	}
+
+	if (groups == 0 || (compressed ? groups > 7 : groups != 8))
+		return 0;
+	if (p < eo && buf[p] == ':')
+		return 0;
+
+	return p - pos;
+}
+
+static uint32_t
+scan_time(const unsigned char *buf, uint32_t pos, uint32_t eo, SubmatchSpec *subv)
+{
+	uint32_t p = pos;
+	uint32_t c;
+
+	for (c = 1; c <= 3; c++) {
+		if (c > 1) {
+			if (p >= eo || buf[p] != ':')
+				return 0;
+			p++;
+		}
+		if (p+2 > eo || !IS_DIGIT(buf[p]) || !IS_DIGIT(buf[p+1]))
+			return 0;
+		subv[c].so = p;
+		subv[c].eo = p+2;
+		p += 2;
+	}
+	if (p+1 < eo && buf[p] == '.' && IS_DIGIT(buf[p+1])) {
+		p = skip_digits(buf, p+1, eo);
+		subv[3].eo = p;
+	}
+
+	return p - pos;
+}
+
+/* "Mmm dd hh:mm:ss" as written by syslog, where the day of month is
+ * padded with a space rather than a zero.
+ */
+static uint32_t
+scan_syslogtime(const unsigned char *buf, uint32_t pos, uint32_t eo, SubmatchSpec *subv)
+{
+	SubmatchSpec time_subv[4];
+	uint32_t p = pos;
+	uint32_t len;
+	int c;
+
+	if (eo - pos < 15)
+		return 0;
+	for (c = 0; c < sizeof(months)/sizeof(*months); c++) {
+		if (memcmp(buf+p, months[c], 3) == 0)
+			break;
+	}
+	if (c == sizeof(months)/sizeof(*months) || buf[p+3] != ' ')
+		return 0;
+	p += 4;
+	if (buf[p] == ' ')
+		p++;
+	if (!IS_DIGIT(buf[p]))
+		return 0;
+	p++;
+	if (IS_DIGIT(buf[p]))
+		p++;
+	subv[1].so = pos;
+	subv[1].eo = p;
+
+	if (p >= eo || buf[p] != ' ')
+		return 0;
+	p++;
+	len = scan_time(buf, p, eo, time_subv);
+	if (len == 0)
+		return 0;
+	subv[2].so = p;
+	subv[2].eo = p + len;
+
+	return p + len - pos;
+}
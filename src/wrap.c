@@ -19,6 +19,7 @@
 
 #include <config.h>
 #include <stdint.h>		/* Gnulib/C99/POSIX */
+#include <stdlib.h>		/* C89 */
 #include <string.h>		/* C89 */
 #include "minmax.h"		/* Gnulib */
 #include "common/error.h"
@@ -39,32 +40,28 @@ static Wrapper wrappers[] = {
 	{ 'w', "word", WRAPPER_WORD },
 };
 
-uint32_t wrap_width = UINT32_MAX;
-uint32_t wrap_retain = 0;
-WrapperType wrapper = WRAPPER_NONE;
-static char *wrapper_args;
-
+/**
+ * Find a wrapping type by its name or the first letter of its name.
+ * Anything after a colon in spec is ignored.
+ *
+ * @return
+ *   false if there is no such wrapping type.
+ */
 bool
-identify_wrapper(const char *spec)
+identify_wrapper(const char *spec, WrapperType *type)
 {
+	const char *args;
 	int c;
 	int len;
 
-	wrapper_args = strchr(spec, ':');
-	if (wrapper_args == NULL) {
-		len = strlen(spec);
-	} else {
-		len = wrapper_args - spec;
-		wrapper_args++;
-	}
+	args = strchr(spec, ':');
+	len = (args == NULL ? strlen(spec) : args - spec);
 
 	for (c = 0; c < sizeof(wrappers)/sizeof(Wrapper); c++) {
 		if ((len == 1 && spec[0] == wrappers[c].short_name)
 				|| (len == strlen(wrappers[c].long_name)
 				&& strncmp(spec, wrappers[c].long_name, len) == 0)) {
-			wrapper = wrappers[c].type;
-			if (wrapper != WRAPPER_NONE && wrap_width == UINT32_MAX)
-				wrap_width = 80;
+			*type = wrappers[c].type;
 			return true;
 		}
 	}
@@ -81,10 +78,11 @@ wrap_line(RemarkScript *script, RemarkInput *input)
 	char *appstr = strbuf_buffer(input->append_mb.buffer);
 	int32_t style_mod = 0;
 	uint32_t retainlen = 0;
+	uint32_t retaincols = 0;
 	uint32_t len = input->mb.bufferlen;
-	uint32_t applen = input->append_mb.bufferlen; /* XXX: strbuf_length? */
-	uint32_t prelen = input->prepend_mb.bufferlen; /* XXX: strbuf_length? */
-	uint32_t width = wrap_width;
+	uint32_t appcols = input->append_cols;
+	uint32_t precols = input->prepend_cols;
+	uint32_t width = input->wrap_width;
 	uint32_t sp;
 
 	if (len == 0) {
@@ -94,14 +92,17 @@ wrap_line(RemarkScript *script, RemarkInput *input)
 	}
 
 	/* Prepare retain. */
-	if (wrap_retain != 0) {
+	if (input->wrap_retain != 0) {
+		char *buf = strbuf_buffer(input->mb.buffer);
+		uint32_t rlen = display_span(buf, len, input->wrap_retain);
 		MatchBuffer rmb;
 
-		rmb.buffer = strbuf_new_from_substring(strbuf_buffer(input->mb.buffer), 0, wrap_retain);
-		rmb.bufferlen = wrap_retain;
+		retaincols = display_width(buf, rlen);
+		rmb.buffer = strbuf_new_from_substring(buf, 0, rlen);
+		rmb.bufferlen = rlen;
 		rmb.styles = input->mb.styles;
 		rmb.styles_it = input->mb.styles_it;
-		apply_styles(&rmb, wrap_retain);
+		apply_styles(&rmb, rlen);
 
 		retainbuf = strbuf_free_to_string(rmb.buffer);
 		retainlen = strlen(retainbuf);
@@ -116,20 +117,24 @@ wrap_line(RemarkScript *script, RemarkInput *input)
 		uint32_t ep;
 		int32_t keep = 0;
 
-		/* Calculate new end position (ep) and delete if necessary */
-		ep = MIN(len, sp+width);
+		/* Calculate new end position (ep) and delete if necessary.
+		 * Positions are in bytes but widths are in columns.
+		 */
+		ep = sp + display_span(strbuf_buffer(input->mb.buffer)+sp, len-sp, width);
 		if (ep != len)
-			ep -= applen;
-		if (wrapper != WRAPPER_NONE && ep < len) {
+			ep = sp + display_span(strbuf_buffer(input->mb.buffer)+sp, len-sp, width-appcols);
+		if (input->wrapper != WRAPPER_NONE && ep < len) {
 			if (strbuf_char_at(input->mb.buffer, ep) != ' ') {
-				if (wrapper == WRAPPER_WORD) {
-					uint32_t nextwidth = (sp == 0 ? width-prelen : width);
+				if (input->wrapper == WRAPPER_WORD) {
+					uint32_t nextwidth = (sp == 0 ? width-precols : width);
 					uint32_t t;
 					for (t = ep-1; t > sp && strbuf_char_at(input->mb.buffer, t) != ' '; t--);
 					if (t > sp) {
 						uint32_t u;
+						uint32_t cols;
 						for (u = ep+1; u < len && strbuf_char_at(input->mb.buffer, u) != ' '; u++);
-						if (u-t-1 <= nextwidth-applen || (u-t-1 <= nextwidth && u == len))
+						cols = display_width(strbuf_buffer(input->mb.buffer)+t+1, u-t-1);
+						if (cols <= nextwidth-appcols || (cols <= nextwidth && u == len))
 							ep = t+1;
 					}
 				}
@@ -198,7 +203,7 @@ wrap_line(RemarkScript *script, RemarkInput *input)
 		}
 
 		/* Insert append. */
-		if (ep < len && applen > 0) {
+		if (ep < len && appstr[0] != '\0') {
 			strbuf_insert(input->mb.buffer, ep, appstr);
 			ep += strlen(appstr);
 			len += strlen(appstr);
@@ -217,10 +222,12 @@ wrap_line(RemarkScript *script, RemarkInput *input)
 
 		style_mod += 1-deleted;
 		if (sp == 0)
-			width -= wrap_retain + prelen;
+			width -= retaincols + precols;
 
 		sp = ep;
 	}
+
+	free(retainbuf);
 }
 
 void